@@ -7,6 +7,7 @@
 #include <fstream>
 #include <algorithm>
 #include <cstdint>
+#include <cstring>
 
 namespace fsaverage
 {
@@ -22,9 +23,10 @@ struct BigEndianHelper
 
         void operator() (float& num) const noexcept
         {
-            int tmp = *reinterpret_cast<int*>(&num);
+            int tmp{};
+            std::memcpy(&tmp, &num, sizeof(int));
             this->operator()(tmp);
-            num = *reinterpret_cast<float*>(&tmp);
+            std::memcpy(&num, &tmp, sizeof(int));
         }
 
         void operator() (short& num) const noexcept
@@ -33,6 +35,24 @@ struct BigEndianHelper
         }
     };
 
+    // Instruction set picked at runtime for the bulk kernels below.
+    enum class SimdLevel
+    {
+        Scalar,
+        SSSE3,
+        AVX2,
+    };
+
+    static SimdLevel simdLevel() noexcept;
+
+    // Bulk in-place byte swap, vectorized when the CPU supports it.
+    static void reverseEndian(int* data, std::size_t count) noexcept;
+    static void reverseEndian(float* data, std::size_t count) noexcept;
+    static void reverseEndian(short* data, std::size_t count) noexcept;
+
+    // Decode count big-endian 24-bit integers from source (count * 3 bytes) to destination.
+    static void unpack3Bytes(const unsigned char* source, int* destination, std::size_t count) noexcept;
+
     template<typename T, typename U = void>
     struct CouldReverseEndian : std::false_type {};
 
@@ -50,20 +70,19 @@ struct BigEndianHelper
         return static_cast<bool>(judge.c[3]);
     };
 
+    // Stream reads keep their bytes on the stack, the stream position is the only shared state; concurrent
+    // decoding should go through BinaryReader instead. The bytes are big-endian on disk whatever the host
+    // order is, as in read3BytesMany.
     static int read3Bytes(std::ifstream& input) noexcept
     {
-        static unsigned char buffer[3] = {0};
+        unsigned char buffer[3] = {0};
         input.read(reinterpret_cast<char*>(buffer), 3);
-        if (!isBigEndian())
-        {
-            return (static_cast<int>(buffer[0]) << 16) + (static_cast<int>(buffer[1]) << 8) + static_cast<int>(buffer[2]);
-        }
-        return (static_cast<int>(buffer[2]) << 16) + (static_cast<int>(buffer[1]) << 8) + static_cast<int>(buffer[0]);
+        return (static_cast<int>(buffer[0]) << 16) | (static_cast<int>(buffer[1]) << 8) | static_cast<int>(buffer[2]);
     }
 
     static int read4Bytes(std::ifstream& input) noexcept
     {
-        static int buffer = 0;
+        int buffer = 0;
         input.read(reinterpret_cast<char*>(&buffer), 4);
         if (!isBigEndian())
         {
@@ -77,22 +96,7 @@ struct BigEndianHelper
         std::vector<int> ret(count);
         std::vector<unsigned char> buffer(count * 3);
         input.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
-        if (!isBigEndian())
-        {
-            for (std::size_t i = 0; i < ret.size(); ++i)
-            {
-                ret[i] = (static_cast<int>(buffer[3 * i]) << 16);
-                ret[i] += (static_cast<int>(buffer[3 * i + 1]) << 8) + static_cast<int>(buffer[3 * i + 2]);
-            }
-        }
-        else
-        {
-            for (std::size_t i = 0; i < ret.size(); ++i)
-            {
-                ret[i] = static_cast<int>(buffer[3 * i]);
-                ret[i] += (static_cast<int>(buffer[3 * i + 1]) << 8) + static_cast<int>(buffer[3 * i + 2] << 16);
-            }
-        }
+        unpack3Bytes(buffer.data(), ret.data(), count);
         return ret;
     }
 
@@ -104,7 +108,7 @@ struct BigEndianHelper
         input.read(reinterpret_cast<char*>(ret.data()), ret.size() * sizeof(T));
         if (!isBigEndian())
         {
-            std::for_each(ret.begin(), ret.end(), ReverseEndian());
+            reverseEndian(ret.data(), ret.size());
         }
         return ret;
     }
@@ -1,9 +1,17 @@
 // Author: cute-giggle@outlook.com
 
+#ifndef ANNOTATION_HPP
+#define ANNOTATION_HPP
+
 #include <vector>
 #include <string>
+#include <unordered_map>
 #include <filesystem>
 
+#include "mapped_file.h"
+#include "container.h"
+#include "label_codec.h"
+
 namespace fsaverage
 {
 
@@ -29,4 +37,46 @@ struct Annotation
     static Annotation load(const std::filesystem::path& path) noexcept;
 };
 
-}
\ No newline at end of file
+// Zero-copy, read-only counterpart of Annotation: labelIndex points straight into the mapped file pages.
+// The color table is small and is always decoded.
+struct AnnotationView
+{
+    MappedFile file;
+    ContainerReader container;  // empty for legacy files
+    std::vector<ColorTableItem> colorTable;
+    Span<const uint32_t> labelIndex;
+    CompressedLabels labels;    // empty unless the file stores compressed labels
+
+    bool empty() const noexcept
+    {
+        return colorTable.empty() || (labelIndex.empty() && labels.empty());
+    }
+
+    // Used when the label array is not 4-byte aligned inside a legacy file, or for decoded compressed labels.
+    std::vector<uint32_t> storage;
+
+    // Compressed labels are decoded to labelIndex unless decodeLabels is false; holding many atlases at once
+    // then costs only the compressed size, with random access through labels.
+    static AnnotationView open(const std::filesystem::path& path, bool decodeLabels = true) noexcept;
+};
+
+// Atlas name of an annotation data file, used to name the outputs derived from it: annotation.aparc.data -> aparc.
+std::string atlasName(const std::filesystem::path& path) noexcept;
+
+// Display names of regions by annotation name, e.g. Caudal anterior cingulate for caudalanteriorcingulate, so
+// that relation outputs name regions like the [atlas]_region_names.txt files and the existing relation triples.
+struct RegionNames
+{
+    std::unordered_map<std::string, std::string> display;
+
+    // The display name, or the annotation name itself when none is known.
+    const std::string& lookup(const std::string& name) const noexcept;
+
+    // Add the members of a JSON object of annotation name to display name, the layout of
+    // [atlas]_region_names_mapping.json.
+    bool load(const std::filesystem::path& path) noexcept;
+};
+
+}
+
+#endif
\ No newline at end of file
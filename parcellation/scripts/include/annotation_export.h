@@ -0,0 +1,27 @@
+// Author: cute-giggle@outlook.com
+
+#ifndef ANNOTATIONEXPORT_HPP
+#define ANNOTATIONEXPORT_HPP
+
+#include <filesystem>
+
+#include "annotation.h"
+
+namespace fsaverage
+{
+// Exports of an annotation for Python consumers. All of them hold the document of the *.annot.json files,
+// {"color_table": [[[R, G, B, A], name], ...], "label": [color table index per vertex]}.
+
+// JSON, compact with indent == 0, the layout of json.dump(..., indent=indent) otherwise.
+bool exportAnnotationJson(const std::filesystem::path& path, const Annotation& annotation, int indent = 0) noexcept;
+
+// CBOR (RFC 8949), which cbor2.load turns into the same dict json.load returns for the JSON export, at
+// about one byte per vertex and without number parsing.
+bool exportAnnotationCbor(const std::filesystem::path& path, const Annotation& annotation) noexcept;
+
+// The label array alone as a uint32 .npy file, for numpy.load(path, mmap_mode='r').
+bool exportLabelNpy(const std::filesystem::path& path, const Annotation& annotation) noexcept;
+
+}
+
+#endif
\ No newline at end of file
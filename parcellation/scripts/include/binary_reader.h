@@ -0,0 +1,137 @@
+// Author: cute-giggle@outlook.com
+
+#ifndef BINARYREADER_HPP
+#define BINARYREADER_HPP
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+#include "mapped_file.h"
+
+namespace fsaverage
+{
+
+// Big-endian reads at explicit offsets from a read-only byte range, usually the pages of a MappedFile.
+// The reader has no position and no buffers, every call only reads the range, so any number of threads can
+// decode different sections of one file at the same time. Reads out of range return false and leave the
+// destination untouched.
+class BinaryReader
+{
+public:
+    BinaryReader() noexcept = default;
+    BinaryReader(const unsigned char* data, std::size_t size) noexcept : address(data), length(size)
+    {
+    }
+    explicit BinaryReader(const MappedFile& file) noexcept : address(file.data()), length(file.size())
+    {
+    }
+
+    std::size_t size() const noexcept
+    {
+        return length;
+    }
+
+    bool contains(std::size_t offset, std::size_t count) const noexcept
+    {
+        return offset <= length && count <= length - offset;
+    }
+
+    // Raw bytes at [offset, offset + count), or nullptr when out of range.
+    const unsigned char* bytes(std::size_t offset, std::size_t count) const noexcept
+    {
+        return contains(offset, count) ? address + offset : nullptr;
+    }
+
+    static uint32_t load4Bytes(const unsigned char* data) noexcept
+    {
+        return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16)
+             | (static_cast<uint32_t>(data[2]) << 8) | static_cast<uint32_t>(data[3]);
+    }
+
+    static int load3Bytes(const unsigned char* data) noexcept
+    {
+        return (static_cast<int>(data[0]) << 16) | (static_cast<int>(data[1]) << 8) | static_cast<int>(data[2]);
+    }
+
+    bool read3Bytes(std::size_t offset, int& value) const noexcept;
+    bool read4Bytes(std::size_t offset, int& value) const noexcept;
+
+    // Decode count big-endian elements at offset into destination, byte swapped by the bulk kernels of BigEndianHelper.
+    bool readSequence(std::size_t offset, int* destination, std::size_t count) const noexcept;
+    bool readSequence(std::size_t offset, float* destination, std::size_t count) const noexcept;
+    bool readSequence(std::size_t offset, short* destination, std::size_t count) const noexcept;
+    bool read3BytesMany(std::size_t offset, int* destination, std::size_t count) const noexcept;
+
+    bool readString(std::size_t offset, std::size_t count, std::string& value) const noexcept;
+
+    // Offset just past the next '\n' at or after offset, or size() when there is none.
+    std::size_t skipLine(std::size_t offset) const noexcept;
+
+private:
+    const unsigned char* address{};
+    std::size_t length{};
+};
+
+// Sequential reads over a BinaryReader for headers and tables. The position lives in the cursor, so each
+// thread walks its own section with its own cursor. A failed read sets valid to false and every later read
+// yields zero, so a truncated file is checked once after the last field.
+class BinaryCursor
+{
+public:
+    BinaryCursor(const BinaryReader& reader, std::size_t offset = 0U) noexcept : reader(reader), position(offset)
+    {
+    }
+
+    std::size_t offset() const noexcept
+    {
+        return position;
+    }
+
+    bool valid() const noexcept
+    {
+        return good;
+    }
+
+    const unsigned char* take(std::size_t count) noexcept
+    {
+        auto* data = good ? reader.bytes(position, count) : nullptr;
+        good = data != nullptr;
+        position += good ? count : 0U;
+        return data;
+    }
+
+    int read3Bytes() noexcept
+    {
+        auto* data = take(3U);
+        return data == nullptr ? 0 : BinaryReader::load3Bytes(data);
+    }
+
+    int read4Bytes() noexcept
+    {
+        auto* data = take(4U);
+        return data == nullptr ? 0 : static_cast<int>(BinaryReader::load4Bytes(data));
+    }
+
+    std::string readString(std::size_t count) noexcept
+    {
+        auto* data = take(count);
+        return data == nullptr ? std::string() : std::string(reinterpret_cast<const char*>(data), count);
+    }
+
+    void skipLine() noexcept
+    {
+        std::size_t next = reader.skipLine(position);
+        good = good && next > position;
+        position = good ? next : position;
+    }
+
+private:
+    const BinaryReader& reader;
+    std::size_t position;
+    bool good{true};
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,155 @@
+// Author: cute-giggle@outlook.com
+
+#ifndef CONTAINER_HPP
+#define CONTAINER_HPP
+
+#include <vector>
+#include <filesystem>
+#include <cstdint>
+
+#include "mapped_file.h"
+
+namespace fsaverage
+{
+// Versioned binary container used by surface.*.data, annotation.*.data and triple stores.
+//
+// layout: [ContainerHeader][SectionEntry * sectionCount][padding][section 0][padding][section 1]...
+// Every section starts at a multiple of CONTAINER_ALIGNMENT, so readers can use any section in place
+// after validating the header and the section table once.
+
+constexpr char CONTAINER_MAGIC[8] = {'F', 'S', 'A', 'V', 'D', 'A', 'T', 'A'};
+constexpr uint32_t CONTAINER_VERSION = 1U;
+constexpr uint32_t CONTAINER_ENDIAN_MARKER = 0x01020304U;
+constexpr std::size_t CONTAINER_ALIGNMENT = 64U;
+
+enum class SectionId : uint32_t
+{
+    Point = 1U,             // float, x y z per vertex
+    Face = 2U,              // int, three vertex indices per triangle
+    ColorTable = 3U,        // ColorRecord per label
+    NamePool = 4U,          // char, label names referenced by ColorRecord
+    LabelIndex = 5U,        // uint32_t, color table index per vertex
+    RegionOffset = 6U,      // uint32_t, region count + 1 offsets into RegionVertex
+    RegionVertex = 7U,      // uint32_t, vertex ids grouped by region, ascending inside each region
+    VertexArea = 8U,        // float, one third of the area of the faces around each vertex
+    LabelCodec = 9U,        // LabelCodecHeader, encoding of the compressed labels replacing LabelIndex
+    PackedLabel = 10U,      // uint64_t, bit-packed color table index per vertex
+    LabelRun = 11U,         // LabelRun, run-length encoded color table index per vertex
+    NeighborOffset = 12U,   // uint32_t, vertex count + 1 offsets into Neighbor
+    Neighbor = 13U,         // uint32_t, adjacent vertices grouped by vertex, ascending inside each vertex
+    HalfEdgeTwin = 14U,     // uint32_t, opposite half-edge of every face corner, 0xFFFFFFFF on the boundary
+    VertexHalfEdge = 15U,   // uint32_t, one outgoing half-edge per vertex
+    VertexBvhNode = 16U,    // BvhNode, hierarchy over the vertices, root first
+    VertexBvhItem = 17U,    // uint32_t, vertex ids in leaf order
+    FaceBvhNode = 18U,      // BvhNode, hierarchy over the faces, root first
+    FaceBvhItem = 19U,      // uint32_t, face ids in leaf order
+    TermOffset = 20U,       // uint32_t, term count + 1 offsets into TermPool
+    TermPool = 21U,         // char, entity and relation names of a triple store in byte order
+    TripleSpo = 22U,        // Triple, sorted by subject, relation, object
+    TriplePos = 23U,        // Triple, sorted by relation, object, subject
+    TripleOsp = 24U,        // Triple, sorted by object, subject, relation
+    LevelRecord = 25U,      // SurfaceLevelRecord per decimated level, fine to coarse
+    LevelPoint = 26U,       // float, x y z per vertex of every level
+    LevelFace = 27U,        // int, three vertex indices per triangle of every level, local to the level
+    LevelLabel = 28U,       // uint32_t, majority color table index per vertex of every level
+    LevelParent = 29U,      // uint32_t, per level and full resolution vertex, the level vertex it was collapsed into
+};
+
+struct ContainerHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t endianMarker;
+    uint32_t sectionCount;
+    uint32_t reserved;
+    uint64_t fileSize;
+};
+static_assert(sizeof(ContainerHeader) == 32U);
+
+struct SectionEntry
+{
+    uint32_t id;
+    uint32_t elementSize;
+    uint64_t offset;
+    uint64_t count;
+};
+static_assert(sizeof(SectionEntry) == 24U);
+
+struct ColorRecord
+{
+    int32_t R;
+    int32_t G;
+    int32_t B;
+    int32_t A;
+    uint32_t nameOffset;
+    uint32_t nameLength;
+};
+static_assert(sizeof(ColorRecord) == 24U);
+
+// Collects sections in memory order and writes them out in one go. The data is not copied, so it must
+// stay alive until save() returns.
+class ContainerWriter
+{
+public:
+    template<typename T>
+    void addSection(SectionId id, const std::vector<T>& data) noexcept
+    {
+        addSection(id, data.data(), sizeof(T), data.size());
+    }
+
+    void addSection(SectionId id, const void* data, std::size_t elementSize, std::size_t count) noexcept;
+
+    bool save(const std::filesystem::path& path) const noexcept;
+
+private:
+    struct PendingSection
+    {
+        SectionId id;
+        const void* data;
+        std::size_t elementSize;
+        std::size_t count;
+    };
+
+    std::vector<PendingSection> sections;
+};
+
+// Validated, read-only access to the sections of a container held in memory (usually a MappedFile).
+struct ContainerReader
+{
+    const unsigned char* data{};
+    std::size_t size{};
+    Span<const SectionEntry> sections;
+
+    bool empty() const noexcept
+    {
+        return data == nullptr;
+    }
+
+    bool has(SectionId id) const noexcept
+    {
+        return find(id) != nullptr;
+    }
+
+    // Return the section as a typed span, or an empty span when it is missing or has another element size.
+    template<typename T>
+    Span<const T> section(SectionId id) const noexcept
+    {
+        const SectionEntry* entry = find(id);
+        if (entry == nullptr || entry->elementSize != sizeof(T))
+        {
+            return {};
+        }
+        return {reinterpret_cast<const T*>(data + entry->offset), static_cast<std::size_t>(entry->count)};
+    }
+
+    const SectionEntry* find(SectionId id) const noexcept;
+
+    // True when the bytes start with CONTAINER_MAGIC; legacy .data files do not.
+    static bool isContainer(const unsigned char* data, std::size_t size) noexcept;
+
+    static ContainerReader parse(const unsigned char* data, std::size_t size) noexcept;
+};
+
+}
+
+#endif
\ No newline at end of file
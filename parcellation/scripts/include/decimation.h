@@ -0,0 +1,92 @@
+// Author: cute-giggle@outlook.com
+
+#ifndef DECIMATION_HPP
+#define DECIMATION_HPP
+
+#include <vector>
+#include <string>
+#include <filesystem>
+
+#include "surface.h"
+#include "container.h"
+
+namespace fsaverage
+{
+// Levels of detail of a surface, made by quadric error edge collapse, with the labels of an annotation
+// carried to every level.
+
+// Vertex count of the icosahedral fsaverage[order] surfaces for one hemisphere, e.g. 10242 for fsaverage5.
+constexpr std::size_t icosahedronVertexCount(std::size_t order) noexcept
+{
+    return (std::size_t{10U} << (2U * order)) + 2U;
+}
+
+struct SurfaceLevel
+{
+    std::vector<float> point;
+    std::vector<int> face;
+    std::vector<uint32_t> labelIndex;   // majority label of the full resolution vertices of each vertex, empty without labels
+    std::vector<uint32_t> parent;       // per full resolution vertex, the vertex of this level it was collapsed into
+};
+
+// Collapse edges in order of the Garland-Heckbert quadric error, placing every merged vertex at the point
+// that minimizes it, until the mesh has at most each of vertexCounts vertices (descending). One collapse
+// sequence yields all levels, so every level is a coarsening of the previous one. Connected components (the
+// two hemispheres of a merged surface) are decimated in parallel, each to its share of the vertices, and
+// keep their order. Collapses that would break the manifold or flip a face are skipped, so a level can keep
+// more vertices than asked. Labels go to every level by majority vote over the full resolution vertices
+// collapsed into each vertex, ties to the smaller label.
+std::vector<SurfaceLevel> decimateSurface(Span<const float> point, Span<const int> face, const std::vector<std::size_t>& vertexCounts,
+    Span<const uint32_t> labelIndex = {}) noexcept;
+
+struct SurfaceLevelRecord
+{
+    uint64_t pointOffset;   // first float of the level in LevelPoint
+    uint64_t vertexCount;
+    uint64_t faceOffset;    // first int of the level in LevelFace
+    uint64_t faceCount;
+};
+static_assert(sizeof(SurfaceLevelRecord) == 32U);
+
+// Read-only view of a level of detail file. Level 0 is the full resolution surface, then the decimated
+// levels from fine to coarse; labelIndex is empty when the file has no labels, parent is empty for level 0.
+struct SurfaceLevelView
+{
+    Span<const float> point;
+    Span<const int> face;
+    Span<const uint32_t> labelIndex;
+    Span<const uint32_t> parent;
+
+    std::size_t vertexCount() const noexcept
+    {
+        return point.size() / 3U;
+    }
+};
+
+struct SurfaceLevels
+{
+    MappedFile file;
+    ContainerReader container;
+    std::vector<SurfaceLevelView> level;
+
+    bool empty() const noexcept
+    {
+        return level.empty();
+    }
+
+    // The coarsest level with at least vertexCount vertices, level 0 when none is that coarse.
+    const SurfaceLevelView& coarsest(std::size_t vertexCount) const noexcept;
+
+    static SurfaceLevels open(const std::filesystem::path& path) noexcept;
+};
+
+// Write the full resolution surface, its labels (may be empty) and the decimated levels to one container.
+bool save(const std::filesystem::path& path, Span<const float> point, Span<const int> face, Span<const uint32_t> labelIndex,
+    const std::vector<SurfaceLevel>& levels) noexcept;
+
+// surface.white.data -> surface.white.lod.data
+std::string surfaceLevelsFileName(const std::filesystem::path& path) noexcept;
+
+}
+
+#endif
\ No newline at end of file
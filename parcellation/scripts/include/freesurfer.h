@@ -0,0 +1,43 @@
+// Author: cute-giggle@outlook.com
+
+#ifndef FREESURFER_HPP
+#define FREESURFER_HPP
+
+#include <string>
+#include <filesystem>
+
+#include "surface.h"
+#include "annotation.h"
+
+namespace fsaverage
+{
+// Conversion from FreeSurfer lh/rh file pairs to the merged surface.*.data and annotation.*.data files.
+
+// Load [lh/rh].[orig/white/pial/inflated/sphere/sphere.reg] and merge them, the left hemisphere ends at x = 0 and the right one starts there.
+// Spheres keep their coordinates, so both hemispheres stay centred on the origin.
+Surface loadFreeSurferSurface(const std::filesystem::path& lpath, const std::filesystem::path& rpath) noexcept;
+
+// Load [lh/rh].xxx.annot and merge them into one color table that only holds labels in use.
+Annotation loadFreeSurferAnnotation(const std::filesystem::path& lpath, const std::filesystem::path& rpath) noexcept;
+
+void showSurfaceInformation(const Surface& surface) noexcept;
+
+void showAnnotationInformation(const Annotation& annotation) noexcept;
+
+// index also stores the vertex areas, the topology and the spatial index; together they take several times the
+// point and face data, and VertexArea, MeshTopology and SpatialIndex build them on load when they are missing.
+bool save(const std::filesystem::path& path, const Surface& surface, bool index = false) noexcept;
+
+// regionIndex also stores the RegionOffset/RegionVertex sections; they cost 4 bytes per vertex, several times the
+// compressed labels, and RegionIndex::load rebuilds them in one pass when they are missing.
+bool save(const std::filesystem::path& path, const Annotation& annotation, bool regionIndex = false) noexcept;
+
+// Output file name for a left hemisphere input, e.g. lh.white -> surface.white.data, lh.sphere.reg -> surface.sphere.reg.data.
+std::string surfaceDataFileName(const std::filesystem::path& lpath) noexcept;
+
+// Output file name for a left hemisphere input, e.g. lh.aparc.annot -> annotation.aparc.data.
+std::string annotationDataFileName(const std::filesystem::path& lpath) noexcept;
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,52 @@
+// Author: cute-giggle@outlook.com
+
+#ifndef GEODESIC_HPP
+#define GEODESIC_HPP
+
+#include <vector>
+#include <thread>
+#include <limits>
+
+#include "mesh_topology.h"
+#include "region_index.h"
+
+namespace fsaverage
+{
+// Geodesic distances along the edges of a surface mesh. Paths follow mesh edges, so distances slightly
+// overestimate the true surface geodesic; on the regular fsaverage meshes the error is a few percent.
+
+// Euclidean length of every adjacency entry of topology, parallel to topology.neighbor.
+std::vector<float> computeEdgeLength(Span<const float> point, const MeshTopology& topology) noexcept;
+
+// Multi-source Dijkstra over a bucketed priority queue: the distance from the nearest source to every vertex,
+// infinity where unreachable. The search stops expanding beyond maxDistance.
+std::vector<float> computeGeodesicDistance(const MeshTopology& topology, Span<const float> edgeLength,
+    Span<const uint32_t> sources, float maxDistance = std::numeric_limits<float>::infinity()) noexcept;
+
+// Shortest geodesic distance between every pair of regions.
+struct RegionDistance
+{
+    std::size_t regionCount{};
+    std::vector<float> distance;    // regionCount * regionCount, row = source region, infinity when unreachable
+
+    bool empty() const noexcept
+    {
+        return distance.empty();
+    }
+
+    float at(uint32_t from, uint32_t to) const noexcept
+    {
+        return distance[from * regionCount + to];
+    }
+};
+
+// One multi-source search per region, seeded with all of its vertices, run as tasks of a work-stealing
+// thread pool. Regions with a false entry in source are neither searched from nor reported. The searches
+// stop at maxDistance, so a finite bound makes "near" queries much cheaper than the full matrix.
+RegionDistance computeRegionDistance(const MeshTopology& topology, Span<const float> edgeLength, const RegionIndex& regions,
+    Span<const uint32_t> labelIndex, const std::vector<bool>& source, float maxDistance = std::numeric_limits<float>::infinity(),
+    std::size_t threadCount = std::thread::hardware_concurrency()) noexcept;
+
+}
+
+#endif
\ No newline at end of file
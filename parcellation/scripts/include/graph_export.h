@@ -0,0 +1,24 @@
+// Author: cute-giggle@outlook.com
+
+#ifndef GRAPHEXPORT_HPP
+#define GRAPHEXPORT_HPP
+
+#include <filesystem>
+
+#include "triple_store.h"
+
+namespace fsaverage
+{
+
+constexpr const char* NEO4J_ENTITY_FILE = "entities.csv";
+constexpr const char* NEO4J_RELATION_FILE = "relations.csv";
+
+// Write the store as [directory]/entities.csv and [directory]/relations.csv for `neo4j-admin database import`,
+// giving the graph insert_relation_triples.py builds with MERGE: one :Entity {name} node per subject or object
+// and one :RELATION {name} relationship per distinct triple. Rows are formatted in parallel blocks, one
+// window at a time, while the previous window is being written.
+bool exportNeo4jImport(const TripleStore& store, const std::filesystem::path& directory) noexcept;
+
+}
+
+#endif
\ No newline at end of file
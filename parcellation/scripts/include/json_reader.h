@@ -0,0 +1,66 @@
+// Author: cute-giggle@outlook.com
+
+#ifndef JSONREADER_HPP
+#define JSONREADER_HPP
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <filesystem>
+#include <cstdint>
+
+namespace fsaverage
+{
+
+// Parsed JSON document. Objects keep their members in file order, like the dicts json.load returns.
+struct JsonValue
+{
+    enum class Type : uint8_t
+    {
+        Invalid,    // result of a failed parse
+        Null,
+        Boolean,
+        Number,
+        String,
+        Array,
+        Object,
+    };
+
+    Type type{Type::Invalid};
+    bool boolean{};
+    double number{};
+    std::string text;
+    std::vector<JsonValue> item;        // array elements, or object member values
+    std::vector<std::string> name;      // object member names, parallel to item
+
+    bool empty() const noexcept
+    {
+        return type == Type::Invalid;
+    }
+
+    bool isString() const noexcept
+    {
+        return type == Type::String;
+    }
+
+    bool isArray() const noexcept
+    {
+        return type == Type::Array;
+    }
+
+    bool isObject() const noexcept
+    {
+        return type == Type::Object;
+    }
+
+    // Value of the first member with the given name, nullptr when absent or when this is not an object.
+    const JsonValue* find(std::string_view key) const noexcept;
+
+    static JsonValue parse(std::string_view text) noexcept;
+
+    static JsonValue load(const std::filesystem::path& path) noexcept;
+};
+
+}
+
+#endif
\ No newline at end of file
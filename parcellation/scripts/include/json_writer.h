@@ -0,0 +1,79 @@
+// Author: cute-giggle@outlook.com
+
+#ifndef JSONWRITER_HPP
+#define JSONWRITER_HPP
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <ostream>
+#include <cstdint>
+
+namespace fsaverage
+{
+
+// Streaming JSON writer. With indent > 0 the layout matches Python's json.dump(..., indent=indent), so the
+// files stay diffable against the ones produced by the scripts; with indent == 0 the output is compact.
+// Text is collected in a buffer and handed to the stream in large writes, when the buffer fills up, when
+// the top-level value is closed, on flush() and on destruction.
+class JsonWriter
+{
+public:
+    explicit JsonWriter(std::ostream& output, int indent = 4) noexcept;
+    JsonWriter(const JsonWriter&) = delete;
+    JsonWriter& operator= (const JsonWriter&) = delete;
+    ~JsonWriter() noexcept;
+
+    void beginObject() noexcept;
+    void endObject() noexcept;
+    void beginArray() noexcept;
+    void endArray() noexcept;
+
+    // Object member name, must be followed by a value or a container.
+    void key(std::string_view name) noexcept;
+
+    void value(std::string_view text) noexcept;
+    void value(const char* text) noexcept
+    {
+        value(std::string_view(text));
+    }
+    void value(double number) noexcept;
+    void value(int64_t number) noexcept;
+    void value(uint64_t number) noexcept;
+    void value(int number) noexcept
+    {
+        value(static_cast<int64_t>(number));
+    }
+    void value(uint32_t number) noexcept
+    {
+        value(static_cast<uint64_t>(number));
+    }
+
+    // Hand the buffered text to the stream.
+    void flush() noexcept;
+
+private:
+    void put(char c) noexcept
+    {
+        buffer.push_back(c);
+    }
+    void write(const char* text, std::size_t size) noexcept
+    {
+        buffer.append(text, size);
+    }
+
+    void separate() noexcept;
+    void close(char bracket) noexcept;
+    void newline() noexcept;
+    void string(std::string_view text) noexcept;
+
+    std::ostream& output;
+    std::string buffer;
+    int indent;
+    std::vector<std::size_t> count;   // items written so far in every open container
+    bool afterKey{false};
+};
+
+}
+
+#endif
\ No newline at end of file
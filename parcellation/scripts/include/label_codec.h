@@ -0,0 +1,100 @@
+// Author: cute-giggle@outlook.com
+
+#ifndef LABELCODEC_HPP
+#define LABELCODEC_HPP
+
+#include <vector>
+
+#include "mapped_file.h"
+#include "container.h"
+
+namespace fsaverage
+{
+
+enum class LabelEncoding : uint32_t
+{
+    Packed = 1U,            // bitWidth bits per vertex, PackedLabel section
+    RunLength = 2U,         // one LabelRun per run of equal labels, LabelRun section
+};
+
+struct LabelCodecHeader
+{
+    uint32_t encoding;
+    uint32_t bitWidth;      // Packed only
+    uint64_t count;         // vertex count
+};
+static_assert(sizeof(LabelCodecHeader) == 16U);
+
+struct LabelRun
+{
+    uint32_t start;         // first vertex of the run
+    uint32_t label;
+};
+static_assert(sizeof(LabelRun) == 8U);
+
+// Compressed color table indices of an annotation. An atlas needs bitWidth(regionCount - 1) bits per vertex
+// instead of 32, and labels come in long runs along the vertex order of a mesh, so encode() keeps whichever
+// of bit packing and run-length encoding is smaller. Both support random access by vertex.
+struct CompressedLabels
+{
+    LabelCodecHeader header{};
+    Span<const uint64_t> word;      // Packed: vertex i at bits [i * bitWidth, (i + 1) * bitWidth), one padding word
+    Span<const LabelRun> run;       // RunLength: ascending start, the first run starts at 0
+
+    // Owned arrays when the labels were encoded in memory, empty when they point into a mapped file.
+    std::vector<uint64_t> wordStorage;
+    std::vector<LabelRun> runStorage;
+
+    CompressedLabels() noexcept = default;
+    CompressedLabels(CompressedLabels&&) noexcept = default;
+    CompressedLabels& operator= (CompressedLabels&&) noexcept = default;
+    CompressedLabels(const CompressedLabels&) = delete;
+    CompressedLabels& operator= (const CompressedLabels&) = delete;
+
+    bool empty() const noexcept
+    {
+        return header.count == 0U;
+    }
+
+    std::size_t size() const noexcept
+    {
+        return static_cast<std::size_t>(header.count);
+    }
+
+    LabelEncoding encoding() const noexcept
+    {
+        return static_cast<LabelEncoding>(header.encoding);
+    }
+
+    // Bytes of the encoded labels, as held in memory or on disk.
+    std::size_t byteSize() const noexcept
+    {
+        return word.size() * sizeof(uint64_t) + run.size() * sizeof(LabelRun);
+    }
+
+    // O(1) for packed labels, O(log runs) for run-length encoded ones.
+    uint32_t operator[] (std::size_t vertex) const noexcept;
+
+    // Decode vertices [begin, end) to destination, with AVX2 gathers for packed labels when available.
+    void decode(std::size_t begin, std::size_t end, uint32_t* destination) const noexcept;
+
+    // Decode every vertex, split into blocks that run in parallel.
+    std::vector<uint32_t> decode() const noexcept;
+
+    // Add the LabelCodec section and the data section; the labels must outlive writer.save().
+    void addSections(ContainerWriter& writer) const noexcept;
+
+    static CompressedLabels pack(Span<const uint32_t> labelIndex, std::size_t regionCount) noexcept;
+
+    static CompressedLabels runLength(Span<const uint32_t> labelIndex) noexcept;
+
+    // The smaller of pack() and runLength().
+    static CompressedLabels encode(Span<const uint32_t> labelIndex, std::size_t regionCount) noexcept;
+
+    // Point into the sections of a container, empty when it holds no valid compressed labels.
+    static CompressedLabels load(const ContainerReader& container) noexcept;
+};
+
+}
+
+#endif
\ No newline at end of file
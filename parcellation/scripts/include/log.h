@@ -0,0 +1,100 @@
+// Author: cute-giggle@outlook.com
+
+#ifndef LOG_HPP
+#define LOG_HPP
+
+#include <string>
+#include <sstream>
+#include <optional>
+#include <cstdint>
+
+namespace fsaverage
+{
+// Process-wide leveled log. Callers format a line and queue it; a background thread writes the queue to
+// stderr, so no log call waits on the terminal and stdout stays free for tool results. The level comes
+// from the FSAVERAGE_LOG environment variable (debug, info, warning, error or off, default info).
+
+enum class LogLevel : uint8_t
+{
+    Debug,
+    Info,
+    Warning,
+    Error,
+    Off,
+};
+
+void setLogLevel(LogLevel level) noexcept;
+
+LogLevel logLevel() noexcept;
+
+inline bool logEnabled(LogLevel level) noexcept
+{
+    return level >= logLevel() && level != LogLevel::Off;
+}
+
+void logMessage(LogLevel level, std::string message) noexcept;
+
+// Block until every queued line has been written.
+void flushLog() noexcept;
+
+// One log line built with operator<<, queued when it goes out of scope. Below the current level nothing is
+// formatted and no stream is constructed.
+class LogLine
+{
+public:
+    explicit LogLine(LogLevel level) noexcept : level(level)
+    {
+        if (logEnabled(level))
+        {
+            stream.emplace();
+        }
+    }
+    LogLine(const LogLine&) = delete;
+    LogLine& operator= (const LogLine&) = delete;
+
+    ~LogLine() noexcept
+    {
+        if (stream)
+        {
+            logMessage(level, stream->str());
+        }
+    }
+
+    template<typename T>
+    LogLine& operator<< (const T& value) noexcept
+    {
+        if (stream)
+        {
+            *stream << value;
+        }
+        return *this;
+    }
+
+private:
+    LogLevel level;
+    std::optional<std::ostringstream> stream;
+};
+
+inline LogLine logDebug() noexcept
+{
+    return LogLine(LogLevel::Debug);
+}
+
+inline LogLine logInfo() noexcept
+{
+    return LogLine(LogLevel::Info);
+}
+
+inline LogLine logWarning() noexcept
+{
+    return LogLine(LogLevel::Warning);
+}
+
+inline LogLine logError() noexcept
+{
+    return LogLine(LogLevel::Error);
+}
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,106 @@
+// Author: cute-giggle@outlook.com
+
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+namespace fsaverage
+{
+
+// A non-owning view over a contiguous sequence, used to expose arrays that live in mapped file pages.
+template<typename T>
+struct Span
+{
+    T* pointer{};
+    std::size_t count{};
+
+    T* data() const noexcept
+    {
+        return pointer;
+    }
+
+    std::size_t size() const noexcept
+    {
+        return count;
+    }
+
+    bool empty() const noexcept
+    {
+        return count == 0U;
+    }
+
+    T* begin() const noexcept
+    {
+        return pointer;
+    }
+
+    T* end() const noexcept
+    {
+        return pointer + count;
+    }
+
+    T& operator[] (std::size_t i) const noexcept
+    {
+        return pointer[i];
+    }
+};
+
+// Read-only memory mapping of a whole file. Pages are shared with every other process mapping the same file.
+class MappedFile
+{
+public:
+    MappedFile() noexcept = default;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator= (MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator= (const MappedFile&) = delete;
+    ~MappedFile() noexcept;
+
+    const unsigned char* data() const noexcept
+    {
+        return address;
+    }
+
+    std::size_t size() const noexcept
+    {
+        return length;
+    }
+
+    bool empty() const noexcept
+    {
+        return address == nullptr || length == 0U;
+    }
+
+    // Return a typed span at [offset, offset + count * sizeof(T)), or an empty span when out of range or misaligned.
+    template<typename T>
+    Span<const T> span(std::size_t offset, std::size_t count) const noexcept
+    {
+        if (offset > length || count > (length - offset) / sizeof(T))
+        {
+            return {};
+        }
+        if (reinterpret_cast<std::uintptr_t>(address + offset) % alignof(T) != 0U)
+        {
+            return {};
+        }
+        return {reinterpret_cast<const T*>(address + offset), count};
+    }
+
+    static MappedFile open(const std::filesystem::path& path) noexcept;
+
+private:
+    void release() noexcept;
+
+    const unsigned char* address{};
+    std::size_t length{};
+#ifdef _WIN32
+    void* mapping{};
+#endif
+};
+
+}
+
+#endif
@@ -0,0 +1,109 @@
+// Author: cute-giggle@outlook.com
+
+#ifndef MESHTOPOLOGY_HPP
+#define MESHTOPOLOGY_HPP
+
+#include <vector>
+
+#include "surface.h"
+#include "container.h"
+
+namespace fsaverage
+{
+
+// Connectivity of a triangle mesh, derived from its faces only.
+//
+// Vertex adjacency is in CSR form: the neighbours of v are neighbor[neighborOffset[v], neighborOffset[v + 1]),
+// ascending. Half-edges are implicit in the face array: half-edge h = 3 * f + k runs from face[h] to the next
+// corner of face f, so next/prev/origin need no storage and only the twin of every half-edge and one
+// outgoing half-edge per vertex are kept.
+struct MeshTopology
+{
+    static constexpr uint32_t INVALID = 0xFFFFFFFFU;
+
+    Span<const int> face;                   // not owned, must outlive the topology
+    Span<const uint32_t> neighborOffset;    // vertex count + 1
+    Span<const uint32_t> neighbor;
+    Span<const uint32_t> twin;              // per half-edge, INVALID on boundary and non-manifold edges
+    Span<const uint32_t> vertexHalfEdge;    // per vertex, a boundary half-edge when there is one, INVALID when isolated
+
+    // Owned arrays when the topology was built in memory, empty when they point into a mapped file.
+    std::vector<uint32_t> neighborOffsetStorage;
+    std::vector<uint32_t> neighborStorage;
+    std::vector<uint32_t> twinStorage;
+    std::vector<uint32_t> vertexHalfEdgeStorage;
+
+    MeshTopology() noexcept = default;
+    MeshTopology(MeshTopology&&) noexcept = default;
+    MeshTopology& operator= (MeshTopology&&) noexcept = default;
+    MeshTopology(const MeshTopology&) = delete;
+    MeshTopology& operator= (const MeshTopology&) = delete;
+
+    bool empty() const noexcept
+    {
+        return neighborOffset.empty();
+    }
+
+    std::size_t vertexCount() const noexcept
+    {
+        return neighborOffset.empty() ? 0U : neighborOffset.size() - 1U;
+    }
+
+    std::size_t halfEdgeCount() const noexcept
+    {
+        return twin.size();
+    }
+
+    uint32_t degree(uint32_t vertex) const noexcept
+    {
+        return neighborOffset[vertex + 1U] - neighborOffset[vertex];
+    }
+
+    Span<const uint32_t> neighbors(uint32_t vertex) const noexcept
+    {
+        return {neighbor.data() + neighborOffset[vertex], degree(vertex)};
+    }
+
+    static uint32_t next(uint32_t halfEdge) noexcept
+    {
+        return halfEdge % 3U == 2U ? halfEdge - 2U : halfEdge + 1U;
+    }
+
+    static uint32_t prev(uint32_t halfEdge) noexcept
+    {
+        return halfEdge % 3U == 0U ? halfEdge + 2U : halfEdge - 1U;
+    }
+
+    static uint32_t faceOf(uint32_t halfEdge) noexcept
+    {
+        return halfEdge / 3U;
+    }
+
+    uint32_t origin(uint32_t halfEdge) const noexcept
+    {
+        return static_cast<uint32_t>(face[halfEdge]);
+    }
+
+    uint32_t target(uint32_t halfEdge) const noexcept
+    {
+        return static_cast<uint32_t>(face[next(halfEdge)]);
+    }
+
+    bool isBoundary(uint32_t halfEdge) const noexcept
+    {
+        return twin[halfEdge] == INVALID;
+    }
+
+    // One parallel radix sort of all directed edges gives both the adjacency and the twins.
+    static MeshTopology build(Span<const int> face, std::size_t vertexCount) noexcept;
+
+    // Use the topology sections of the view when present and consistent, otherwise build it.
+    static MeshTopology load(const SurfaceView& view) noexcept;
+
+    // The topology arrays must outlive writer.save().
+    void addSections(ContainerWriter& writer) const noexcept;
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,108 @@
+// Author: cute-giggle@outlook.com
+
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <chrono>
+#include <ostream>
+#include <cstddef>
+#include <cstdint>
+
+namespace fsaverage
+{
+// Process-wide time and byte counters of the conversion stages. Every loader and writer records into them,
+// recording is lock free and cheap enough for per-file use on any thread. If the FSAVERAGE_METRICS
+// environment variable names a file ("-" for stderr), the JSON report is written there at exit.
+
+enum class Stage : uint8_t
+{
+    Open,       // opening inputs and reading headers
+    Decode,     // turning file data into vertices, faces and labels
+    Swap,       // big-endian byte swapping, also counted inside decode
+    Merge,      // joining the left and right hemisphere
+    Remap,      // compacting and renumbering labels
+    Write,      // writing container files
+};
+
+constexpr std::size_t STAGE_COUNT = 6U;
+
+const char* stageName(Stage stage) noexcept;
+
+struct StageTotals
+{
+    uint64_t count;
+    uint64_t bytes;
+    uint64_t nanoseconds;
+};
+
+void recordStage(Stage stage, uint64_t bytes, std::chrono::steady_clock::duration duration) noexcept;
+
+StageTotals stageTotals(Stage stage) noexcept;
+
+// {"stages": {"open": {"count", "bytes", "seconds", "megabytesPerSecond"}, ...}}, seconds are summed over threads.
+void writeMetricsReport(std::ostream& output) noexcept;
+
+// Records the lifetime of the timer as one call of stage.
+class StageTimer
+{
+public:
+    explicit StageTimer(Stage stage, uint64_t bytes = 0U) noexcept
+        : stage(stage), bytes(bytes), start(std::chrono::steady_clock::now())
+    {
+    }
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator= (const StageTimer&) = delete;
+
+    ~StageTimer() noexcept
+    {
+        recordStage(stage, bytes, std::chrono::steady_clock::now() - start);
+    }
+
+    void addBytes(uint64_t count) noexcept
+    {
+        bytes += count;
+    }
+
+private:
+    Stage stage;
+    uint64_t bytes;
+    std::chrono::steady_clock::time_point start;
+};
+
+// Sums many short intervals of stage, one per chunk of a decode loop, and records them as one call, so the
+// shared counters are not touched inside the loop.
+class StageAccumulator
+{
+public:
+    explicit StageAccumulator(Stage stage) noexcept : stage(stage)
+    {
+    }
+    StageAccumulator(const StageAccumulator&) = delete;
+    StageAccumulator& operator= (const StageAccumulator&) = delete;
+
+    ~StageAccumulator() noexcept
+    {
+        if (bytes > 0U)
+        {
+            recordStage(stage, bytes, elapsed);
+        }
+    }
+
+    template<typename Function>
+    void measure(uint64_t byteCount, Function&& function) noexcept
+    {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        elapsed += std::chrono::steady_clock::now() - start;
+        bytes += byteCount;
+    }
+
+private:
+    Stage stage;
+    uint64_t bytes{0U};
+    std::chrono::steady_clock::duration elapsed{};
+};
+
+}
+
+#endif
\ No newline at end of file
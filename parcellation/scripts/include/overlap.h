@@ -0,0 +1,57 @@
+// Author: cute-giggle@outlook.com
+
+#ifndef OVERLAP_HPP
+#define OVERLAP_HPP
+
+#include <vector>
+#include <cstdint>
+
+#include "mapped_file.h"
+
+namespace fsaverage
+{
+// Region co-occurrence between annotations on the same surface, the source of location_relations/*.json.
+
+struct OverlapInput
+{
+    Span<const uint32_t> labelIndex;
+    std::size_t regionCount{};
+};
+
+struct RegionPairOverlap
+{
+    uint32_t first{};       // region of the first annotation
+    uint32_t second{};      // region of the second annotation
+    double size{};          // vertices (or their total weight) carrying both regions
+};
+
+struct AnnotationPairOverlap
+{
+    std::size_t first{};
+    std::size_t second{};
+    std::vector<RegionPairOverlap> entries;  // non-zero overlaps, ordered by (first, second)
+};
+
+struct OverlapResult
+{
+    std::vector<std::vector<double>> regionSize;    // per annotation, per region
+    std::vector<AnnotationPairOverlap> pairs;        // every (i, j) with i < j, in order
+};
+
+// Compute region sizes and every pairwise co-occurrence matrix in one pass over the vertices, split into
+// blocks that run in parallel with private histograms. All inputs must have the same vertex count.
+// With a per-vertex weight (e.g. VertexArea) sizes and overlaps are weighted sums instead of vertex counts.
+OverlapResult computeOverlap(const std::vector<OverlapInput>& inputs, Span<const float> weight = {}) noexcept;
+
+struct OverlapRelation
+{
+    const char* forward;    // relation of the first region to the second one
+    const char* backward;   // relation of the second region to the first one
+};
+
+// Name the relation from with1 = overlap / size of first region and with2 = overlap / size of second region.
+OverlapRelation classifyOverlap(double with1, double with2) noexcept;
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,79 @@
+// Author: cute-giggle@outlook.com
+
+#ifndef OVERLAY_HPP
+#define OVERLAY_HPP
+
+#include <vector>
+#include <filesystem>
+
+#include "mapped_file.h"
+
+namespace fsaverage
+{
+// Per-vertex scalar maps such as thickness, curvature, sulc or functional maps, read from FreeSurfer curv
+// files ([lh/rh].thickness, ...) or MGH volumes of one row per vertex (.mgh).
+
+// One mapped hemisphere file. Frames are decoded on demand from the mapped pages, so a caller can keep its
+// own buffer for a stream of overlays.
+class OverlayFile
+{
+public:
+    bool empty() const noexcept
+    {
+        return vertices == 0U;
+    }
+
+    std::size_t vertexCount() const noexcept
+    {
+        return vertices;
+    }
+
+    // 1 for curv files, the time points or contrasts of an MGH file
+    std::size_t frameCount() const noexcept
+    {
+        return frames;
+    }
+
+    // Decode one frame into destination, which must hold vertexCount() floats.
+    bool read(std::size_t frame, float* destination) const noexcept;
+
+    static OverlayFile open(const std::filesystem::path& path) noexcept;
+
+private:
+    enum class Encoding : uint8_t
+    {
+        Float,
+        Int,
+        Short,
+        UnsignedChar,
+        OldCurv,    // 2-byte fixed point in hundredths
+    };
+
+    MappedFile file;
+    Encoding encoding{Encoding::Float};
+    std::size_t vertices{};
+    std::size_t frames{};
+    std::size_t offset{};
+};
+
+// Both hemispheres of one overlay, left then right: the vertex order of loadFreeSurferSurface and
+// loadFreeSurferAnnotation.
+struct Overlay
+{
+    std::vector<float> value;
+
+    bool empty() const noexcept
+    {
+        return value.empty();
+    }
+
+    static Overlay load(const std::filesystem::path& lpath, const std::filesystem::path& rpath, std::size_t frame = 0U) noexcept;
+
+    // Decode into value, reusing its storage, so streaming many overlays of one surface allocates once.
+    static bool read(const std::filesystem::path& lpath, const std::filesystem::path& rpath, std::size_t frame,
+        std::vector<float>& value) noexcept;
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,55 @@
+// Author: cute-giggle@outlook.com
+
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <vector>
+#include <future>
+#include <thread>
+#include <algorithm>
+#include <cstddef>
+
+namespace fsaverage
+{
+
+// Run task(i) for every i in [0, count) on its own thread. The calling thread takes i == 0 and the call
+// returns when every task has finished.
+template<typename Task>
+void parallelInvoke(std::size_t count, Task&& task)
+{
+    std::vector<std::future<void>> futures;
+    futures.reserve(count);
+    for (std::size_t i = 1U; i < count; ++i)
+    {
+        futures.emplace_back(std::async(std::launch::async, [&task, i]() { task(i); }));
+    }
+    if (count > 0U)
+    {
+        task(std::size_t{0U});
+    }
+    for (auto& future : futures)
+    {
+        future.get();
+    }
+}
+
+// Number of blocks to split size items into: one per hardware thread, but no block smaller than grain.
+inline std::size_t blockCount(std::size_t size, std::size_t grain) noexcept
+{
+    std::size_t threads = std::max<std::size_t>(std::thread::hardware_concurrency(), 1U);
+    return std::max<std::size_t>(std::min(threads, size / std::max<std::size_t>(grain, 1U)), 1U);
+}
+
+// Split [0, size) into blocks contiguous ranges and run task(block, begin, end) for each in parallel.
+template<typename Task>
+void parallelBlocks(std::size_t size, std::size_t blocks, Task&& task)
+{
+    parallelInvoke(blocks, [&task, size, blocks](std::size_t block)
+    {
+        task(block, size * block / blocks, size * (block + 1U) / blocks);
+    });
+}
+
+}
+
+#endif
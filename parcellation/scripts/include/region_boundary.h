@@ -0,0 +1,36 @@
+// Author: cute-giggle@outlook.com
+
+#ifndef REGIONBOUNDARY_HPP
+#define REGIONBOUNDARY_HPP
+
+#include <vector>
+#include <cstdint>
+
+#include "mapped_file.h"
+
+namespace fsaverage
+{
+// Spatial adjacency of the regions of one annotation on its surface.
+
+struct RegionBorder
+{
+    uint32_t first{};       // smaller region index
+    uint32_t second{};      // larger region index
+    double length{};        // length of the border curve between the two regions
+};
+
+struct BoundaryResult
+{
+    std::vector<uint32_t> boundaryVertex;   // ascending, vertices with a neighbour in another region
+    std::vector<RegionBorder> borders;      // ordered by (first, second)
+};
+
+// One parallel scan over the faces. The border runs through edge midpoints: a face with two labels adds the
+// segment between the midpoints of its two mixed edges, a face with three labels adds the three segments from
+// its edge midpoints to its centroid. The work grows with the number of faces and of faces on a border only,
+// never with the number of region pairs.
+BoundaryResult computeBoundary(Span<const float> point, Span<const int> face, Span<const uint32_t> labelIndex) noexcept;
+
+}
+
+#endif
\ No newline at end of file
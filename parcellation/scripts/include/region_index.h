@@ -0,0 +1,64 @@
+// Author: cute-giggle@outlook.com
+
+#ifndef REGIONINDEX_HPP
+#define REGIONINDEX_HPP
+
+#include <vector>
+
+#include "annotation.h"
+#include "container.h"
+
+namespace fsaverage
+{
+
+// Inverted index of an annotation in CSR form: the vertices of region r are vertex[offset[r], offset[r + 1]),
+// sorted ascending. Per-region queries cost the size of the region instead of a scan over labelIndex.
+struct RegionIndex
+{
+    Span<const uint32_t> offset;
+    Span<const uint32_t> vertex;
+    std::size_t vertexCount{};  // vertices of the annotation, every vertex id is below it
+
+    // Owned arrays when the index was built in memory, empty when it points into a mapped file.
+    std::vector<uint32_t> offsetStorage;
+    std::vector<uint32_t> vertexStorage;
+
+    RegionIndex() noexcept = default;
+    RegionIndex(RegionIndex&&) noexcept = default;
+    RegionIndex& operator= (RegionIndex&&) noexcept = default;
+    RegionIndex(const RegionIndex&) = delete;
+    RegionIndex& operator= (const RegionIndex&) = delete;
+
+    bool empty() const noexcept
+    {
+        return offset.empty();
+    }
+
+    std::size_t regionCount() const noexcept
+    {
+        return offset.empty() ? 0U : offset.size() - 1U;
+    }
+
+    uint32_t count(uint32_t region) const noexcept
+    {
+        return offset[region + 1U] - offset[region];
+    }
+
+    Span<const uint32_t> vertices(uint32_t region) const noexcept
+    {
+        return {vertex.data() + offset[region], count(region)};
+    }
+
+    // Counting sort of labelIndex, run in parallel over vertex blocks. Labels >= regionCount are left out.
+    static RegionIndex build(Span<const uint32_t> labelIndex, std::size_t regionCount) noexcept;
+
+    static RegionIndex build(const Annotation& annotation) noexcept;
+
+    // Use the RegionOffset/RegionVertex sections of the view when present and consistent with its labels,
+    // otherwise build the index.
+    static RegionIndex load(const AnnotationView& view) noexcept;
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,41 @@
+// Author: cute-giggle@outlook.com
+
+#ifndef REGIONSTATS_HPP
+#define REGIONSTATS_HPP
+
+#include <vector>
+#include <thread>
+#include <cstdint>
+
+#include "mapped_file.h"
+#include "region_index.h"
+
+namespace fsaverage
+{
+// Summary statistics of a per-vertex overlay over every region of an annotation.
+
+struct RegionStatistics
+{
+    uint32_t count{};               // labelled vertices of the region
+    double weight{};                // their total weight, the vertex count without weights
+    double mean{};
+    double deviation{};             // population standard deviation
+    float min{};
+    float max{};
+    std::vector<float> percentile;  // one per requested percentile
+};
+
+// Reduce value over the vertices of every region of index in one grouped pass. Regions are independent,
+// so blocks of regions with about the same vertex count run in parallel and need no merge; the AVX2 kernel
+// gathers 8 values per step through the vertex lists. With a per-vertex weight (e.g. VertexArea) mean,
+// deviation and percentiles are weighted. Percentiles are in [0, 100]: unweighted ones interpolate linearly
+// between the closest ranks, weighted ones take the first value whose cumulative weight reaches the share.
+// Empty regions get all zero statistics. Non-finite values are not filtered. Callers that already run one
+// overlay per thread pass threadCount 1.
+std::vector<RegionStatistics> computeRegionStatistics(const RegionIndex& index, Span<const float> value,
+    Span<const float> weight = {}, const std::vector<double>& percentiles = {},
+    std::size_t threadCount = std::thread::hardware_concurrency()) noexcept;
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,41 @@
+// Author: cute-giggle@outlook.com
+
+#ifndef RELATIONTRIPLES_HPP
+#define RELATIONTRIPLES_HPP
+
+#include <memory>
+#include <fstream>
+#include <string_view>
+#include <filesystem>
+
+#include "json_writer.h"
+
+namespace fsaverage
+{
+
+// [subject, relation, object] region triples as one JSON array, the relation_triples*.json layout read by
+// BuildTriples. The relation tools write their --triples output through it.
+class RelationTripleWriter
+{
+public:
+    bool isOpen() const noexcept
+    {
+        return writer != nullptr;
+    }
+
+    bool open(const std::filesystem::path& path) noexcept;
+
+    void write(std::string_view subject, std::string_view relation, std::string_view object) noexcept;
+
+    // Close the array and report the file, nothing when it was never opened.
+    void close() noexcept;
+
+private:
+    std::filesystem::path path;
+    std::ofstream output;
+    std::unique_ptr<JsonWriter> writer;
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,33 @@
+// Author: cute-giggle@outlook.com
+
+#ifndef RESAMPLE_HPP
+#define RESAMPLE_HPP
+
+#include <vector>
+#include <string>
+#include <filesystem>
+
+#include "surface.h"
+#include "annotation.h"
+
+namespace fsaverage
+{
+// Transfer of annotations between meshes that share a space, usually the [lh/rh].sphere.reg of two
+// subjects or templates, so atlases made on different source meshes land on one common surface.
+
+// Label of every target vertex from the source triangle enclosing it: the triangle of the closest point
+// on the source surface, found through a face hierarchy, whose corners vote with their barycentric
+// weights. The connected parts of both surfaces (the hemispheres of merged surfaces) are matched in vertex
+// order, so a vertex never takes a label from the other hemisphere, which overlaps it on merged spheres.
+std::vector<uint32_t> resampleLabels(Span<const float> sourcePoint, Span<const int> sourceFace, Span<const uint32_t> sourceLabel,
+    Span<const float> targetPoint, Span<const int> targetFace) noexcept;
+
+// The annotation of source on target, with the color table of the source annotation.
+Annotation resampleAnnotation(const Surface& source, const Annotation& annotation, const Surface& target) noexcept;
+
+// annotation.aparc.data -> annotation.aparc.resampled.data
+std::string resampledAnnotationFileName(const std::filesystem::path& path) noexcept;
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,96 @@
+// Author: cute-giggle@outlook.com
+
+#ifndef SPATIALINDEX_HPP
+#define SPATIALINDEX_HPP
+
+#include <vector>
+
+#include "surface.h"
+#include "container.h"
+
+namespace fsaverage
+{
+
+// 32-byte node of a bounding volume hierarchy, two nodes per cache line.
+struct BvhNode
+{
+    float lower[3];
+    uint32_t first;     // internal: left child, the right one follows it; leaf: first item
+    float upper[3];
+    uint32_t count;     // 0 for internal nodes, item count for leaves
+};
+static_assert(sizeof(BvhNode) == 32U);
+
+// Bounding volume hierarchy over the vertices or the faces of a surface. Children are stored next to each
+// other and the items of every leaf are contiguous, so a query walks a few cache lines per level.
+struct Bvh
+{
+    Span<const BvhNode> node;       // node[0] is the root
+    Span<const uint32_t> item;      // vertex or face ids in leaf order
+
+    // Owned arrays when the hierarchy was built in memory, empty when they point into a mapped file.
+    std::vector<BvhNode> nodeStorage;
+    std::vector<uint32_t> itemStorage;
+
+    Bvh() noexcept = default;
+    Bvh(Bvh&&) noexcept = default;
+    Bvh& operator= (Bvh&&) noexcept = default;
+    Bvh(const Bvh&) = delete;
+    Bvh& operator= (const Bvh&) = delete;
+
+    bool empty() const noexcept
+    {
+        return node.empty();
+    }
+};
+
+struct NearestVertex
+{
+    uint32_t vertex{0xFFFFFFFFU};
+    float distance{};
+};
+
+struct ClosestPoint
+{
+    uint32_t face{0xFFFFFFFFU};
+    float point[3]{};
+    float weight[3]{};      // barycentric weights of the face corners
+    float distance{};
+
+    // Corner of the face with the largest weight, the vertex whose label the point takes.
+    uint32_t nearestCorner(Span<const int> face) const noexcept;
+};
+
+// Nearest-vertex and closest-point-on-surface queries over one surface.
+struct SpatialIndex
+{
+    Span<const float> point;        // not owned, must outlive the index
+    Span<const int> face;           // not owned, must outlive the index
+    Bvh vertexTree;
+    Bvh faceTree;
+
+    bool empty() const noexcept
+    {
+        return vertexTree.empty() || faceTree.empty();
+    }
+
+    // Batched queries over count x y z triples, split into blocks that run in parallel.
+    void nearestVertex(const float* query, std::size_t count, NearestVertex* result) const noexcept;
+    void closestPoint(const float* query, std::size_t count, ClosestPoint* result) const noexcept;
+
+    // Color table index of the region at every query point: the label of the corner nearest to its closest
+    // point on the surface, or 0xFFFFFFFF when the surface has no faces.
+    std::vector<uint32_t> locate(const float* query, std::size_t count, Span<const uint32_t> labelIndex) const noexcept;
+
+    static SpatialIndex build(Span<const float> point, Span<const int> face) noexcept;
+
+    // Use the BVH sections of the view when present and consistent, otherwise build the trees.
+    static SpatialIndex load(const SurfaceView& view) noexcept;
+
+    // The trees must outlive writer.save().
+    void addSections(ContainerWriter& writer) const noexcept;
+};
+
+}
+
+#endif
\ No newline at end of file
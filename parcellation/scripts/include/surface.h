@@ -1,9 +1,15 @@
 // Author: cute-giggle@outlook.com
 
+#ifndef SURFACE_HPP
+#define SURFACE_HPP
+
 #include <vector>
 #include <filesystem>
 #include <fstream>
 
+#include "mapped_file.h"
+#include "container.h"
+
 namespace fsaverage
 {
 
@@ -20,4 +26,22 @@ struct Surface
     static Surface load(const std::filesystem::path& path) noexcept;
 };
 
-}
\ No newline at end of file
+// Zero-copy, read-only counterpart of Surface: point and face point straight into the mapped file pages.
+struct SurfaceView
+{
+    MappedFile file;
+    ContainerReader container;  // empty for legacy files
+    Span<const float> point;
+    Span<const int> face;
+
+    bool empty() const noexcept
+    {
+        return point.empty() || face.empty();
+    }
+
+    static SurfaceView open(const std::filesystem::path& path) noexcept;
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,79 @@
+// Author: cute-giggle@outlook.com
+
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+
+namespace fsaverage
+{
+
+// Work-stealing thread pool. Every worker owns a deque: it runs its own tasks newest first and steals the
+// oldest task of another worker when its deque is empty. Tasks submitted from a worker go to its own deque.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(std::size_t threadCount = std::thread::hardware_concurrency()) noexcept;
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator= (const ThreadPool&) = delete;
+    ~ThreadPool() noexcept;
+
+    std::size_t size() const noexcept
+    {
+        return threads.size();
+    }
+
+    void submit(std::function<void()> task) noexcept;
+
+    // Block until every submitted task, including tasks submitted by tasks, has finished.
+    // Must not be called from a worker.
+    void wait() noexcept;
+
+private:
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    bool pop(std::size_t self, std::function<void()>& task) noexcept;
+    void run(std::size_t self) noexcept;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::condition_variable idle;
+    std::atomic<std::size_t> queued{0U};
+    std::atomic<std::size_t> pending{0U};
+    std::atomic<std::size_t> next{0U};
+    bool stopping{false};
+};
+
+// Caps the bytes held by tasks in flight: acquire blocks until enough of the budget is released. A request
+// larger than the whole budget is clamped to it, so it runs alone instead of blocking forever.
+class MemoryBudget
+{
+public:
+    explicit MemoryBudget(std::size_t capacity) noexcept : capacity(capacity), available(capacity) {}
+
+    std::size_t acquire(std::size_t bytes) noexcept;
+    void release(std::size_t bytes) noexcept;
+
+private:
+    std::size_t capacity;
+    std::size_t available;
+    std::mutex mutex;
+    std::condition_variable released;
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,110 @@
+// Author: cute-giggle@outlook.com
+
+#ifndef TRIPLESTORE_HPP
+#define TRIPLESTORE_HPP
+
+#include <vector>
+#include <array>
+#include <string>
+#include <string_view>
+#include <filesystem>
+
+#include "mapped_file.h"
+#include "container.h"
+#include "json_reader.h"
+
+namespace fsaverage
+{
+
+struct Triple
+{
+    uint32_t subject;
+    uint32_t relation;
+    uint32_t object;
+};
+static_assert(sizeof(Triple) == 12U);
+
+using NameTriple = std::array<std::string, 3>;
+
+// Append the triples of a relation JSON file: [[s, p, o], ...] as in relation_triples*.json,
+// {name: [[s, p, o], ...]} as in relations.json, or {first: {second: {"forward": p, "backward": q}}} as in
+// location_relations/*.json, which yields (first, p, second) and (second, q, first).
+bool readTriples(const JsonValue& document, std::vector<NameTriple>& triples) noexcept;
+
+enum class Direction : uint8_t
+{
+    Outgoing,   // follow subject -> object
+    Incoming,   // follow object -> subject
+    Both,
+};
+
+// Read-only triple store. Entity and relation names are interned once into a pool sorted in byte order, so a
+// term id is the rank of its name, and the triples are kept as id arrays in three sort orders so every
+// pattern with any set of bound terms is one contiguous range found by binary search.
+struct TripleStore
+{
+    static constexpr uint32_t ANY = 0xFFFFFFFFU;
+
+    MappedFile file;                // backing pages when opened from disk
+    Span<const uint32_t> termOffset;
+    Span<const char> termPool;
+    Span<const Triple> spo;
+    Span<const Triple> pos;
+    Span<const Triple> osp;
+
+    // Owned arrays when the store was built in memory, empty when they point into a mapped file.
+    std::vector<uint32_t> termOffsetStorage;
+    std::vector<char> termPoolStorage;
+    std::vector<Triple> spoStorage;
+    std::vector<Triple> posStorage;
+    std::vector<Triple> ospStorage;
+
+    TripleStore() noexcept = default;
+    TripleStore(TripleStore&&) noexcept = default;
+    TripleStore& operator= (TripleStore&&) noexcept = default;
+    TripleStore(const TripleStore&) = delete;
+    TripleStore& operator= (const TripleStore&) = delete;
+
+    bool empty() const noexcept
+    {
+        return termOffset.empty();
+    }
+
+    std::size_t termCount() const noexcept
+    {
+        return termOffset.empty() ? 0U : termOffset.size() - 1U;
+    }
+
+    // Number of distinct triples.
+    std::size_t size() const noexcept
+    {
+        return spo.size();
+    }
+
+    std::string_view term(uint32_t id) const noexcept
+    {
+        return {termPool.data() + termOffset[id], termOffset[id + 1U] - termOffset[id]};
+    }
+
+    // Id of the entity or relation name, ANY when the store does not contain it.
+    uint32_t find(std::string_view name) const noexcept;
+
+    // Triples matching the pattern, ANY being a wildcard. The range is ordered by the bound terms first.
+    Span<const Triple> match(uint32_t subject, uint32_t relation, uint32_t object) const noexcept;
+
+    // Entities reachable from entity over 1 to hops edges, optionally along one relation only, ascending
+    // and without the entity itself.
+    std::vector<uint32_t> neighborhood(uint32_t entity, std::size_t hops, uint32_t relation = ANY,
+        Direction direction = Direction::Both) const noexcept;
+
+    // Duplicate triples are stored once.
+    static TripleStore build(const std::vector<NameTriple>& triples) noexcept;
+
+    static TripleStore open(const std::filesystem::path& path) noexcept;
+
+    bool save(const std::filesystem::path& path) const noexcept;
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,57 @@
+// Author: cute-giggle@outlook.com
+
+#ifndef VERTEXAREA_HPP
+#define VERTEXAREA_HPP
+
+#include <vector>
+
+#include "surface.h"
+
+namespace fsaverage
+{
+
+// Vertex to incident face lists in CSR form. It only depends on the faces, so one incidence serves the
+// orig, white, pial and inflated surfaces of a subject.
+struct FaceIncidence
+{
+    std::vector<uint32_t> offset;   // vertex count + 1
+    std::vector<uint32_t> face;     // face ids grouped by vertex
+
+    bool empty() const noexcept
+    {
+        return offset.empty();
+    }
+
+    static FaceIncidence build(Span<const int> face, std::size_t vertexCount) noexcept;
+};
+
+// Area of every triangle, computed in parallel blocks that are gathered to structure-of-arrays chunks.
+std::vector<float> computeFaceArea(Span<const float> point, Span<const int> face) noexcept;
+
+// One third of the area of the incident faces of every vertex, summed without atomics through the incidence.
+std::vector<float> computeVertexArea(Span<const float> point, Span<const int> face, const FaceIncidence& incidence) noexcept;
+
+// Per-vertex area of a surface, read from its VertexArea section when present, otherwise computed.
+struct VertexArea
+{
+    Span<const float> area;
+    std::vector<float> storage;
+
+    VertexArea() noexcept = default;
+    VertexArea(VertexArea&&) noexcept = default;
+    VertexArea& operator= (VertexArea&&) noexcept = default;
+    VertexArea(const VertexArea&) = delete;
+    VertexArea& operator= (const VertexArea&) = delete;
+
+    bool empty() const noexcept
+    {
+        return area.empty();
+    }
+
+    // incidence may be shared between surfaces of the same topology, it is built when null.
+    static VertexArea load(const SurfaceView& view, const FaceIncidence* incidence = nullptr) noexcept;
+};
+
+}
+
+#endif
\ No newline at end of file
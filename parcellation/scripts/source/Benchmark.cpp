@@ -0,0 +1,606 @@
+// Author: cute-giggle@outlook.com
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <ctime>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <filesystem>
+
+#include "freesurfer.h"
+#include "binary_reader.h"
+#include "json_writer.h"
+#include "log.h"
+#include "metrics.h"
+#include "region_index.h"
+#include "region_stats.h"
+#include "decimation.h"
+#include "resample.h"
+
+#include "BigEndianHelper.h"
+
+namespace fsaverage
+{
+// Throughput benchmarks of the readers, the FreeSurfer converters and the .data loaders, in the manner of
+// Google Benchmark: every benchmark runs until --min-time has passed, is repeated --repetitions times and
+// reported by its median. The JSON output uses Google Benchmark's field names, so its compare.py works on it.
+// Inputs are the checked-in [atlas]/surface/original/[lh/rh].xxx.annot files and an icosphere surface
+// written in FreeSurfer format, which can be made finer than fsaverage with --level.
+
+namespace
+{
+
+struct Options
+{
+    std::filesystem::path parcellation{".."};
+    std::filesystem::path work{std::filesystem::temp_directory_path() / "fsaverage-benchmark"};
+    std::filesystem::path json;
+    std::string filter;
+    double minTime = 0.5;
+    std::size_t repetitions = 3U;
+    int level = 7;
+};
+
+bool parseOptions(int argc, char* argv[], Options& options) noexcept
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (argument == "--filter" && i + 1 < argc)
+        {
+            options.filter = argv[++i];
+        }
+        else if (argument == "--min-time" && i + 1 < argc)
+        {
+            options.minTime = std::atof(argv[++i]);
+        }
+        else if (argument == "--repetitions" && i + 1 < argc)
+        {
+            options.repetitions = std::max<std::size_t>(1U, std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (argument == "--level" && i + 1 < argc)
+        {
+            options.level = std::atoi(argv[++i]);
+        }
+        else if (argument == "--work" && i + 1 < argc)
+        {
+            options.work = argv[++i];
+        }
+        else if (argument == "--json" && i + 1 < argc)
+        {
+            options.json = argv[++i];
+        }
+        else if (argument.find("--") == 0U)
+        {
+            return false;
+        }
+        else
+        {
+            options.parcellation = argument;
+        }
+    }
+    return options.minTime > 0.0 && options.level >= 0 && options.level <= 9;
+}
+
+// What one call of a benchmark body processed. A non-zero manualTime replaces the measured wall time, for
+// bodies whose interesting part is only a slice of the call.
+struct Sample
+{
+    uint64_t bytes{};
+    uint64_t vertices{};
+    std::chrono::steady_clock::duration manualTime{};
+};
+
+struct Benchmark
+{
+    std::string name;
+    std::function<Sample()> body;
+};
+
+struct Result
+{
+    std::string name;
+    std::size_t iterations{};
+    double realTime{};      // nanoseconds per iteration
+    double cpuTime{};       // nanoseconds per iteration, summed over threads
+    double bytesPerSecond{};
+    double verticesPerSecond{};
+};
+
+struct Run
+{
+    std::size_t iterations{};
+    double realSeconds{};
+    double cpuSeconds{};
+    uint64_t bytes{};
+    uint64_t vertices{};
+};
+
+Run runIterations(const Benchmark& benchmark, std::size_t iterations) noexcept
+{
+    Run run{iterations};
+    std::chrono::steady_clock::duration manual{};
+    std::clock_t cpuStart = std::clock();
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0U; i < iterations; ++i)
+    {
+        Sample sample = benchmark.body();
+        run.bytes += sample.bytes;
+        run.vertices += sample.vertices;
+        manual += sample.manualTime;
+    }
+    auto wall = std::chrono::steady_clock::now() - start;
+    run.cpuSeconds = static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+    run.realSeconds = std::chrono::duration<double>(manual.count() > 0 ? manual : wall).count();
+    return run;
+}
+
+// Grow the iteration count until one run lasts minTime, then keep the median of the repetitions.
+Result measure(const Benchmark& benchmark, double minTime, std::size_t repetitions) noexcept
+{
+    std::size_t iterations = 1U;
+    Run run = runIterations(benchmark, iterations);
+    while (run.realSeconds < minTime && iterations < (std::size_t{1U} << 30))
+    {
+        double scale = run.realSeconds > 0.0 ? minTime * 1.4 / run.realSeconds : 10.0;
+        iterations = std::max(iterations + 1U, static_cast<std::size_t>(static_cast<double>(iterations) * std::min(scale, 10.0)));
+        run = runIterations(benchmark, iterations);
+    }
+
+    std::vector<Run> runs{run};
+    while (runs.size() < repetitions)
+    {
+        runs.emplace_back(runIterations(benchmark, iterations));
+    }
+    std::sort(runs.begin(), runs.end(), [](const Run& a, const Run& b) { return a.realSeconds < b.realSeconds; });
+    const Run& median = runs[runs.size() / 2U];
+
+    Result result{benchmark.name, iterations};
+    result.realTime = median.realSeconds * 1e9 / static_cast<double>(iterations);
+    result.cpuTime = median.cpuSeconds * 1e9 / static_cast<double>(iterations);
+    result.bytesPerSecond = median.realSeconds > 0.0 ? static_cast<double>(median.bytes) / median.realSeconds : 0.0;
+    result.verticesPerSecond = median.realSeconds > 0.0 ? static_cast<double>(median.vertices) / median.realSeconds : 0.0;
+    return result;
+}
+
+std::string formatTime(double nanoseconds) noexcept
+{
+    std::ostringstream stream;
+    stream << std::fixed << std::setprecision(2);
+    if (nanoseconds >= 1e6)
+    {
+        stream << nanoseconds * 1e-6 << " ms";
+    }
+    else if (nanoseconds >= 1e3)
+    {
+        stream << nanoseconds * 1e-3 << " us";
+    }
+    else
+    {
+        stream << nanoseconds << " ns";
+    }
+    return stream.str();
+}
+
+void printHeader() noexcept
+{
+    std::cout << std::left << std::setw(64) << "Benchmark" << std::right << std::setw(14) << "Time" << std::setw(14) << "CPU"
+              << std::setw(12) << "Iterations" << std::setw(14) << "MB/s" << std::setw(16) << "vertices/s" << std::endl;
+    std::cout << std::string(134U, '-') << std::endl;
+}
+
+void printResult(const Result& result) noexcept
+{
+    std::cout << std::left << std::setw(64) << result.name << std::right
+              << std::setw(14) << formatTime(result.realTime) << std::setw(14) << formatTime(result.cpuTime)
+              << std::setw(12) << result.iterations << std::fixed << std::setprecision(1)
+              << std::setw(14) << result.bytesPerSecond / (1024.0 * 1024.0)
+              << std::setw(15) << result.verticesPerSecond * 1e-6 << "M" << std::endl;
+}
+
+bool writeJson(const std::filesystem::path& path, const std::vector<Result>& results, const Options& options,
+    std::size_t vertexCount) noexcept
+{
+    std::ofstream output(path);
+    if (!output.is_open())
+    {
+        logError() << "Open " << path << " failed!";
+        return false;
+    }
+    const char* simd[] = {"scalar", "ssse3", "avx2"};
+    JsonWriter writer(output, 2);
+    writer.beginObject();
+    writer.key("context");
+    writer.beginObject();
+    writer.key("simd");
+    writer.value(simd[static_cast<int>(BigEndianHelper::simdLevel())]);
+    writer.key("icosphere_level");
+    writer.value(options.level);
+    writer.key("icosphere_vertices");
+    writer.value(static_cast<uint64_t>(vertexCount));
+    writer.key("min_time");
+    writer.value(options.minTime);
+    writer.key("repetitions");
+    writer.value(static_cast<uint64_t>(options.repetitions));
+    writer.endObject();
+    writer.key("benchmarks");
+    writer.beginArray();
+    for (auto& result : results)
+    {
+        writer.beginObject();
+        writer.key("name");
+        writer.value(result.name);
+        writer.key("iterations");
+        writer.value(static_cast<uint64_t>(result.iterations));
+        writer.key("real_time");
+        writer.value(result.realTime);
+        writer.key("cpu_time");
+        writer.value(result.cpuTime);
+        writer.key("time_unit");
+        writer.value("ns");
+        writer.key("bytes_per_second");
+        writer.value(result.bytesPerSecond);
+        writer.key("items_per_second");
+        writer.value(result.verticesPerSecond);
+        writer.endObject();
+    }
+    writer.endArray();
+    writer.endObject();
+    writer.flush();
+    output << std::endl;
+    logInfo() << "Save benchmark results to " << std::filesystem::absolute(path);
+    return true;
+}
+
+// Unit icosphere subdivided level times, scaled to a brain-sized radius. Level 7 has fsaverage's 163842 vertices.
+void buildIcosphere(int level, std::vector<float>& point, std::vector<int>& face) noexcept
+{
+    const float t = (1.f + std::sqrt(5.f)) / 2.f;
+    point = {-1, t, 0, 1, t, 0, -1, -t, 0, 1, -t, 0, 0, -1, t, 0, 1, t, 0, -1, -t, 0, 1, -t, t, 0, -1, t, 0, 1, -t, 0, -1, -t, 0, 1};
+    face = {0, 11, 5, 0, 5, 1, 0, 1, 7, 0, 7, 10, 0, 10, 11, 1, 5, 9, 5, 11, 4, 11, 10, 2, 10, 7, 6, 7, 1, 8,
+            3, 9, 4, 3, 4, 2, 3, 2, 6, 3, 6, 8, 3, 8, 9, 4, 9, 5, 2, 4, 11, 6, 2, 10, 8, 6, 7, 9, 8, 1};
+    auto normalize = [&point](std::size_t i)
+    {
+        float length = std::sqrt(point[i * 3U] * point[i * 3U] + point[i * 3U + 1U] * point[i * 3U + 1U] + point[i * 3U + 2U] * point[i * 3U + 2U]);
+        for (std::size_t k = 0U; k < 3U; ++k)
+        {
+            point[i * 3U + k] /= length;
+        }
+    };
+    for (std::size_t i = 0U; i < point.size() / 3U; ++i)
+    {
+        normalize(i);
+    }
+
+    for (int step = 0; step < level; ++step)
+    {
+        std::unordered_map<uint64_t, int> middle;
+        auto midpoint = [&](int a, int b) -> int
+        {
+            uint64_t key = (static_cast<uint64_t>(std::min(a, b)) << 32) | static_cast<uint32_t>(std::max(a, b));
+            auto iter = middle.find(key);
+            if (iter != middle.end())
+            {
+                return iter->second;
+            }
+            int index = static_cast<int>(point.size() / 3U);
+            for (std::size_t k = 0U; k < 3U; ++k)
+            {
+                point.push_back((point[a * 3U + k] + point[b * 3U + k]) / 2.f);
+            }
+            normalize(index);
+            middle.emplace(key, index);
+            return index;
+        };
+        std::vector<int> next;
+        next.reserve(face.size() * 4U);
+        for (std::size_t i = 0U; i < face.size(); i += 3U)
+        {
+            int a = face[i], b = face[i + 1U], c = face[i + 2U];
+            int ab = midpoint(a, b), bc = midpoint(b, c), ca = midpoint(c, a);
+            next.insert(next.end(), {a, ab, ca, b, bc, ab, c, ca, bc, ab, bc, ca});
+        }
+        face.swap(next);
+    }
+    std::for_each(point.begin(), point.end(), [](float& value) { value *= 80.f; });
+}
+
+template<typename T>
+void writeBigEndian(std::ofstream& output, std::vector<T> data) noexcept
+{
+    if (!BigEndianHelper::isBigEndian())
+    {
+        BigEndianHelper::reverseEndian(data.data(), data.size());
+    }
+    output.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size() * sizeof(T)));
+}
+
+// Triangle surface file as written by FreeSurfer: 3-byte magic, two text lines, counts, then big-endian data.
+bool writeFreeSurferSurface(const std::filesystem::path& path, const std::vector<float>& point, const std::vector<int>& face) noexcept
+{
+    std::ofstream output(path, std::ios::binary);
+    if (!output.is_open())
+    {
+        logError() << "Open " << path << " failed!";
+        return false;
+    }
+    const char magic[3] = {'\xFF', '\xFF', '\xFE'};
+    output.write(magic, 3);
+    output << "created by Benchmark\n\n";
+    writeBigEndian(output, std::vector<int>{static_cast<int>(point.size() / 3U), static_cast<int>(face.size() / 3U)});
+    writeBigEndian(output, point);
+    writeBigEndian(output, face);
+    return output.good();
+}
+
+struct Atlas
+{
+    std::string name;
+    std::filesystem::path lpath;
+    std::filesystem::path rpath;
+    std::filesystem::path data;
+};
+
+std::vector<Atlas> findAtlases(const std::filesystem::path& parcellation) noexcept
+{
+    std::vector<Atlas> atlases;
+    // iterate with error codes, an unreadable directory only leaves out its atlases
+    std::error_code error;
+    std::filesystem::directory_iterator directory(parcellation, error), end;
+    for (; !error && directory != end; directory.increment(error))
+    {
+        std::error_code entryError;
+        std::filesystem::directory_iterator entry(directory->path() / "surface" / "original", entryError);
+        for (; !entryError && entry != end; entry.increment(entryError))
+        {
+            auto name = entry->path().filename().string();
+            auto rpath = entry->path().parent_path() / ("rh." + name.substr(std::min<std::size_t>(3U, name.size())));
+            std::error_code existsError;
+            if (name.find("lh.") == 0U && entry->path().extension() == ".annot" && std::filesystem::exists(rpath, existsError))
+            {
+                atlases.emplace_back(Atlas{entry->path().stem().string().substr(3U), entry->path(), rpath, {}});
+            }
+        }
+    }
+    if (error)
+    {
+        logWarning() << "Read directory " << parcellation << " failed: " << error.message();
+    }
+    std::sort(atlases.begin(), atlases.end(), [](const Atlas& a, const Atlas& b) { return a.name < b.name; });
+    return atlases;
+}
+
+uint64_t fileSize(const std::filesystem::path& path) noexcept
+{
+    std::error_code error;
+    auto size = std::filesystem::file_size(path, error);
+    return error ? 0U : static_cast<uint64_t>(size);
+}
+
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    using namespace fsaverage;
+
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        std::cout << "Using [Benchmark] [--filter text] [--min-time seconds] [--repetitions n] [--level n] [--work directory] "
+                     "[--json file] [parcellation directory]" << std::endl;
+        std::cout << "Atlases are read from [parcellation directory]/*/surface/original (default ..); the synthetic surface "
+                     "is an icosphere of --level subdivisions (default 7, 163842 vertices per hemisphere), written with "
+                     "the .data files to --work." << std::endl;
+        return 0;
+    }
+
+    // inputs: icosphere hemispheres in FreeSurfer format, and .data files converted from every input
+    std::error_code error;
+    auto work = options.work / ("ico" + std::to_string(options.level));
+    std::filesystem::create_directories(work, error);
+    auto lsurface = work / "lh.white";
+    auto rsurface = work / "rh.white";
+    auto surfaceData = work / "surface.white.data";
+    std::vector<float> point;
+    std::vector<int> face;
+    buildIcosphere(options.level, point, face);
+    std::size_t vertexCount = point.size() / 3U;
+    if (!std::filesystem::exists(surfaceData, error))
+    {
+        if (!writeFreeSurferSurface(lsurface, point, face) || !writeFreeSurferSurface(rsurface, point, face))
+        {
+            return 1;
+        }
+        auto surface = loadFreeSurferSurface(lsurface, rsurface);
+        if (surface.empty() || !save(surfaceData, surface))
+        {
+            return 1;
+        }
+    }
+
+    auto atlases = findAtlases(options.parcellation);
+    if (atlases.empty())
+    {
+        logWarning() << "No [lh/rh].xxx.annot pairs under " << options.parcellation << "/*/surface/original!";
+    }
+    for (auto& atlas : atlases)
+    {
+        atlas.data = options.work / annotationDataFileName(atlas.lpath);
+        if (!std::filesystem::exists(atlas.data, error))
+        {
+            auto annotation = loadFreeSurferAnnotation(atlas.lpath, atlas.rpath);
+            if (annotation.empty() || !save(atlas.data, annotation))
+            {
+                return 1;
+            }
+        }
+    }
+
+    // the raw readers run on the coordinate block of the left hemisphere file, after the 3 + 2 + 8 header bytes
+    std::ifstream rawInput(lsurface, std::ios::binary);
+    std::streamoff rawOffset = 3 + static_cast<std::streamoff>(std::string("created by Benchmark\n\n").size()) + 8;
+    std::size_t rawCount = vertexCount * 3U;
+    auto rawStream = [&rawInput, rawOffset]() -> std::ifstream&
+    {
+        rawInput.clear();
+        rawInput.seekg(rawOffset);
+        return rawInput;
+    };
+
+    MappedFile rawFile = MappedFile::open(lsurface);
+    BinaryReader rawReader(rawFile);
+
+    std::vector<Benchmark> benchmarks;
+    std::string level = "/ico" + std::to_string(options.level);
+    benchmarks.emplace_back(Benchmark{"BigEndianHelper::readSequence<float>" + level, [&]()
+    {
+        auto data = BigEndianHelper::readSequence<float>(rawStream(), rawCount);
+        return Sample{data.size() * sizeof(float), data.size() / 3U};
+    }});
+    benchmarks.emplace_back(Benchmark{"BigEndianHelper::read3BytesMany" + level, [&]()
+    {
+        auto data = BigEndianHelper::read3BytesMany(rawStream(), rawCount);
+        return Sample{data.size() * 3U, data.size() / 3U};
+    }});
+    benchmarks.emplace_back(Benchmark{"BinaryReader::readSequence<float>" + level, [&]()
+    {
+        std::vector<float> data(rawCount);
+        rawReader.readSequence(static_cast<std::size_t>(rawOffset), data.data(), data.size());
+        return Sample{data.size() * sizeof(float), data.size() / 3U};
+    }});
+    benchmarks.emplace_back(Benchmark{"loadFreeSurferSurface" + level, [&]()
+    {
+        auto surface = loadFreeSurferSurface(lsurface, rsurface);
+        return Sample{fileSize(lsurface) + fileSize(rsurface), surface.point.size() / 3U};
+    }});
+    for (auto& atlas : atlases)
+    {
+        benchmarks.emplace_back(Benchmark{"loadFreeSurferAnnotation/" + atlas.name, [&atlas]()
+        {
+            auto annotation = loadFreeSurferAnnotation(atlas.lpath, atlas.rpath);
+            return Sample{fileSize(atlas.lpath) + fileSize(atlas.rpath), annotation.labelIndex.size()};
+        }});
+    }
+    benchmarks.emplace_back(Benchmark{"Surface::load" + level, [&]()
+    {
+        auto surface = Surface::load(surfaceData);
+        return Sample{(surface.point.size() + surface.face.size()) * 4U, surface.point.size() / 3U};
+    }});
+    for (auto& atlas : atlases)
+    {
+        benchmarks.emplace_back(Benchmark{"Annotation::load/" + atlas.name, [&atlas]()
+        {
+            auto annotation = Annotation::load(atlas.data);
+            return Sample{fileSize(atlas.data), annotation.labelIndex.size()};
+        }});
+    }
+
+    // label decoding, the color table merge and the remap fused into it run inside loadFreeSurferAnnotation,
+    // their time is taken from the stage counters without the file mapping and color table parsing; the
+    // loader times each of these stages once on the calling thread, so their sum is wall-clock time
+    for (auto& atlas : atlases)
+    {
+        benchmarks.emplace_back(Benchmark{"AnnotationDecodeRemap/" + atlas.name, [&atlas]()
+        {
+            auto elapsed = []()
+            {
+                return stageTotals(Stage::Decode).nanoseconds + stageTotals(Stage::Merge).nanoseconds
+                    + stageTotals(Stage::Remap).nanoseconds;
+            };
+            uint64_t start = elapsed();
+            auto annotation = loadFreeSurferAnnotation(atlas.lpath, atlas.rpath);
+            uint64_t nanoseconds = elapsed() - start;
+            return Sample{annotation.labelIndex.size() * 2U * sizeof(uint32_t), annotation.labelIndex.size(),
+                std::chrono::nanoseconds(std::max<uint64_t>(nanoseconds, 1U))};
+        }});
+    }
+
+    // grouped reduction of a synthetic overlay over every region, with the default percentiles of ComputeRegionStats
+    std::vector<RegionIndex> regionIndex;
+    std::vector<std::vector<float>> overlay;
+    for (auto& atlas : atlases)
+    {
+        auto annotation = Annotation::load(atlas.data);
+        regionIndex.emplace_back(RegionIndex::build(annotation));
+        overlay.emplace_back(annotation.labelIndex.size());
+        for (std::size_t i = 0U; i < overlay.back().size(); ++i)
+        {
+            overlay.back()[i] = 2.5f + std::sin(static_cast<float>(i) * 0.37f);
+        }
+    }
+    for (std::size_t i = 0U; i < atlases.size(); ++i)
+    {
+        benchmarks.emplace_back(Benchmark{"computeRegionStatistics/" + atlases[i].name, [&regionIndex, &overlay, i]()
+        {
+            auto statistics = computeRegionStatistics(regionIndex[i], {overlay[i].data(), overlay[i].size()}, {}, {25.0, 50.0, 75.0});
+            return Sample{overlay[i].size() * sizeof(float), statistics.empty() ? 0U : overlay[i].size()};
+        }});
+    }
+
+    // one level at a quarter of the vertices, about one icosphere order down
+    auto decimationInput = Surface::load(surfaceData);
+    benchmarks.emplace_back(Benchmark{"decimateSurface" + level, [&decimationInput]()
+    {
+        std::size_t count = decimationInput.point.size() / 3U;
+        auto levels = decimateSurface({decimationInput.point.data(), decimationInput.point.size()},
+            {decimationInput.face.data(), decimationInput.face.size()}, {count / 4U});
+        return Sample{(decimationInput.point.size() + decimationInput.face.size()) * 4U, levels.empty() ? 0U : count};
+    }});
+
+    // labels of every atlas carried from the icosphere to itself, a closest point search per vertex; the
+    // atlases have the vertices of fsaverage, so only an icosphere of the same size (--level 7) takes them
+    std::vector<std::vector<uint32_t>> atlasLabel;
+    for (auto& atlas : atlases)
+    {
+        atlasLabel.emplace_back(Annotation::load(atlas.data).labelIndex);
+    }
+    for (std::size_t i = 0U; i < atlases.size(); ++i)
+    {
+        if (atlasLabel[i].size() != decimationInput.point.size() / 3U)
+        {
+            logInfo() << "Skip resampleLabels/" << atlases[i].name << ", its labels are not defined on the icosphere";
+            continue;
+        }
+        benchmarks.emplace_back(Benchmark{"resampleLabels/" + atlases[i].name, [&decimationInput, &atlasLabel, i]()
+        {
+            Span<const float> point{decimationInput.point.data(), decimationInput.point.size()};
+            Span<const int> face{decimationInput.face.data(), decimationInput.face.size()};
+            auto label = resampleLabels(point, face, {atlasLabel[i].data(), atlasLabel[i].size()}, point, face);
+            return Sample{point.size() * sizeof(float), label.size()};
+        }});
+    }
+
+    // expected warnings of the inputs would repeat for every iteration
+    if (std::getenv("FSAVERAGE_LOG") == nullptr)
+    {
+        setLogLevel(LogLevel::Error);
+    }
+
+    std::vector<Result> results;
+    printHeader();
+    for (auto& benchmark : benchmarks)
+    {
+        if (!options.filter.empty() && benchmark.name.find(options.filter) == std::string::npos)
+        {
+            continue;
+        }
+        results.emplace_back(measure(benchmark, options.minTime, options.repetitions));
+        printResult(results.back());
+    }
+
+    if (!options.json.empty() && !writeJson(options.json, results, options, vertexCount))
+    {
+        return 1;
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,233 @@
+// Author: cute-giggle@outlook.com
+
+#include "BigEndianHelper.h"
+
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define FSAVERAGE_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(FSAVERAGE_X86) && (defined(__GNUC__) || defined(__clang__))
+#define FSAVERAGE_TARGET(isa) __attribute__((target(isa)))
+#else
+#define FSAVERAGE_TARGET(isa)
+#endif
+
+namespace fsaverage
+{
+
+namespace
+{
+
+// Scalar kernels, also used for the tail of every vector loop.
+
+void reverse4Scalar(unsigned char* data, std::size_t count) noexcept
+{
+    for (std::size_t i = 0U; i < count; ++i, data += 4)
+    {
+        std::swap(data[0], data[3]);
+        std::swap(data[1], data[2]);
+    }
+}
+
+void reverse2Scalar(unsigned char* data, std::size_t count) noexcept
+{
+    for (std::size_t i = 0U; i < count; ++i, data += 2)
+    {
+        std::swap(data[0], data[1]);
+    }
+}
+
+void unpack3Scalar(const unsigned char* source, int* destination, std::size_t count) noexcept
+{
+    for (std::size_t i = 0U; i < count; ++i, source += 3)
+    {
+        destination[i] = (static_cast<int>(source[0]) << 16) | (static_cast<int>(source[1]) << 8) | static_cast<int>(source[2]);
+    }
+}
+
+#ifdef FSAVERAGE_X86
+
+// Shuffle masks are only used on little-endian x86 hosts, where the file data always needs swapping.
+
+FSAVERAGE_TARGET("ssse3")
+void reverse4SSSE3(unsigned char* data, std::size_t count) noexcept
+{
+    const __m128i mask = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    std::size_t i = 0U;
+    for (; i + 4U <= count; i += 4U)
+    {
+        auto* pointer = reinterpret_cast<__m128i*>(data + i * 4U);
+        _mm_storeu_si128(pointer, _mm_shuffle_epi8(_mm_loadu_si128(pointer), mask));
+    }
+    reverse4Scalar(data + i * 4U, count - i);
+}
+
+FSAVERAGE_TARGET("ssse3")
+void reverse2SSSE3(unsigned char* data, std::size_t count) noexcept
+{
+    const __m128i mask = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    std::size_t i = 0U;
+    for (; i + 8U <= count; i += 8U)
+    {
+        auto* pointer = reinterpret_cast<__m128i*>(data + i * 2U);
+        _mm_storeu_si128(pointer, _mm_shuffle_epi8(_mm_loadu_si128(pointer), mask));
+    }
+    reverse2Scalar(data + i * 2U, count - i);
+}
+
+FSAVERAGE_TARGET("ssse3")
+void unpack3SSSE3(const unsigned char* source, int* destination, std::size_t count) noexcept
+{
+    // 12 input bytes -> 4 integers; the 16 byte load must stay inside count * 3 bytes
+    const __m128i mask = _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+    std::size_t i = 0U;
+    for (; (i + 4U) * 3U + 4U <= count * 3U; i += 4U)
+    {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 3U));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), _mm_shuffle_epi8(bytes, mask));
+    }
+    unpack3Scalar(source + i * 3U, destination + i, count - i);
+}
+
+FSAVERAGE_TARGET("avx2")
+void reverse4AVX2(unsigned char* data, std::size_t count) noexcept
+{
+    const __m256i mask = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                          3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    std::size_t i = 0U;
+    for (; i + 8U <= count; i += 8U)
+    {
+        auto* pointer = reinterpret_cast<__m256i*>(data + i * 4U);
+        _mm256_storeu_si256(pointer, _mm256_shuffle_epi8(_mm256_loadu_si256(pointer), mask));
+    }
+    reverse4Scalar(data + i * 4U, count - i);
+}
+
+FSAVERAGE_TARGET("avx2")
+void reverse2AVX2(unsigned char* data, std::size_t count) noexcept
+{
+    const __m256i mask = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+                                          1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    std::size_t i = 0U;
+    for (; i + 16U <= count; i += 16U)
+    {
+        auto* pointer = reinterpret_cast<__m256i*>(data + i * 2U);
+        _mm256_storeu_si256(pointer, _mm256_shuffle_epi8(_mm256_loadu_si256(pointer), mask));
+    }
+    reverse2Scalar(data + i * 2U, count - i);
+}
+
+FSAVERAGE_TARGET("avx2")
+void unpack3AVX2(const unsigned char* source, int* destination, std::size_t count) noexcept
+{
+    // shuffles stay inside 128-bit lanes, so each lane gets its own 12 input bytes
+    const __m256i mask = _mm256_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1,
+                                          2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+    std::size_t i = 0U;
+    for (; (i + 8U) * 3U + 4U <= count * 3U; i += 8U)
+    {
+        __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 3U));
+        __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 3U + 12U));
+        __m256i bytes = _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), _mm256_shuffle_epi8(bytes, mask));
+    }
+    unpack3Scalar(source + i * 3U, destination + i, count - i);
+}
+
+BigEndianHelper::SimdLevel detectSimdLevel() noexcept
+{
+#ifdef _MSC_VER
+    int info[4] = {0};
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    bool ssse3 = (info[2] & (1 << 9)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx2 = false;
+    if (maxLeaf >= 7 && osxsave && (_xgetbv(0) & 0x6) == 0x6)
+    {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0;
+    }
+#else
+    __builtin_cpu_init();
+    bool ssse3 = __builtin_cpu_supports("ssse3");
+    bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+    if (avx2)
+    {
+        return BigEndianHelper::SimdLevel::AVX2;
+    }
+    return ssse3 ? BigEndianHelper::SimdLevel::SSSE3 : BigEndianHelper::SimdLevel::Scalar;
+}
+
+#else
+
+BigEndianHelper::SimdLevel detectSimdLevel() noexcept
+{
+    return BigEndianHelper::SimdLevel::Scalar;
+}
+
+#endif
+
+struct Kernels
+{
+    void (*reverse4)(unsigned char*, std::size_t) noexcept;
+    void (*reverse2)(unsigned char*, std::size_t) noexcept;
+    void (*unpack3)(const unsigned char*, int*, std::size_t) noexcept;
+};
+
+const Kernels& kernels() noexcept
+{
+    static const Kernels selected = []() -> Kernels
+    {
+        switch (BigEndianHelper::simdLevel())
+        {
+#ifdef FSAVERAGE_X86
+        case BigEndianHelper::SimdLevel::AVX2:
+            return {reverse4AVX2, reverse2AVX2, unpack3AVX2};
+        case BigEndianHelper::SimdLevel::SSSE3:
+            return {reverse4SSSE3, reverse2SSSE3, unpack3SSSE3};
+#endif
+        default:
+            return {reverse4Scalar, reverse2Scalar, unpack3Scalar};
+        }
+    }();
+    return selected;
+}
+
+}
+
+BigEndianHelper::SimdLevel BigEndianHelper::simdLevel() noexcept
+{
+    static const SimdLevel level = detectSimdLevel();
+    return level;
+}
+
+void BigEndianHelper::reverseEndian(int* data, std::size_t count) noexcept
+{
+    kernels().reverse4(reinterpret_cast<unsigned char*>(data), count);
+}
+
+void BigEndianHelper::reverseEndian(float* data, std::size_t count) noexcept
+{
+    kernels().reverse4(reinterpret_cast<unsigned char*>(data), count);
+}
+
+void BigEndianHelper::reverseEndian(short* data, std::size_t count) noexcept
+{
+    kernels().reverse2(reinterpret_cast<unsigned char*>(data), count);
+}
+
+void BigEndianHelper::unpack3Bytes(const unsigned char* source, int* destination, std::size_t count) noexcept
+{
+    kernels().unpack3(source, destination, count);
+}
+
+}
@@ -0,0 +1,81 @@
+// Author: cute-giggle@outlook.com
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include "json_reader.h"
+#include "triple_store.h"
+#include "log.h"
+
+namespace fsaverage
+{
+// Intern relation triple JSON files into one binary triple store that QueryTriples maps instead of parsing.
+
+namespace
+{
+
+struct Options
+{
+    std::vector<std::filesystem::path> inputs;
+    std::filesystem::path output{"relation_triples.data"};
+};
+
+bool parseOptions(int argc, char* argv[], Options& options) noexcept
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (argument == "--output" && i + 1 < argc)
+        {
+            options.output = argv[++i];
+        }
+        else if (argument.find("--") == 0U)
+        {
+            return false;
+        }
+        else
+        {
+            options.inputs.emplace_back(argument);
+        }
+    }
+    return !options.inputs.empty();
+}
+
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    using namespace fsaverage;
+
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        std::cout << "Using [BuildTriples] [--output file] [json file]..." << std::endl;
+        std::cout << "Accepts relation_triples*.json, relations.json and location_relations/*.json layouts; "
+                     "the output defaults to relation_triples.data." << std::endl;
+        return 0;
+    }
+
+    std::vector<NameTriple> triples;
+    for (auto& path : options.inputs)
+    {
+        auto document = JsonValue::load(path);
+        if (document.empty() || !readTriples(document, triples))
+        {
+            return 1;
+        }
+    }
+
+    auto store = TripleStore::build(triples);
+    if (store.empty() || !store.save(options.output))
+    {
+        return 1;
+    }
+    logInfo() << "Save " << store.size() << " triples over " << store.termCount() << " terms to "
+              << std::filesystem::absolute(options.output);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,246 @@
+// Author: cute-giggle@outlook.com
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <set>
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+
+#include "surface.h"
+#include "annotation.h"
+#include "region_boundary.h"
+#include "json_writer.h"
+#include "relation_triples.h"
+#include "log.h"
+
+namespace fsaverage
+{
+// Write [atlas]-adjacency.json (bordering regions and border length) and [atlas]-boundary.json (boundary
+// vertices of every region) for every given annotation on one surface. Regions take the display names of
+// --names, as in ComputeOverlap, so the border triples join the existing relation triples.
+
+namespace
+{
+
+constexpr const char* BORDER_RELATION = "border";
+
+struct Options
+{
+    std::filesystem::path surface;
+    std::vector<std::filesystem::path> annotations;
+    std::filesystem::path outputDirectory{"."};
+    std::filesystem::path triples;
+    std::set<std::string> ignore{"unknown", "???"};
+    RegionNames names;
+};
+
+bool parseOptions(int argc, char* argv[], Options& options) noexcept
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (argument == "--output" && i + 1 < argc)
+        {
+            options.outputDirectory = argv[++i];
+        }
+        else if (argument == "--triples" && i + 1 < argc)
+        {
+            options.triples = argv[++i];
+        }
+        else if (argument == "--ignore" && i + 1 < argc)
+        {
+            options.ignore.emplace(argv[++i]);
+        }
+        else if (argument == "--names" && i + 1 < argc)
+        {
+            if (!options.names.load(argv[++i]))
+            {
+                return false;
+            }
+        }
+        else if (argument.find("--") == 0U)
+        {
+            return false;
+        }
+        else if (options.surface.empty())
+        {
+            options.surface = argument;
+        }
+        else
+        {
+            options.annotations.emplace_back(argument);
+        }
+    }
+    return !options.annotations.empty();
+}
+
+bool writeAdjacency(const std::filesystem::path& path, const std::vector<ColorTableItem>& colorTable,
+    const BoundaryResult& result, const std::set<std::string>& ignore, const RegionNames& names) noexcept
+{
+    // every unordered pair once, under its smaller region, grouped by region like location_relations/*.json
+    std::vector<std::vector<const RegionBorder*>> byRegion(colorTable.size());
+    for (auto& border : result.borders)
+    {
+        if (border.first < colorTable.size() && border.second < colorTable.size()
+            && !ignore.count(colorTable[border.first].name) && !ignore.count(colorTable[border.second].name))
+        {
+            byRegion[std::min(border.first, border.second)].emplace_back(&border);
+        }
+    }
+
+    std::ofstream output(path);
+    if (!output.is_open())
+    {
+        logError() << "Open " << path << " failed!";
+        return false;
+    }
+    JsonWriter writer(output);
+    writer.beginObject();
+    for (uint32_t region = 0U; region < byRegion.size(); ++region)
+    {
+        if (byRegion[region].empty())
+        {
+            continue;
+        }
+        writer.key(names.lookup(colorTable[region].name));
+        writer.beginObject();
+        for (auto* border : byRegion[region])
+        {
+            writer.key(names.lookup(colorTable[border->first == region ? border->second : border->first].name));
+            writer.beginObject();
+            writer.key("length");
+            writer.value(border->length);
+            writer.key("forward");
+            writer.value(BORDER_RELATION);
+            writer.key("backward");
+            writer.value(BORDER_RELATION);
+            writer.endObject();
+        }
+        writer.endObject();
+    }
+    writer.endObject();
+    logInfo() << "Save adjacency to " << std::filesystem::absolute(path);
+    return true;
+}
+
+bool writeBoundary(const std::filesystem::path& path, const std::vector<ColorTableItem>& colorTable,
+    Span<const uint32_t> labelIndex, const BoundaryResult& result, const std::set<std::string>& ignore,
+    const RegionNames& names) noexcept
+{
+    std::vector<std::vector<uint32_t>> byRegion(colorTable.size());
+    for (uint32_t vertex : result.boundaryVertex)
+    {
+        if (labelIndex[vertex] < colorTable.size())
+        {
+            byRegion[labelIndex[vertex]].emplace_back(vertex);
+        }
+    }
+
+    // vertex lists are long, so this one is compact
+    std::ofstream output(path);
+    if (!output.is_open())
+    {
+        logError() << "Open " << path << " failed!";
+        return false;
+    }
+    JsonWriter writer(output, 0);
+    writer.beginObject();
+    for (std::size_t region = 0U; region < byRegion.size(); ++region)
+    {
+        if (byRegion[region].empty() || ignore.count(colorTable[region].name))
+        {
+            continue;
+        }
+        writer.key(names.lookup(colorTable[region].name));
+        writer.beginArray();
+        for (uint32_t vertex : byRegion[region])
+        {
+            writer.value(vertex);
+        }
+        writer.endArray();
+    }
+    writer.endObject();
+    logInfo() << "Save boundary to " << std::filesystem::absolute(path);
+    return true;
+}
+
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    using namespace fsaverage;
+
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        std::cout << "Using [ComputeBoundary] [--output directory] [--triples file] [--ignore region name]... "
+                     "[--names region names file]... [surface file] [annotation file]..." << std::endl;
+        return 0;
+    }
+
+    auto surface = SurfaceView::open(options.surface);
+    if (surface.empty())
+    {
+        return 1;
+    }
+
+    RelationTripleWriter triples;
+    if (!options.triples.empty() && !triples.open(options.triples))
+    {
+        return 1;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(options.outputDirectory, error);
+    if (error)
+    {
+        logError() << "Create directory " << options.outputDirectory << " failed!";
+        return 1;
+    }
+    for (auto& path : options.annotations)
+    {
+        auto annotation = AnnotationView::open(path);
+        if (annotation.empty())
+        {
+            return 1;
+        }
+        if (annotation.labelIndex.size() != surface.point.size() / 3U)
+        {
+            logError() << "Annotation " << path << " is not defined on surface " << options.surface << "!";
+            return 1;
+        }
+        auto result = computeBoundary(surface.point, surface.face, annotation.labelIndex);
+
+        auto atlas = atlasName(path);
+        if (!writeAdjacency(options.outputDirectory / (atlas + "-adjacency.json"), annotation.colorTable, result, options.ignore, options.names)
+            || !writeBoundary(options.outputDirectory / (atlas + "-boundary.json"), annotation.colorTable, annotation.labelIndex,
+                   result, options.ignore, options.names))
+        {
+            return 1;
+        }
+
+        if (triples.isOpen())
+        {
+            auto& colorTable = annotation.colorTable;
+            for (auto& border : result.borders)
+            {
+                if (border.first < colorTable.size() && border.second < colorTable.size()
+                    && !options.ignore.count(colorTable[border.first].name) && !options.ignore.count(colorTable[border.second].name))
+                {
+                    auto& firstName = options.names.lookup(colorTable[border.first].name);
+                    auto& secondName = options.names.lookup(colorTable[border.second].name);
+                    triples.write(firstName, BORDER_RELATION, secondName);
+                    triples.write(secondName, BORDER_RELATION, firstName);
+                }
+            }
+        }
+    }
+
+    triples.close();
+    return 0;
+}
\ No newline at end of file
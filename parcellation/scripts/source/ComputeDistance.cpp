@@ -0,0 +1,214 @@
+// Author: cute-giggle@outlook.com
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <set>
+#include <cstdint>
+#include <cstdlib>
+#include <cmath>
+#include <filesystem>
+
+#include "surface.h"
+#include "annotation.h"
+#include "mesh_topology.h"
+#include "region_index.h"
+#include "geodesic.h"
+#include "json_writer.h"
+#include "relation_triples.h"
+#include "log.h"
+
+namespace fsaverage
+{
+// Write [atlas]-distance.json with the geodesic distance between every pair of regions of every given
+// annotation on one surface, in the layout of location_relations/*.json. Regions take the display names of
+// --names, as in ComputeOverlap.
+
+namespace
+{
+
+constexpr const char* NEAR_RELATION = "near";
+constexpr const char* FAR_RELATION = "far";
+
+struct Options
+{
+    std::filesystem::path surface;
+    std::vector<std::filesystem::path> annotations;
+    std::filesystem::path outputDirectory{"."};
+    std::filesystem::path triples;
+    std::set<std::string> ignore{"unknown", "???"};
+    RegionNames names;
+    float near = 10.f;
+    float maxDistance = std::numeric_limits<float>::infinity();
+    std::size_t threadCount = std::thread::hardware_concurrency();
+};
+
+bool parseOptions(int argc, char* argv[], Options& options) noexcept
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (argument == "--output" && i + 1 < argc)
+        {
+            options.outputDirectory = argv[++i];
+        }
+        else if (argument == "--triples" && i + 1 < argc)
+        {
+            options.triples = argv[++i];
+        }
+        else if (argument == "--ignore" && i + 1 < argc)
+        {
+            options.ignore.emplace(argv[++i]);
+        }
+        else if (argument == "--names" && i + 1 < argc)
+        {
+            if (!options.names.load(argv[++i]))
+            {
+                return false;
+            }
+        }
+        else if (argument == "--near" && i + 1 < argc)
+        {
+            options.near = std::strtof(argv[++i], nullptr);
+        }
+        else if (argument == "--max-distance" && i + 1 < argc)
+        {
+            options.maxDistance = std::strtof(argv[++i], nullptr);
+        }
+        else if (argument == "--threads" && i + 1 < argc)
+        {
+            options.threadCount = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (argument.find("--") == 0U)
+        {
+            return false;
+        }
+        else if (options.surface.empty())
+        {
+            options.surface = argument;
+        }
+        else
+        {
+            options.annotations.emplace_back(argument);
+        }
+    }
+    return !options.annotations.empty();
+}
+
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    using namespace fsaverage;
+
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        std::cout << "Using [ComputeDistance] [--output directory] [--triples file] [--near mm] [--max-distance mm] "
+                     "[--threads count] [--ignore region name]... [--names region names file]... [surface file] [annotation file]..." << std::endl;
+        std::cout << "Pairs closer than --near (default 10) are 'near', the others 'far'; pairs beyond --max-distance "
+                     "(default unbounded) are left out and make the search cheaper." << std::endl;
+        return 0;
+    }
+
+    auto surface = SurfaceView::open(options.surface);
+    if (surface.empty())
+    {
+        return 1;
+    }
+    auto topology = MeshTopology::load(surface);
+    auto edgeLength = computeEdgeLength(surface.point, topology);
+    if (topology.empty() || edgeLength.empty())
+    {
+        return 1;
+    }
+
+    RelationTripleWriter triples;
+    if (!options.triples.empty() && !triples.open(options.triples))
+    {
+        return 1;
+    }
+
+    std::filesystem::create_directories(options.outputDirectory);
+    for (auto& path : options.annotations)
+    {
+        auto annotation = AnnotationView::open(path);
+        if (annotation.empty())
+        {
+            return 1;
+        }
+        if (annotation.labelIndex.size() != topology.vertexCount())
+        {
+            logError() << "Annotation " << path << " is not defined on surface " << options.surface << "!";
+            return 1;
+        }
+
+        auto& colorTable = annotation.colorTable;
+        std::vector<bool> source(colorTable.size());
+        for (std::size_t region = 0U; region < colorTable.size(); ++region)
+        {
+            source[region] = !options.ignore.count(colorTable[region].name);
+        }
+        auto regions = RegionIndex::load(annotation);
+        auto result = computeRegionDistance(topology, {edgeLength.data(), edgeLength.size()}, regions, annotation.labelIndex,
+            source, options.maxDistance, options.threadCount);
+        if (result.empty())
+        {
+            return 1;
+        }
+
+        // every unordered pair once, under its smaller region
+        auto output = options.outputDirectory / (atlasName(path) + "-distance.json");
+        std::ofstream stream(output);
+        JsonWriter writer(stream);
+        writer.beginObject();
+        for (uint32_t first = 0U; first < colorTable.size(); ++first)
+        {
+            bool opened = false;
+            for (uint32_t second = first + 1U; second < colorTable.size(); ++second)
+            {
+                float distance = std::min(result.at(first, second), result.at(second, first));
+                if (!std::isfinite(distance))
+                {
+                    continue;
+                }
+                if (!opened)
+                {
+                    writer.key(options.names.lookup(colorTable[first].name));
+                    writer.beginObject();
+                    opened = true;
+                }
+                const char* relation = distance <= options.near ? NEAR_RELATION : FAR_RELATION;
+                writer.key(options.names.lookup(colorTable[second].name));
+                writer.beginObject();
+                writer.key("distance");
+                writer.value(static_cast<double>(distance));
+                writer.key("forward");
+                writer.value(relation);
+                writer.key("backward");
+                writer.value(relation);
+                writer.endObject();
+
+                if (triples.isOpen() && relation == NEAR_RELATION)
+                {
+                    auto& firstName = options.names.lookup(colorTable[first].name);
+                    auto& secondName = options.names.lookup(colorTable[second].name);
+                    triples.write(firstName, relation, secondName);
+                    triples.write(secondName, relation, firstName);
+                }
+            }
+            if (opened)
+            {
+                writer.endObject();
+            }
+        }
+        writer.endObject();
+        logInfo() << "Save distance to " << std::filesystem::absolute(output);
+    }
+
+    triples.close();
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,213 @@
+// Author: cute-giggle@outlook.com
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <cstdint>
+#include <filesystem>
+
+#include "annotation.h"
+#include "overlap.h"
+#include "vertex_area.h"
+#include "json_writer.h"
+#include "relation_triples.h"
+#include "log.h"
+
+namespace fsaverage
+{
+// Write location_relations/[first]-[second].json for every pair of the given annotations, with the region
+// display names of --names and the file names of --alias, e.g.
+//     ComputeOverlap --names ../aparc/aparc_region_names_mapping.json --alias PALS_B12_Brodmann brodmann
+//         --alias Schaefer2018_400Parcels_7Networks_order shaefer-400-7 [aparc] [brodmann] [shaefer]
+// for the layout of the checked-in location_relations files.
+
+namespace
+{
+
+struct Options
+{
+    std::vector<std::filesystem::path> annotations;
+    std::filesystem::path outputDirectory{"."};
+    std::filesystem::path triples;
+    std::filesystem::path area;
+    std::set<std::string> ignore{"unknown", "???"};
+    RegionNames names;
+    std::map<std::string, std::string> alias;
+};
+
+bool parseOptions(int argc, char* argv[], Options& options) noexcept
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (argument == "--output" && i + 1 < argc)
+        {
+            options.outputDirectory = argv[++i];
+        }
+        else if (argument == "--triples" && i + 1 < argc)
+        {
+            options.triples = argv[++i];
+        }
+        else if (argument == "--area" && i + 1 < argc)
+        {
+            options.area = argv[++i];
+        }
+        else if (argument == "--ignore" && i + 1 < argc)
+        {
+            options.ignore.emplace(argv[++i]);
+        }
+        else if (argument == "--names" && i + 1 < argc)
+        {
+            if (!options.names.load(argv[++i]))
+            {
+                return false;
+            }
+        }
+        else if (argument == "--alias" && i + 2 < argc)
+        {
+            options.alias[argv[i + 1]] = argv[i + 2];
+            i += 2;
+        }
+        else if (argument.find("--") == 0U)
+        {
+            return false;
+        }
+        else
+        {
+            options.annotations.emplace_back(argument);
+        }
+    }
+    return options.annotations.size() >= 2U;
+}
+
+// Name of an atlas in output file names, its --alias if given.
+std::string outputName(const Options& options, const std::filesystem::path& annotation) noexcept
+{
+    auto name = atlasName(annotation);
+    auto iter = options.alias.find(name);
+    return iter == options.alias.end() ? name : iter->second;
+}
+
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    using namespace fsaverage;
+
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        std::cout << "Using [ComputeOverlap] [--output directory] [--triples file] [--area surface file] [--ignore region name]... "
+                     "[--names region names file]... [--alias atlas name output name]... [annotation file] [annotation file]..." << std::endl;
+        std::cout << "--names reads display names from a JSON object like aparc_region_names_mapping.json, --alias names the "
+                     "output files of an atlas, e.g. --alias PALS_B12_Brodmann brodmann." << std::endl;
+        return 0;
+    }
+
+    std::vector<AnnotationView> views;
+    std::vector<OverlapInput> inputs;
+    for (auto& path : options.annotations)
+    {
+        views.emplace_back(AnnotationView::open(path));
+        if (views.back().empty())
+        {
+            return 1;
+        }
+    }
+    for (auto& view : views)
+    {
+        inputs.emplace_back(OverlapInput{view.labelIndex, view.colorTable.size()});
+    }
+
+    // weight every vertex by its share of the surface area instead of counting vertices
+    SurfaceView surface;
+    VertexArea area;
+    if (!options.area.empty())
+    {
+        surface = SurfaceView::open(options.area);
+        area = surface.empty() ? VertexArea{} : VertexArea::load(surface);
+        if (area.empty())
+        {
+            return 1;
+        }
+    }
+
+    auto result = computeOverlap(inputs, area.area);
+    if (result.regionSize.empty())
+    {
+        return 1;
+    }
+
+    RelationTripleWriter triples;
+    if (!options.triples.empty() && !triples.open(options.triples))
+    {
+        return 1;
+    }
+
+    std::filesystem::create_directories(options.outputDirectory);
+    for (auto& pair : result.pairs)
+    {
+        auto& first = views[pair.first].colorTable;
+        auto& second = views[pair.second].colorTable;
+        auto path = options.outputDirectory / (outputName(options, options.annotations[pair.first]) + "-"
+            + outputName(options, options.annotations[pair.second]) + ".json");
+        std::ofstream output(path);
+        JsonWriter writer(output);
+        writer.beginObject();
+        std::size_t current = SIZE_MAX;
+        for (auto& entry : pair.entries)
+        {
+            if (options.ignore.count(first[entry.first].name) || options.ignore.count(second[entry.second].name))
+            {
+                continue;
+            }
+            if (entry.first != current)
+            {
+                if (current != SIZE_MAX)
+                {
+                    writer.endObject();
+                }
+                writer.key(options.names.lookup(first[entry.first].name));
+                writer.beginObject();
+                current = entry.first;
+            }
+
+            double with1 = entry.size / result.regionSize[pair.first][entry.first];
+            double with2 = entry.size / result.regionSize[pair.second][entry.second];
+            auto relation = classifyOverlap(with1, with2);
+            writer.key(options.names.lookup(second[entry.second].name));
+            writer.beginObject();
+            writer.key("with1");
+            writer.value(with1);
+            writer.key("with2");
+            writer.value(with2);
+            writer.key("forward");
+            writer.value(relation.forward);
+            writer.key("backward");
+            writer.value(relation.backward);
+            writer.endObject();
+
+            if (triples.isOpen())
+            {
+                auto& firstName = options.names.lookup(first[entry.first].name);
+                auto& secondName = options.names.lookup(second[entry.second].name);
+                triples.write(firstName, relation.forward, secondName);
+                triples.write(secondName, relation.backward, firstName);
+            }
+        }
+        if (current != SIZE_MAX)
+        {
+            writer.endObject();
+        }
+        writer.endObject();
+        logInfo() << "Save overlap to " << std::filesystem::absolute(path);
+    }
+
+    triples.close();
+    return 0;
+}
\ No newline at end of file
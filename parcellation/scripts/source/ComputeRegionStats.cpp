@@ -0,0 +1,296 @@
+// Author: cute-giggle@outlook.com
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+
+#include "annotation.h"
+#include "overlay.h"
+#include "region_index.h"
+#include "region_stats.h"
+#include "vertex_area.h"
+#include "thread_pool.h"
+#include "log.h"
+
+namespace fsaverage
+{
+// Statistics of many per-vertex overlays over every region of one or more annotations, as one TSV table.
+
+namespace
+{
+
+struct OverlayJob
+{
+    std::string name;
+    std::filesystem::path lpath;
+    std::filesystem::path rpath;
+};
+
+struct Options
+{
+    std::vector<std::filesystem::path> annotations;
+    std::vector<OverlayJob> overlays;
+    std::vector<double> percentiles;
+    std::filesystem::path output{"region_stats.tsv"};
+    std::filesystem::path area;
+    std::size_t frame = 0U;
+    std::size_t threadCount = std::thread::hardware_concurrency();
+    std::size_t memoryBudget = std::size_t{1024U} << 20U;
+};
+
+void usage() noexcept
+{
+    std::cout << "Using [ComputeRegionStats] [options] --annotation [file]... [left overlay] [right overlay]..." << std::endl;
+    std::cout << "Overlays are FreeSurfer curv files ([lh/rh].thickness, ...) or .mgh files with one value per vertex," << std::endl;
+    std::cout << "on the surface of the annotations (e.g. [lh/rh].thickness.fsaverage.mgh)." << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "    --annotation [file]  annotation data file, repeat for several atlases" << std::endl;
+    std::cout << "    --manifest [file]    overlay list, lines of [name] [left overlay] [right overlay], '#' starts a comment" << std::endl;
+    std::cout << "    --output [file]      TSV table, default region_stats.tsv" << std::endl;
+    std::cout << "    --area [file]        surface data file, weight every vertex by its area" << std::endl;
+    std::cout << "    --percentile [p]     percentile in [0, 100], repeat for several, default 25 50 75" << std::endl;
+    std::cout << "    --frame [index]      frame of multi-frame .mgh overlays, default 0" << std::endl;
+    std::cout << "    --threads [count]    overlays in flight, default hardware concurrency" << std::endl;
+    std::cout << "    --memory [MB]        bound of memory held by overlays in flight, default 1024" << std::endl;
+    std::cout << "Rows are written as overlays finish, so their order follows completion." << std::endl;
+}
+
+// lh.thickness.fsaverage.mgh -> thickness.fsaverage
+std::string overlayName(const std::filesystem::path& path) noexcept
+{
+    auto name = path.filename().string();
+    name = name.find("lh.") == 0U ? name.substr(3U) : name;
+    return path.extension() == ".mgh" ? name.substr(0U, name.size() - 4U) : name;
+}
+
+bool readManifest(const std::filesystem::path& path, std::vector<OverlayJob>& overlays) noexcept
+{
+    std::ifstream input(path);
+    if (!input.is_open())
+    {
+        logError() << "Open " << path << " failed!";
+        return false;
+    }
+
+    std::string line;
+    for (std::size_t number = 1U; std::getline(input, line); ++number)
+    {
+        std::istringstream stream(line.substr(0U, line.find('#')));
+        std::string name, lpath, rpath;
+        if (!(stream >> name))
+        {
+            continue;
+        }
+        if (!(stream >> lpath >> rpath))
+        {
+            logError() << "Line " << number << " of " << path << " should be [name] [left overlay] [right overlay]!";
+            return false;
+        }
+        overlays.emplace_back(OverlayJob{name, lpath, rpath});
+    }
+    return true;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) noexcept
+{
+    std::vector<std::filesystem::path> positional;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (argument == "--annotation" && i + 1 < argc)
+        {
+            options.annotations.emplace_back(argv[++i]);
+        }
+        else if (argument == "--manifest" && i + 1 < argc)
+        {
+            if (!readManifest(argv[++i], options.overlays))
+            {
+                return false;
+            }
+        }
+        else if (argument == "--output" && i + 1 < argc)
+        {
+            options.output = argv[++i];
+        }
+        else if (argument == "--area" && i + 1 < argc)
+        {
+            options.area = argv[++i];
+        }
+        else if (argument == "--percentile" && i + 1 < argc)
+        {
+            options.percentiles.emplace_back(std::atof(argv[++i]));
+        }
+        else if (argument == "--frame" && i + 1 < argc)
+        {
+            options.frame = static_cast<std::size_t>(std::max(std::atoi(argv[++i]), 0));
+        }
+        else if (argument == "--threads" && i + 1 < argc)
+        {
+            options.threadCount = static_cast<std::size_t>(std::max(std::atoi(argv[++i]), 1));
+        }
+        else if (argument == "--memory" && i + 1 < argc)
+        {
+            options.memoryBudget = static_cast<std::size_t>(std::max(std::atoi(argv[++i]), 1)) << 20U;
+        }
+        else if (argument.find("--") == 0U)
+        {
+            return false;
+        }
+        else
+        {
+            positional.emplace_back(argument);
+        }
+    }
+    if (positional.size() % 2U != 0U)
+    {
+        return false;
+    }
+    for (std::size_t i = 0U; i < positional.size(); i += 2U)
+    {
+        options.overlays.emplace_back(OverlayJob{overlayName(positional[i]), positional[i], positional[i + 1U]});
+    }
+    if (options.percentiles.empty())
+    {
+        options.percentiles = {25.0, 50.0, 75.0};
+    }
+    return !options.annotations.empty() && !options.overlays.empty();
+}
+
+struct Atlas
+{
+    std::string name;
+    AnnotationView view;
+    RegionIndex index;
+};
+
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    using namespace fsaverage;
+
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        usage();
+        return 1;
+    }
+
+    // the atlases and their region indices are shared by every overlay
+    std::vector<Atlas> atlases;
+    for (auto& path : options.annotations)
+    {
+        Atlas atlas{atlasName(path), AnnotationView::open(path), {}};
+        if (atlas.view.empty())
+        {
+            return 1;
+        }
+        atlas.index = RegionIndex::load(atlas.view);
+        if (!atlases.empty() && atlas.view.labelIndex.size() != atlases[0].view.labelIndex.size())
+        {
+            logError() << "Annotations must be defined on the same surface!";
+            return 1;
+        }
+        atlases.emplace_back(std::move(atlas));
+    }
+    std::size_t vertexCount = atlases[0].view.labelIndex.size();
+
+    SurfaceView surface;
+    VertexArea area;
+    if (!options.area.empty())
+    {
+        surface = SurfaceView::open(options.area);
+        area = surface.empty() ? VertexArea{} : VertexArea::load(surface);
+        if (area.empty())
+        {
+            return 1;
+        }
+    }
+
+    std::ofstream output(options.output);
+    if (!output.is_open())
+    {
+        logError() << "Open " << options.output << " failed!";
+        return 1;
+    }
+    output << "overlay\tatlas\tregion\tcount\tweight\tmean\tstd\tmin\tmax";
+    for (double percentile : options.percentiles)
+    {
+        output << "\tp" << percentile;
+    }
+    output << '\n';
+
+    // one overlay per task: its values, the gathered region values and the rows are all it holds, so memory
+    // stays bounded by the tasks in flight however many overlays there are
+    std::mutex outputMutex;
+    std::atomic<std::size_t> computed{0U};
+    std::atomic<std::size_t> failed{0U};
+    MemoryBudget budget(options.memoryBudget);
+    std::size_t kernelThreads = options.threadCount == 1U ? std::thread::hardware_concurrency() : 1U;
+    auto start = std::chrono::steady_clock::now();
+    {
+        ThreadPool pool(options.threadCount);
+        for (auto& job : options.overlays)
+        {
+            pool.submit([&]()
+            {
+                std::size_t held = budget.acquire(vertexCount * sizeof(float) * 3U);
+                std::vector<float> value;
+                bool valid = Overlay::read(job.lpath, job.rpath, options.frame, value);
+                if (valid && value.size() != vertexCount)
+                {
+                    logError() << "Overlay " << job.name << " has " << value.size() << " vertices, the annotations " << vertexCount << "!";
+                    valid = false;
+                }
+
+                std::ostringstream rows;
+                rows << std::setprecision(7);
+                for (auto& atlas : atlases)
+                {
+                    auto statistics = valid ? computeRegionStatistics(atlas.index, {value.data(), value.size()}, area.area,
+                        options.percentiles, kernelThreads) : std::vector<RegionStatistics>();
+                    valid = valid && !statistics.empty();
+                    for (std::size_t region = 0U; region < statistics.size(); ++region)
+                    {
+                        auto& item = statistics[region];
+                        rows << job.name << '\t' << atlas.name << '\t' << atlas.view.colorTable[region].name << '\t' << item.count
+                             << '\t' << item.weight << '\t' << item.mean << '\t' << item.deviation << '\t' << item.min << '\t' << item.max;
+                        for (float percentile : item.percentile)
+                        {
+                            rows << '\t' << percentile;
+                        }
+                        rows << '\n';
+                    }
+                }
+                budget.release(held);
+
+                if (!valid)
+                {
+                    logError() << "Compute statistics of " << job.lpath << " and " << job.rpath << " failed!";
+                    failed.fetch_add(1U);
+                    return;
+                }
+                std::lock_guard<std::mutex> lock(outputMutex);
+                output << rows.str();
+                computed.fetch_add(1U);
+            });
+        }
+        pool.wait();
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    logInfo() << "Computed " << computed.load() << ", failed " << failed.load() << " in " << std::fixed << std::setprecision(3) << seconds << " s";
+    logInfo() << "Save region statistics to " << std::filesystem::absolute(options.output);
+    return failed.load() == 0U ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,122 @@
+// Author: cute-giggle@outlook.com
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include "surface.h"
+#include "annotation.h"
+#include "decimation.h"
+#include "log.h"
+
+namespace fsaverage
+{
+// Decimate a surface data file into fsaverage5/6-like levels of detail, with the labels of an annotation,
+// and write them all to one file for fast previews and coarse-level queries.
+
+namespace
+{
+
+struct Options
+{
+    std::filesystem::path surface;
+    std::filesystem::path annotation;
+    std::filesystem::path output;
+    std::vector<std::size_t> vertexCounts;
+};
+
+bool parseOptions(int argc, char* argv[], Options& options) noexcept
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (argument == "--level" && i + 1 < argc)
+        {
+            // both hemispheres of fsaverage[order]
+            options.vertexCounts.emplace_back(2U * icosahedronVertexCount(std::stoul(argv[++i])));
+        }
+        else if (argument == "--vertices" && i + 1 < argc)
+        {
+            options.vertexCounts.emplace_back(std::stoul(argv[++i]));
+        }
+        else if (argument == "--annotation" && i + 1 < argc)
+        {
+            options.annotation = argv[++i];
+        }
+        else if (argument == "--output" && i + 1 < argc)
+        {
+            options.output = argv[++i];
+        }
+        else if (argument.find("--") == 0U || !options.surface.empty())
+        {
+            return false;
+        }
+        else
+        {
+            options.surface = argument;
+        }
+    }
+    if (options.vertexCounts.empty())
+    {
+        options.vertexCounts = {2U * icosahedronVertexCount(6U), 2U * icosahedronVertexCount(5U)};
+    }
+    if (options.output.empty())
+    {
+        options.output = surfaceLevelsFileName(options.surface);
+    }
+    return !options.surface.empty();
+}
+
+void usage() noexcept
+{
+    std::cout << "Using [DecimateSurface] [options] [surface file]" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "    --level [order]      vertex count of fsaverage[order] (both hemispheres), repeat for several, default 6 5" << std::endl;
+    std::cout << "    --vertices [n]       vertex count of a level, repeat for several" << std::endl;
+    std::cout << "    --annotation [file]  annotation data file on the surface, carry its labels to every level" << std::endl;
+    std::cout << "    --output [file]      default [surface].lod.data" << std::endl;
+}
+
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    using namespace fsaverage;
+
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        usage();
+        return 0;
+    }
+
+    auto surface = SurfaceView::open(options.surface);
+    if (surface.empty())
+    {
+        return 1;
+    }
+    AnnotationView annotation;
+    if (!options.annotation.empty())
+    {
+        annotation = AnnotationView::open(options.annotation);
+        if (annotation.empty())
+        {
+            return 1;
+        }
+        if (annotation.labelIndex.size() != surface.point.size() / 3U)
+        {
+            logError() << "Annotation " << options.annotation << " is not defined on surface " << options.surface << "!";
+            return 1;
+        }
+    }
+
+    auto levels = decimateSurface(surface.point, surface.face, options.vertexCounts, annotation.labelIndex);
+    if (levels.empty() || !save(options.output, surface.point, surface.face, annotation.labelIndex, levels))
+    {
+        return 1;
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+// Author: cute-giggle@outlook.com
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include "json_reader.h"
+#include "triple_store.h"
+#include "graph_export.h"
+#include "log.h"
+
+namespace fsaverage
+{
+// Bulk export of relation triples for `neo4j-admin database import`, replacing the per-triple MERGE of
+// neo4j/insert_relation_triples.py.
+
+namespace
+{
+
+struct Options
+{
+    std::vector<std::filesystem::path> inputs;
+    std::filesystem::path outputDirectory{"."};
+};
+
+bool parseOptions(int argc, char* argv[], Options& options) noexcept
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (argument == "--output" && i + 1 < argc)
+        {
+            options.outputDirectory = argv[++i];
+        }
+        else if (argument.find("--") == 0U)
+        {
+            return false;
+        }
+        else
+        {
+            options.inputs.emplace_back(argument);
+        }
+    }
+    return !options.inputs.empty();
+}
+
+// A store written by BuildTriples is mapped as is; JSON files are interned into a new one.
+TripleStore loadStore(const std::vector<std::filesystem::path>& inputs) noexcept
+{
+    if (inputs.size() == 1U && inputs[0].extension() == ".data")
+    {
+        return TripleStore::open(inputs[0]);
+    }
+
+    std::vector<NameTriple> triples;
+    for (auto& path : inputs)
+    {
+        auto document = JsonValue::load(path);
+        if (document.empty() || !readTriples(document, triples))
+        {
+            return {};
+        }
+    }
+    return TripleStore::build(triples);
+}
+
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    using namespace fsaverage;
+
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        std::cout << "Using [ExportGraph] [--output directory] [triple store file]" << std::endl;
+        std::cout << "      [ExportGraph] [--output directory] [json file]..." << std::endl;
+        std::cout << "Writes " << NEO4J_ENTITY_FILE << " and " << NEO4J_RELATION_FILE << ", to be loaded with "
+                     "neo4j-admin database import full --nodes=" << NEO4J_ENTITY_FILE << " --relationships="
+                  << NEO4J_RELATION_FILE << " [database]." << std::endl;
+        return 0;
+    }
+
+    auto store = loadStore(options.inputs);
+    if (store.empty() || !exportNeo4jImport(store, options.outputDirectory))
+    {
+        return 1;
+    }
+    logInfo() << "Save " << store.size() << " relations to " << std::filesystem::absolute(options.outputDirectory);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,383 @@
+// Author: cute-giggle@outlook.com
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include <filesystem>
+
+#include "freesurfer.h"
+#include "mapped_file.h"
+#include "thread_pool.h"
+#include "log.h"
+#include "metrics.h"
+
+namespace fsaverage
+{
+// Batch conversion of many FreeSurfer lh/rh pairs, see usage() for the command line.
+
+namespace
+{
+
+enum class JobKind
+{
+    Surface,
+    Annotation,
+};
+
+struct Job
+{
+    JobKind kind;
+    std::filesystem::path lpath;
+    std::filesystem::path rpath;
+    std::filesystem::path output;
+};
+
+struct Options
+{
+    std::vector<Job> jobs;
+    std::size_t threadCount = std::thread::hardware_concurrency();
+    std::size_t memoryBudget = std::size_t{1024U} << 20U;
+    std::filesystem::path metrics;
+    bool hash = false;
+    bool force = false;
+    bool index = false;
+};
+
+void usage() noexcept
+{
+    std::cout << "Using [fsconvert] [options] --manifest [file]" << std::endl;
+    std::cout << "      [fsconvert] [options] --tree [subjects directory] [output directory]" << std::endl;
+    std::cout << "Manifest lines: [surface/annotation] [left file] [right file] [output file], '#' starts a comment." << std::endl;
+    std::cout << "Tree layout: [subject]/surf/[lh/rh].[orig/white/pial/inflated/sphere/sphere.reg] and [subject]/label/[lh/rh].xxx.annot," << std::endl;
+    std::cout << "             written to [output directory]/[subject]/[surface/annotation].xxx.data." << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "    --threads [count]    worker threads, default hardware concurrency" << std::endl;
+    std::cout << "    --memory [MB]        bound of memory held by conversions in flight, default 1024" << std::endl;
+    std::cout << "    --hash               decide whether an output is up to date by input content hash instead of mtime" << std::endl;
+    std::cout << "    --force              convert even when outputs are up to date" << std::endl;
+    std::cout << "    --metrics [file]     write the per-stage time and byte counters as JSON" << std::endl;
+    std::cout << "    --index              also store the region index of annotations and the area, topology and spatial index of surfaces" << std::endl;
+    std::cout << "Diagnostics go to stderr, FSAVERAGE_LOG=[debug/info/warning/error/off] sets how many, default info." << std::endl;
+}
+
+bool readManifest(const std::filesystem::path& path, std::vector<Job>& jobs) noexcept
+{
+    std::ifstream input(path);
+    if (!input.is_open())
+    {
+        logError() << "Open " << path << " failed!";
+        return false;
+    }
+
+    std::string line;
+    for (std::size_t number = 1U; std::getline(input, line); ++number)
+    {
+        std::istringstream stream(line.substr(0U, line.find('#')));
+        std::string kind, lpath, rpath, output;
+        if (!(stream >> kind))
+        {
+            continue;
+        }
+        if (!(stream >> lpath >> rpath >> output) || (kind != "surface" && kind != "annotation"))
+        {
+            logError() << "Invalid manifest line " << number << ": " << line;
+            return false;
+        }
+        jobs.emplace_back(Job{kind == "surface" ? JobKind::Surface : JobKind::Annotation, lpath, rpath, output});
+    }
+    return true;
+}
+
+bool scanTree(const std::filesystem::path& subjects, const std::filesystem::path& outputs, std::vector<Job>& jobs) noexcept
+{
+    std::error_code error;
+    if (!std::filesystem::is_directory(subjects, error))
+    {
+        logError() << "Directory " << subjects << " does not exist!";
+        return false;
+    }
+
+    // iterate with error codes, an unreadable or vanishing entry is reported and skipped
+    std::filesystem::directory_iterator subject(subjects, error), end;
+    for (; !error && subject != end; subject.increment(error))
+    {
+        std::error_code entryError;
+        if (!subject->is_directory(entryError))
+        {
+            if (entryError)
+            {
+                logWarning() << "Skip " << subject->path() << ": " << entryError.message();
+            }
+            continue;
+        }
+        auto output = outputs / subject->path().filename();
+        for (auto* kind : {"orig", "white", "pial", "inflated", "sphere", "sphere.reg"})
+        {
+            auto lpath = subject->path() / "surf" / (std::string("lh.") + kind);
+            auto rpath = subject->path() / "surf" / (std::string("rh.") + kind);
+            if (std::filesystem::exists(lpath, entryError) && std::filesystem::exists(rpath, entryError))
+            {
+                jobs.emplace_back(Job{JobKind::Surface, lpath, rpath, output / surfaceDataFileName(lpath)});
+            }
+        }
+        std::filesystem::directory_iterator entry(subject->path() / "label", entryError);
+        for (; !entryError && entry != end; entry.increment(entryError))
+        {
+            auto name = entry->path().filename().string();
+            if (name.find("lh.") != 0U || entry->path().extension() != ".annot")
+            {
+                continue;
+            }
+            auto rpath = entry->path().parent_path() / ("rh." + name.substr(3U));
+            std::error_code existsError;
+            if (std::filesystem::exists(rpath, existsError))
+            {
+                jobs.emplace_back(Job{JobKind::Annotation, entry->path(), rpath, output / annotationDataFileName(entry->path())});
+            }
+        }
+        if (entryError && entryError != std::errc::no_such_file_or_directory)
+        {
+            logWarning() << "Skip the labels of " << subject->path() << ": " << entryError.message();
+        }
+    }
+    if (error)
+    {
+        logError() << "Read directory " << subjects << " failed: " << error.message();
+        return false;
+    }
+    return true;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) noexcept
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (argument == "--manifest" && i + 1 < argc)
+        {
+            if (!readManifest(argv[++i], options.jobs))
+            {
+                return false;
+            }
+        }
+        else if (argument == "--tree" && i + 2 < argc)
+        {
+            if (!scanTree(argv[i + 1], argv[i + 2], options.jobs))
+            {
+                return false;
+            }
+            i += 2;
+        }
+        else if (argument == "--threads" && i + 1 < argc)
+        {
+            options.threadCount = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (argument == "--memory" && i + 1 < argc)
+        {
+            options.memoryBudget = static_cast<std::size_t>(std::strtoul(argv[++i], nullptr, 10)) << 20U;
+        }
+        else if (argument == "--hash")
+        {
+            options.hash = true;
+        }
+        else if (argument == "--force")
+        {
+            options.force = true;
+        }
+        else if (argument == "--index")
+        {
+            options.index = true;
+        }
+        else if (argument == "--metrics" && i + 1 < argc)
+        {
+            options.metrics = argv[++i];
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return !options.jobs.empty();
+}
+
+// 64-bit FNV-1a over both inputs.
+std::string hashInputs(const Job& job) noexcept
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (auto* path : {&job.lpath, &job.rpath})
+    {
+        auto file = MappedFile::open(*path);
+        for (std::size_t i = 0U; i < file.size(); ++i)
+        {
+            hash = (hash ^ file.data()[i]) * 1099511628211ULL;
+        }
+    }
+    std::ostringstream stream;
+    stream << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return stream.str();
+}
+
+std::filesystem::path hashFilePath(const Job& job) noexcept
+{
+    return job.output.string() + ".hash";
+}
+
+bool isUpToDate(const Job& job, bool hash, std::string& inputHash) noexcept
+{
+    std::error_code error;
+    if (!std::filesystem::exists(job.output, error))
+    {
+        if (hash)
+        {
+            inputHash = hashInputs(job);
+        }
+        return false;
+    }
+
+    if (hash)
+    {
+        inputHash = hashInputs(job);
+        std::ifstream input(hashFilePath(job));
+        std::string savedHash;
+        return input >> savedHash && savedHash == inputHash;
+    }
+
+    // any time that cannot be read means the job needs converting
+    auto outputTime = std::filesystem::last_write_time(job.output, error);
+    if (error)
+    {
+        return false;
+    }
+    for (auto* path : {&job.lpath, &job.rpath})
+    {
+        auto inputTime = std::filesystem::last_write_time(*path, error);
+        if (error || inputTime > outputTime)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Size of an input for the memory estimate, 0 when it cannot be read; the loader then reports the error.
+uint64_t inputSize(const std::filesystem::path& path) noexcept
+{
+    std::error_code error;
+    auto size = std::filesystem::file_size(path, error);
+    return error ? 0U : static_cast<uint64_t>(size);
+}
+
+// Stage counters are summed over all jobs and threads, so the per thread rate is bytes over summed time.
+void report(std::size_t converted, std::size_t skipped, std::size_t failed, std::chrono::steady_clock::duration wall) noexcept
+{
+    double wallSeconds = std::chrono::duration<double>(wall).count();
+    logInfo() << "Converted " << converted << ", skipped " << skipped << ", failed " << failed
+              << " in " << std::fixed << std::setprecision(3) << wallSeconds << " s";
+    for (std::size_t i = 0U; i < STAGE_COUNT; ++i)
+    {
+        auto totals = stageTotals(static_cast<Stage>(i));
+        if (totals.count == 0U)
+        {
+            continue;
+        }
+        double megabytes = static_cast<double>(totals.bytes) / (1024.0 * 1024.0);
+        double seconds = static_cast<double>(totals.nanoseconds) * 1e-9;
+        logInfo() << "    " << std::left << std::setw(6) << stageName(static_cast<Stage>(i)) << std::right
+                  << std::fixed << std::setprecision(3)
+                  << std::setw(8) << totals.count << " calls "
+                  << std::setw(12) << megabytes << " MB "
+                  << std::setw(10) << seconds << " s thread time "
+                  << std::setw(10) << (seconds > 0.0 ? megabytes / seconds : 0.0) << " MB/s per thread "
+                  << std::setw(10) << (wallSeconds > 0.0 ? megabytes / wallSeconds : 0.0) << " MB/s overall";
+    }
+}
+
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    using namespace fsaverage;
+
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        usage();
+        return 1;
+    }
+
+    std::atomic<std::size_t> converted{0U};
+    std::atomic<std::size_t> skipped{0U};
+    std::atomic<std::size_t> failed{0U};
+    MemoryBudget budget(options.memoryBudget);
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        ThreadPool pool(options.threadCount);
+        for (auto& job : options.jobs)
+        {
+            pool.submit([&job, &options, &converted, &skipped, &failed, &budget]()
+            {
+                std::string inputHash;
+                if (!options.force && isUpToDate(job, options.hash, inputHash))
+                {
+                    skipped.fetch_add(1U);
+                    return;
+                }
+
+                // the merged output and the decode buffers take about twice the input size
+                uint64_t inputBytes = inputSize(job.lpath) + inputSize(job.rpath);
+                std::size_t held = budget.acquire(static_cast<std::size_t>(inputBytes) * 2U);
+
+                // the loaders and the container writer record their own stages
+                bool saved = false;
+                std::error_code error;
+                std::filesystem::create_directories(job.output.parent_path(), error);
+                if (job.kind == JobKind::Surface)
+                {
+                    auto surface = loadFreeSurferSurface(job.lpath, job.rpath);
+                    saved = !surface.empty() && save(job.output, surface, options.index);
+                }
+                else
+                {
+                    auto annotation = loadFreeSurferAnnotation(job.lpath, job.rpath);
+                    saved = !annotation.empty() && save(job.output, annotation, options.index);
+                }
+                budget.release(held);
+
+                if (!saved)
+                {
+                    logError() << "Convert " << job.lpath << " and " << job.rpath << " failed!";
+                    failed.fetch_add(1U);
+                    return;
+                }
+                if (options.hash)
+                {
+                    std::ofstream(hashFilePath(job)) << inputHash;
+                }
+                converted.fetch_add(1U);
+            });
+        }
+        pool.wait();
+    }
+    report(converted.load(), skipped.load(), failed.load(), std::chrono::steady_clock::now() - start);
+    if (!options.metrics.empty())
+    {
+        std::ofstream output(options.metrics);
+        if (!output.is_open())
+        {
+            logError() << "Open " << options.metrics << " failed!";
+            return 1;
+        }
+        writeMetricsReport(output);
+    }
+
+    return failed.load() == 0U ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,169 @@
+// Author: cute-giggle@outlook.com
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include "surface.h"
+#include "annotation.h"
+#include "spatial_index.h"
+#include "log.h"
+
+namespace fsaverage
+{
+// Map coordinates to surface vertices and to the regions of annotations on that surface.
+
+namespace
+{
+
+struct Options
+{
+    std::filesystem::path surface;
+    std::vector<std::filesystem::path> annotations;
+    std::filesystem::path input;
+    bool vertex = false;
+};
+
+bool parseOptions(int argc, char* argv[], Options& options) noexcept
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (argument == "--input" && i + 1 < argc)
+        {
+            options.input = argv[++i];
+        }
+        else if (argument == "--vertex")
+        {
+            options.vertex = true;
+        }
+        else if (argument.find("--") == 0U)
+        {
+            return false;
+        }
+        else if (options.surface.empty())
+        {
+            options.surface = argument;
+        }
+        else
+        {
+            options.annotations.emplace_back(argument);
+        }
+    }
+    return !options.surface.empty();
+}
+
+// x y z per line, anything after the third number is ignored.
+std::vector<float> readPoints(std::istream& input) noexcept
+{
+    std::vector<float> query;
+    std::string line;
+    while (std::getline(input, line))
+    {
+        std::istringstream stream(line);
+        float p[3];
+        if (stream >> p[0] >> p[1] >> p[2])
+        {
+            query.insert(query.end(), p, p + 3);
+        }
+    }
+    return query;
+}
+
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    using namespace fsaverage;
+
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        std::cout << "Using [LocatePoint] [--input file] [--vertex] [surface file] [annotation file]..." << std::endl;
+        std::cout << "Reads 'x y z' lines (stdin without --input) and prints the closest surface point, or the nearest "
+                     "vertex with --vertex, with the region of every annotation." << std::endl;
+        return 0;
+    }
+
+    auto surface = SurfaceView::open(options.surface);
+    if (surface.empty())
+    {
+        return 1;
+    }
+    auto index = SpatialIndex::load(surface);
+    if (index.empty())
+    {
+        return 1;
+    }
+
+    std::vector<AnnotationView> annotations;
+    for (auto& path : options.annotations)
+    {
+        annotations.emplace_back(AnnotationView::open(path));
+        if (annotations.back().empty() || annotations.back().labelIndex.size() != surface.point.size() / 3U)
+        {
+            logError() << "Annotation " << path << " is not defined on surface " << options.surface << "!";
+            return 1;
+        }
+    }
+
+    std::vector<float> query;
+    if (options.input.empty())
+    {
+        query = readPoints(std::cin);
+    }
+    else
+    {
+        std::ifstream input(options.input);
+        if (!input.is_open())
+        {
+            logError() << "Open " << options.input << " failed!";
+            return 1;
+        }
+        query = readPoints(input);
+    }
+
+    // both query kinds reduce to a vertex and a distance per point
+    std::size_t count = query.size() / 3U;
+    std::vector<uint32_t> vertex(count);
+    std::vector<float> distance(count);
+    if (options.vertex)
+    {
+        std::vector<NearestVertex> nearest(count);
+        index.nearestVertex(query.data(), count, nearest.data());
+        for (std::size_t q = 0U; q < count; ++q)
+        {
+            vertex[q] = nearest[q].vertex;
+            distance[q] = nearest[q].distance;
+        }
+    }
+    else
+    {
+        std::vector<ClosestPoint> closest(count);
+        index.closestPoint(query.data(), count, closest.data());
+        for (std::size_t q = 0U; q < count; ++q)
+        {
+            vertex[q] = closest[q].nearestCorner(index.face);
+            distance[q] = closest[q].distance;
+        }
+    }
+
+    std::ostringstream output;
+    for (std::size_t q = 0U; q < count; ++q)
+    {
+        output << query[q * 3U] << '\t' << query[q * 3U + 1U] << '\t' << query[q * 3U + 2U] << '\t' << vertex[q] << '\t' << distance[q];
+        for (auto& annotation : annotations)
+        {
+            uint32_t label = annotation.labelIndex[vertex[q]];
+            output << '\t' << (label < annotation.colorTable.size() ? annotation.colorTable[label].name : "???");
+        }
+        output << '\n';
+    }
+    std::cout << output.str();
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,163 @@
+// Author: cute-giggle@outlook.com
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <filesystem>
+
+#include "triple_store.h"
+#include "log.h"
+
+namespace fsaverage
+{
+// Pattern and neighborhood queries against a store written by BuildTriples.
+
+namespace
+{
+
+struct Options
+{
+    std::filesystem::path store;
+    std::vector<std::string> terms;
+    std::size_t hops = 0U;
+    std::string relation;
+    Direction direction = Direction::Both;
+};
+
+bool parseOptions(int argc, char* argv[], Options& options) noexcept
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (argument == "--hops" && i + 1 < argc)
+        {
+            options.hops = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (argument == "--relation" && i + 1 < argc)
+        {
+            options.relation = argv[++i];
+        }
+        else if (argument == "--direction" && i + 1 < argc)
+        {
+            std::string direction = argv[++i];
+            if (direction == "out")
+            {
+                options.direction = Direction::Outgoing;
+            }
+            else if (direction == "in")
+            {
+                options.direction = Direction::Incoming;
+            }
+            else if (direction != "both")
+            {
+                return false;
+            }
+        }
+        else if (argument.find("--") == 0U)
+        {
+            return false;
+        }
+        else if (options.store.empty())
+        {
+            options.store = argument;
+        }
+        else
+        {
+            options.terms.emplace_back(argument);
+        }
+    }
+    return !options.store.empty() && (options.terms.empty() || options.terms.size() == (options.hops > 0U ? 1U : 3U));
+}
+
+// "*" is the wildcard; a name missing from the store matches nothing.
+bool resolve(const TripleStore& store, const std::string& name, uint32_t& id) noexcept
+{
+    id = name == "*" ? TripleStore::ANY : store.find(name);
+    return name == "*" || id != TripleStore::ANY;
+}
+
+void query(const TripleStore& store, const Options& options, const std::vector<std::string>& terms, std::ostream& output) noexcept
+{
+    if (options.hops > 0U)
+    {
+        uint32_t entity = store.find(terms[0]);
+        uint32_t relation = TripleStore::ANY;
+        if (entity == TripleStore::ANY || (!options.relation.empty() && !resolve(store, options.relation, relation)))
+        {
+            return;
+        }
+        for (uint32_t id : store.neighborhood(entity, options.hops, relation, options.direction))
+        {
+            output << store.term(id) << '\n';
+        }
+        return;
+    }
+
+    uint32_t id[3];
+    for (std::size_t k = 0U; k < 3U; ++k)
+    {
+        if (!resolve(store, terms[k], id[k]))
+        {
+            return;
+        }
+    }
+    for (auto& triple : store.match(id[0], id[1], id[2]))
+    {
+        output << store.term(triple.subject) << '\t' << store.term(triple.relation) << '\t' << store.term(triple.object) << '\n';
+    }
+}
+
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    using namespace fsaverage;
+
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        std::cout << "Using [QueryTriples] [store file] [subject] [relation] [object]" << std::endl;
+        std::cout << "      [QueryTriples] [store file] --hops [count] [--relation name] [--direction out/in/both] [entity]" << std::endl;
+        std::cout << "'*' matches any term. Without terms, queries are read from stdin one per line with tab separated "
+                     "terms, and every answer ends with an empty line." << std::endl;
+        return 0;
+    }
+
+    auto store = TripleStore::open(options.store);
+    if (store.empty())
+    {
+        return 1;
+    }
+
+    if (!options.terms.empty())
+    {
+        query(store, options, options.terms, std::cout);
+        return 0;
+    }
+
+    std::size_t expected = options.hops > 0U ? 1U : 3U;
+    std::string line;
+    while (std::getline(std::cin, line))
+    {
+        std::vector<std::string> terms;
+        std::istringstream stream(line);
+        for (std::string term; std::getline(stream, term, '\t');)
+        {
+            terms.emplace_back(std::move(term));
+        }
+        if (terms.size() == expected)
+        {
+            query(store, options, terms, std::cout);
+        }
+        else
+        {
+            logWarning() << "Expected " << expected << " tab separated terms: " << line;
+        }
+        std::cout << '\n';
+    }
+    return 0;
+}
\ No newline at end of file
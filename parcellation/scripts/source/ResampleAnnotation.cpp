@@ -0,0 +1,98 @@
+// Author: cute-giggle@outlook.com
+
+#include <iostream>
+#include <string>
+#include <filesystem>
+
+#include "surface.h"
+#include "annotation.h"
+#include "resample.h"
+#include "freesurfer.h"
+#include "log.h"
+
+namespace fsaverage
+{
+// Carry an annotation from its source surface to a target surface in the same space, e.g. from the
+// surface.sphere.reg.data of the atlas mesh to the one of a common template, and save it as an annotation
+// data file on the target.
+
+namespace
+{
+
+struct Options
+{
+    std::filesystem::path source;
+    std::filesystem::path annotation;
+    std::filesystem::path target;
+    std::filesystem::path output;
+};
+
+bool parseOptions(int argc, char* argv[], Options& options) noexcept
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if (argument == "--output" && i + 1 < argc)
+        {
+            options.output = argv[++i];
+        }
+        else if (argument.find("--") == 0U)
+        {
+            return false;
+        }
+        else if (options.source.empty())
+        {
+            options.source = argument;
+        }
+        else if (options.annotation.empty())
+        {
+            options.annotation = argument;
+        }
+        else if (options.target.empty())
+        {
+            options.target = argument;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    if (options.output.empty())
+    {
+        options.output = resampledAnnotationFileName(options.annotation);
+    }
+    return !options.target.empty();
+}
+
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    using namespace fsaverage;
+
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        std::cout << "Using [ResampleAnnotation] [--output file] [source surface file] [annotation file] [target surface file]" << std::endl;
+        std::cout << "Surfaces are data files of registered spheres (e.g. from [lh/rh].sphere.reg), the output defaults to "
+                     "[annotation].resampled.data." << std::endl;
+        return 0;
+    }
+
+    auto source = Surface::load(options.source);
+    auto annotation = Annotation::load(options.annotation);
+    auto target = Surface::load(options.target);
+    if (source.empty() || annotation.empty() || target.empty())
+    {
+        return 1;
+    }
+
+    auto resampled = resampleAnnotation(source, annotation, target);
+    if (resampled.empty() || !save(options.output, resampled))
+    {
+        return 1;
+    }
+    return 0;
+}
\ No newline at end of file
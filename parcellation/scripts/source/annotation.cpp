@@ -2,38 +2,155 @@
 
 #include "annotation.h"
 
-#include <iostream>
 #include <fstream>
+#include <cstring>
+
+#include "json_reader.h"
+#include "log.h"
 
 namespace fsaverage
 {
 
 namespace
 {
-constexpr uint32_t COLOR_MAX_NAME_LENGTH = 64U;
-}
 
-Annotation Annotation::load(const std::filesystem::path& path) noexcept
+bool checkAnnotationDataPath(const std::filesystem::path& path) noexcept
 {
     if (!std::filesystem::exists(path))
     {
-        std::cout << "File " << path << "does not exist!" << std::endl;
-        return {};
+        logError() << "File " << path << "does not exist!";
+        return false;
     }
 
     if (path.stem().string().find("annotation") != 0UL || path.extension() != ".data")
     {
-        std::cout << "Only support [annotation.xxx.data]!" << std::endl;
+        logError() << "Only support [annotation.xxx.data]!";
+        return false;
+    }
+    return true;
+}
+
+// layout: [color count]{[R][G][B][A][name length][name]}...[label count][label count * uint32]
+bool openLegacyAnnotation(AnnotationView& view) noexcept
+{
+    const unsigned char* data = view.file.data();
+    std::size_t size = view.file.size();
+    std::size_t offset = 0U;
+    auto readCount = [data, size, &offset](uint32_t& value) -> bool
+    {
+        if (size - offset < sizeof(uint32_t))
+        {
+            return false;
+        }
+        std::memcpy(&value, data + offset, sizeof(uint32_t));
+        offset += sizeof(uint32_t);
+        return true;
+    };
+
+    uint32_t colorCount{};
+    if (!readCount(colorCount))
+    {
+        return false;
+    }
+    view.colorTable.resize(colorCount);
+    for (auto& colorItem : view.colorTable)
+    {
+        if (size - offset < sizeof(int) * 4U)
+        {
+            return false;
+        }
+        int rgba[4] = {0};
+        std::memcpy(rgba, data + offset, sizeof(rgba));
+        offset += sizeof(rgba);
+        colorItem.R = rgba[0];
+        colorItem.G = rgba[1];
+        colorItem.B = rgba[2];
+        colorItem.A = rgba[3];
+
+        uint32_t nameLength{};
+        if (!readCount(nameLength) || size - offset < nameLength)
+        {
+            return false;
+        }
+        colorItem.name.assign(reinterpret_cast<const char*>(data + offset), nameLength);
+        offset += nameLength;
+    }
+
+    uint32_t labelCount{};
+    if (!readCount(labelCount) || (size - offset) / sizeof(uint32_t) < labelCount)
+    {
+        return false;
+    }
+    view.labelIndex = view.file.span<uint32_t>(offset, labelCount);
+    if (view.labelIndex.empty())
+    {
+        // label names have arbitrary length, so the label array may start at an unaligned offset
+        view.storage.resize(labelCount);
+        std::memcpy(view.storage.data(), data + offset, labelCount * sizeof(uint32_t));
+        view.labelIndex = {view.storage.data(), view.storage.size()};
+    }
+    return true;
+}
+
+bool openContainerAnnotation(AnnotationView& view, bool decodeLabels) noexcept
+{
+    view.container = ContainerReader::parse(view.file.data(), view.file.size());
+    if (view.container.empty())
+    {
+        return false;
+    }
+
+    auto record = view.container.section<ColorRecord>(SectionId::ColorTable);
+    auto namePool = view.container.section<char>(SectionId::NamePool);
+    view.colorTable.resize(record.size());
+    for (std::size_t i = 0U; i < record.size(); ++i)
+    {
+        if (record[i].nameOffset > namePool.size() || record[i].nameLength > namePool.size() - record[i].nameOffset)
+        {
+            return false;
+        }
+        view.colorTable[i] = ColorTableItem{record[i].R, record[i].G, record[i].B, record[i].A,
+            std::string(namePool.data() + record[i].nameOffset, record[i].nameLength)};
+    }
+    view.labelIndex = view.container.section<uint32_t>(SectionId::LabelIndex);
+    if (view.labelIndex.empty() && view.container.has(SectionId::LabelCodec))
+    {
+        view.labels = CompressedLabels::load(view.container);
+        if (decodeLabels && !view.labels.empty())
+        {
+            view.storage = view.labels.decode();
+            view.labelIndex = {view.storage.data(), view.storage.size()};
+        }
+    }
+    return true;
+}
+
+}
+
+Annotation Annotation::load(const std::filesystem::path& path) noexcept
+{
+    if (!checkAnnotationDataPath(path))
+    {
         return {};
     }
 
     std::ifstream input(path, std::ios::binary);
     if (!input.is_open())
     {
-        std::cout << "Open " << path << "failed!" << std::endl;
+        logError() << "Open " << path << "failed!";
         return {};
     }
 
+    char magic[sizeof(CONTAINER_MAGIC)] = {0};
+    input.read(magic, sizeof(magic));
+    if (ContainerReader::isContainer(reinterpret_cast<const unsigned char*>(magic), input.gcount()))
+    {
+        auto view = AnnotationView::open(path);
+        return {std::move(view.colorTable), {view.labelIndex.begin(), view.labelIndex.end()}};
+    }
+    input.clear();
+    input.seekg(0);
+
     uint32_t colorCount{};
     input.read(reinterpret_cast<char*>(&colorCount), sizeof(uint32_t));
     Annotation annotation;
@@ -43,9 +160,8 @@ Annotation Annotation::load(const std::filesystem::path& path) noexcept
         input.read(reinterpret_cast<char*>(&(annotation.colorTable[i])), sizeof(int) * 4U);
         uint32_t nameLength{};
         input.read(reinterpret_cast<char*>(&nameLength), sizeof(uint32_t));
-        char name[COLOR_MAX_NAME_LENGTH] = {0};
-        input.read(name, nameLength);
-        annotation.colorTable[i].name = name;
+        annotation.colorTable[i].name.resize(nameLength);
+        input.read(annotation.colorTable[i].name.data(), nameLength);
     }
 
     uint32_t labelCount{};
@@ -55,4 +171,64 @@ Annotation Annotation::load(const std::filesystem::path& path) noexcept
     return annotation;
 }
 
+AnnotationView AnnotationView::open(const std::filesystem::path& path, bool decodeLabels) noexcept
+{
+    if (!checkAnnotationDataPath(path))
+    {
+        return {};
+    }
+
+    AnnotationView view;
+    view.file = MappedFile::open(path);
+    if (view.file.empty())
+    {
+        return {};
+    }
+
+    bool valid = ContainerReader::isContainer(view.file.data(), view.file.size()) ? openContainerAnnotation(view, decodeLabels) : openLegacyAnnotation(view);
+    if (!valid || view.empty())
+    {
+        logError() << "Invalid annotation data file " << path << "!";
+        return {};
+    }
+    return view;
+}
+
+std::string atlasName(const std::filesystem::path& path) noexcept
+{
+    auto stem = path.stem().string();
+    auto pos = stem.find_first_of('.');
+    return pos == stem.npos ? stem : stem.substr(pos + 1U);
+}
+
+const std::string& RegionNames::lookup(const std::string& name) const noexcept
+{
+    auto iter = display.find(name);
+    return iter == display.end() ? name : iter->second;
+}
+
+bool RegionNames::load(const std::filesystem::path& path) noexcept
+{
+    auto document = JsonValue::load(path);
+    if (document.empty())
+    {
+        return false;
+    }
+    if (!document.isObject())
+    {
+        logError() << "Region names " << path << " must be an object of annotation name to display name!";
+        return false;
+    }
+    for (std::size_t i = 0U; i < document.item.size(); ++i)
+    {
+        if (!document.item[i].isString())
+        {
+            logError() << "Region names " << path << " must be an object of annotation name to display name!";
+            return false;
+        }
+        display[document.name[i]] = document.item[i].text;
+    }
+    return true;
+}
+
 }
\ No newline at end of file
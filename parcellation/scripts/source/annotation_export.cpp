@@ -0,0 +1,229 @@
+// Author: cute-giggle@outlook.com
+
+#include "annotation_export.h"
+
+#include <fstream>
+#include <string>
+#include <cstring>
+
+#include "json_writer.h"
+#include "log.h"
+
+namespace fsaverage
+{
+
+namespace
+{
+constexpr std::size_t BUFFER_SIZE = 1U << 16;
+
+// Major types of RFC 8949.
+enum class CborType : uint8_t
+{
+    Unsigned = 0U,
+    Negative = 1U,
+    Text = 3U,
+    Array = 4U,
+    Map = 5U,
+};
+
+// Buffered CBOR encoder for definite-length items.
+class CborWriter
+{
+public:
+    explicit CborWriter(std::ostream& output) noexcept : output(output)
+    {
+        buffer.reserve(BUFFER_SIZE + 16U);
+    }
+
+    ~CborWriter() noexcept
+    {
+        flush();
+    }
+
+    void beginArray(std::size_t size) noexcept
+    {
+        head(CborType::Array, size);
+    }
+
+    void beginMap(std::size_t size) noexcept
+    {
+        head(CborType::Map, size);
+    }
+
+    void value(int64_t number) noexcept
+    {
+        if (number < 0)
+        {
+            head(CborType::Negative, static_cast<uint64_t>(-1 - number));
+        }
+        else
+        {
+            head(CborType::Unsigned, static_cast<uint64_t>(number));
+        }
+    }
+
+    void value(uint32_t number) noexcept
+    {
+        head(CborType::Unsigned, number);
+    }
+
+    void value(std::string_view text) noexcept
+    {
+        head(CborType::Text, text.size());
+        buffer.append(text.data(), text.size());
+    }
+
+    void flush() noexcept
+    {
+        output.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        buffer.clear();
+    }
+
+private:
+    // Initial byte plus the shortest big-endian argument that holds the value.
+    void head(CborType type, uint64_t argument) noexcept
+    {
+        if (buffer.size() >= BUFFER_SIZE)
+        {
+            flush();
+        }
+        uint8_t major = static_cast<uint8_t>(static_cast<uint8_t>(type) << 5);
+        if (argument < 24U)
+        {
+            buffer.push_back(static_cast<char>(major | argument));
+            return;
+        }
+        std::size_t bytes = argument <= 0xFFU ? 1U : (argument <= 0xFFFFU ? 2U : (argument <= 0xFFFFFFFFU ? 4U : 8U));
+        buffer.push_back(static_cast<char>(major | (bytes == 1U ? 24U : (bytes == 2U ? 25U : (bytes == 4U ? 26U : 27U)))));
+        for (std::size_t i = bytes; i-- > 0U;)
+        {
+            buffer.push_back(static_cast<char>((argument >> (i * 8U)) & 0xFFU));
+        }
+    }
+
+    std::ostream& output;
+    std::string buffer;
+};
+
+bool openOutput(std::ofstream& output, const std::filesystem::path& path) noexcept
+{
+    output.open(path, std::ios::binary);
+    if (!output.is_open())
+    {
+        logError() << "Open " << path << " failed!";
+        return false;
+    }
+    return true;
+}
+
+bool closeOutput(std::ofstream& output, const std::filesystem::path& path) noexcept
+{
+    output.close();
+    if (!output)
+    {
+        logError() << "Write " << path << " failed!";
+        return false;
+    }
+    logInfo() << "Save annotation export to " << std::filesystem::absolute(path);
+    return true;
+}
+
+}
+
+bool exportAnnotationJson(const std::filesystem::path& path, const Annotation& annotation, int indent) noexcept
+{
+    std::ofstream output;
+    if (!openOutput(output, path))
+    {
+        return false;
+    }
+    {
+        JsonWriter writer(output, indent);
+        writer.beginObject();
+        writer.key("color_table");
+        writer.beginArray();
+        for (auto& item : annotation.colorTable)
+        {
+            writer.beginArray();
+            writer.beginArray();
+            writer.value(item.R);
+            writer.value(item.G);
+            writer.value(item.B);
+            writer.value(item.A);
+            writer.endArray();
+            writer.value(item.name);
+            writer.endArray();
+        }
+        writer.endArray();
+        writer.key("label");
+        writer.beginArray();
+        for (uint32_t label : annotation.labelIndex)
+        {
+            writer.value(label);
+        }
+        writer.endArray();
+        writer.endObject();
+    }
+    return closeOutput(output, path);
+}
+
+bool exportAnnotationCbor(const std::filesystem::path& path, const Annotation& annotation) noexcept
+{
+    std::ofstream output;
+    if (!openOutput(output, path))
+    {
+        return false;
+    }
+    {
+        CborWriter writer(output);
+        writer.beginMap(2U);
+        writer.value("color_table");
+        writer.beginArray(annotation.colorTable.size());
+        for (auto& item : annotation.colorTable)
+        {
+            writer.beginArray(2U);
+            writer.beginArray(4U);
+            writer.value(int64_t{item.R});
+            writer.value(int64_t{item.G});
+            writer.value(int64_t{item.B});
+            writer.value(int64_t{item.A});
+            writer.value(item.name);
+        }
+        writer.value("label");
+        writer.beginArray(annotation.labelIndex.size());
+        for (uint32_t label : annotation.labelIndex)
+        {
+            writer.value(label);
+        }
+    }
+    return closeOutput(output, path);
+}
+
+bool exportLabelNpy(const std::filesystem::path& path, const Annotation& annotation) noexcept
+{
+    std::ofstream output;
+    if (!openOutput(output, path))
+    {
+        return false;
+    }
+
+    // format version 1.0: magic, header length, then a dict literal padded so the data starts 64-byte aligned
+    uint32_t marker = 1U;
+    unsigned char first{};
+    std::memcpy(&first, &marker, 1U);
+    std::string header = std::string("{'descr': '") + (first == 1U ? '<' : '>') + "u4', 'fortran_order': False, 'shape': ("
+        + std::to_string(annotation.labelIndex.size()) + ",), }";
+    std::size_t prefix = 10U;
+    header.append((64U - (prefix + header.size() + 1U) % 64U) % 64U, ' ');
+    header.push_back('\n');
+
+    uint16_t headerLength = static_cast<uint16_t>(header.size());
+    char magic[10] = {'\x93', 'N', 'U', 'M', 'P', 'Y', 1, 0, static_cast<char>(headerLength & 0xFFU), static_cast<char>(headerLength >> 8)};
+    output.write(magic, sizeof(magic));
+    output.write(header.data(), static_cast<std::streamsize>(header.size()));
+    output.write(reinterpret_cast<const char*>(annotation.labelIndex.data()),
+        static_cast<std::streamsize>(annotation.labelIndex.size() * sizeof(uint32_t)));
+    return closeOutput(output, path);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,110 @@
+// Author: cute-giggle@outlook.com
+
+#include "binary_reader.h"
+
+#include <cstring>
+
+#include "BigEndianHelper.h"
+
+namespace fsaverage
+{
+
+namespace
+{
+
+template<typename T>
+bool readSwapped(const BinaryReader& reader, std::size_t offset, T* destination, std::size_t count) noexcept
+{
+    if (count > reader.size() / sizeof(T))
+    {
+        return false;
+    }
+    auto* data = reader.bytes(offset, count * sizeof(T));
+    if (data == nullptr)
+    {
+        return false;
+    }
+    std::memcpy(destination, data, count * sizeof(T));
+    if (!BigEndianHelper::isBigEndian())
+    {
+        BigEndianHelper::reverseEndian(destination, count);
+    }
+    return true;
+}
+
+}
+
+bool BinaryReader::read3Bytes(std::size_t offset, int& value) const noexcept
+{
+    auto* data = bytes(offset, 3U);
+    if (data == nullptr)
+    {
+        return false;
+    }
+    value = load3Bytes(data);
+    return true;
+}
+
+bool BinaryReader::read4Bytes(std::size_t offset, int& value) const noexcept
+{
+    auto* data = bytes(offset, 4U);
+    if (data == nullptr)
+    {
+        return false;
+    }
+    value = static_cast<int>(load4Bytes(data));
+    return true;
+}
+
+bool BinaryReader::readSequence(std::size_t offset, int* destination, std::size_t count) const noexcept
+{
+    return readSwapped(*this, offset, destination, count);
+}
+
+bool BinaryReader::readSequence(std::size_t offset, float* destination, std::size_t count) const noexcept
+{
+    return readSwapped(*this, offset, destination, count);
+}
+
+bool BinaryReader::readSequence(std::size_t offset, short* destination, std::size_t count) const noexcept
+{
+    return readSwapped(*this, offset, destination, count);
+}
+
+bool BinaryReader::read3BytesMany(std::size_t offset, int* destination, std::size_t count) const noexcept
+{
+    if (count > length / 3U)
+    {
+        return false;
+    }
+    auto* data = bytes(offset, count * 3U);
+    if (data == nullptr)
+    {
+        return false;
+    }
+    BigEndianHelper::unpack3Bytes(data, destination, count);
+    return true;
+}
+
+bool BinaryReader::readString(std::size_t offset, std::size_t count, std::string& value) const noexcept
+{
+    auto* data = bytes(offset, count);
+    if (data == nullptr)
+    {
+        return false;
+    }
+    value.assign(reinterpret_cast<const char*>(data), count);
+    return true;
+}
+
+std::size_t BinaryReader::skipLine(std::size_t offset) const noexcept
+{
+    if (offset >= length)
+    {
+        return length;
+    }
+    auto* end = static_cast<const unsigned char*>(std::memchr(address + offset, '\n', length - offset));
+    return end == nullptr ? length : static_cast<std::size_t>(end - address) + 1U;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,156 @@
+// Author: cute-giggle@outlook.com
+
+#include "container.h"
+
+#include <fstream>
+#include <cstring>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+#include "log.h"
+#include "metrics.h"
+
+namespace fsaverage
+{
+
+namespace
+{
+
+constexpr std::size_t alignUp(std::size_t value) noexcept
+{
+    return (value + CONTAINER_ALIGNMENT - 1U) / CONTAINER_ALIGNMENT * CONTAINER_ALIGNMENT;
+}
+
+}
+
+void ContainerWriter::addSection(SectionId id, const void* data, std::size_t elementSize, std::size_t count) noexcept
+{
+    sections.emplace_back(PendingSection{id, data, elementSize, count});
+}
+
+bool ContainerWriter::save(const std::filesystem::path& path) const noexcept
+{
+    std::vector<SectionEntry> table(sections.size());
+    std::size_t offset = alignUp(sizeof(ContainerHeader) + table.size() * sizeof(SectionEntry));
+    for (std::size_t i = 0U; i < sections.size(); ++i)
+    {
+        table[i] = SectionEntry{static_cast<uint32_t>(sections[i].id), static_cast<uint32_t>(sections[i].elementSize), offset, sections[i].count};
+        offset = alignUp(offset + sections[i].elementSize * sections[i].count);
+    }
+
+    ContainerHeader header{};
+    std::memcpy(header.magic, CONTAINER_MAGIC, sizeof(header.magic));
+    header.version = CONTAINER_VERSION;
+    header.endianMarker = CONTAINER_ENDIAN_MARKER;
+    header.sectionCount = static_cast<uint32_t>(table.size());
+    header.fileSize = offset;
+
+    StageTimer timer(Stage::Write, header.fileSize);
+    std::ofstream output(path, std::ios::binary);
+    if (!output.is_open())
+    {
+        logError() << "Open " << path << " failed!";
+        return false;
+    }
+
+    static const char padding[CONTAINER_ALIGNMENT] = {0};
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    output.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(SectionEntry));
+    std::size_t written = sizeof(header) + table.size() * sizeof(SectionEntry);
+    for (std::size_t i = 0U; i < sections.size(); ++i)
+    {
+        output.write(padding, table[i].offset - written);
+        std::size_t bytes = sections[i].elementSize * sections[i].count;
+        output.write(static_cast<const char*>(sections[i].data), bytes);
+        written = table[i].offset + bytes;
+    }
+    output.write(padding, header.fileSize - written);
+
+    if (!output.good())
+    {
+        logError() << "Write " << path << " failed!";
+        return false;
+    }
+    return true;
+}
+
+const SectionEntry* ContainerReader::find(SectionId id) const noexcept
+{
+    for (auto& entry : sections)
+    {
+        if (entry.id == static_cast<uint32_t>(id))
+        {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+bool ContainerReader::isContainer(const unsigned char* data, std::size_t size) noexcept
+{
+    return size >= sizeof(CONTAINER_MAGIC) && std::memcmp(data, CONTAINER_MAGIC, sizeof(CONTAINER_MAGIC)) == 0;
+}
+
+ContainerReader ContainerReader::parse(const unsigned char* data, std::size_t size) noexcept
+{
+    if (size < sizeof(ContainerHeader) || !isContainer(data, size))
+    {
+        logError() << "Not a container file!";
+        return {};
+    }
+
+    if (reinterpret_cast<std::uintptr_t>(data) % alignof(SectionEntry) != 0U)
+    {
+        logError() << "Container buffer is not aligned!";
+        return {};
+    }
+
+    ContainerHeader header{};
+    std::memcpy(&header, data, sizeof(header));
+    if (header.endianMarker != CONTAINER_ENDIAN_MARKER)
+    {
+        logError() << "Container was written with another byte order!";
+        return {};
+    }
+    if (header.version != CONTAINER_VERSION)
+    {
+        logError() << "Not support this container version: " << header.version;
+        return {};
+    }
+    if (header.fileSize != size || (size - sizeof(header)) / sizeof(SectionEntry) < header.sectionCount)
+    {
+        logError() << "Container file is truncated!";
+        return {};
+    }
+
+    // sections lie after the section table and do not overlap each other; empty ones take no bytes
+    ContainerReader reader{data, size, {reinterpret_cast<const SectionEntry*>(data + sizeof(header)), header.sectionCount}};
+    std::size_t tableEnd = sizeof(header) + reader.sections.size() * sizeof(SectionEntry);
+    std::vector<std::pair<uint64_t, uint64_t>> range;
+    for (auto& entry : reader.sections)
+    {
+        if (entry.elementSize == 0U || entry.offset % CONTAINER_ALIGNMENT != 0U || entry.offset < tableEnd || entry.offset > size
+            || entry.count > (size - entry.offset) / entry.elementSize)
+        {
+            logError() << "Invalid container section " << entry.id << "!";
+            return {};
+        }
+        if (entry.count != 0U)
+        {
+            range.emplace_back(entry.offset, entry.offset + entry.count * entry.elementSize);
+        }
+    }
+    std::sort(range.begin(), range.end());
+    for (std::size_t i = 1U; i < range.size(); ++i)
+    {
+        if (range[i].first < range[i - 1U].second)
+        {
+            logError() << "Container sections overlap!";
+            return {};
+        }
+    }
+    return reader;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,803 @@
+// Author: cute-giggle@outlook.com
+
+#include "decimation.h"
+
+#include <algorithm>
+#include <numeric>
+#include <queue>
+#include <array>
+#include <cmath>
+
+#include "parallel.h"
+#include "log.h"
+
+namespace fsaverage
+{
+// Refer to [Garland and Heckbert, Surface Simplification Using Quadric Error Metrics, SIGGRAPH 1997].
+
+namespace
+{
+constexpr uint32_t INVALID = 0xFFFFFFFFU;
+constexpr std::size_t VERTEX_GRAIN = 1U << 14;
+
+// Boundary edges get a plane perpendicular to their face, weighted this much more than a face plane, so
+// open borders (e.g. a cut medial wall) keep their outline.
+constexpr double BOUNDARY_WEIGHT = 1000.0;
+
+// Symmetric 4x4 matrix of the squared distance to a set of planes, upper triangle row by row.
+struct Quadric
+{
+    double q[10]{};
+
+    void addPlane(const double normal[3], double offset, double weight) noexcept
+    {
+        double plane[4] = {normal[0], normal[1], normal[2], offset};
+        for (std::size_t r = 0U, k = 0U; r < 4U; ++r)
+        {
+            for (std::size_t c = r; c < 4U; ++c)
+            {
+                q[k++] += weight * plane[r] * plane[c];
+            }
+        }
+    }
+
+    Quadric& operator+= (const Quadric& other) noexcept
+    {
+        for (std::size_t k = 0U; k < 10U; ++k)
+        {
+            q[k] += other.q[k];
+        }
+        return *this;
+    }
+
+    double error(const double p[3]) const noexcept
+    {
+        double value = q[0] * p[0] * p[0] + 2.0 * q[1] * p[0] * p[1] + 2.0 * q[2] * p[0] * p[2] + 2.0 * q[3] * p[0]
+                     + q[4] * p[1] * p[1] + 2.0 * q[5] * p[1] * p[2] + 2.0 * q[6] * p[1]
+                     + q[7] * p[2] * p[2] + 2.0 * q[8] * p[2] + q[9];
+        return std::max(value, 0.0);
+    }
+
+    // The point of least error, false when the planes do not pin one down (flat or straight neighbourhoods).
+    bool optimum(double p[3]) const noexcept
+    {
+        double a = q[0], b = q[1], c = q[2], d = q[4], e = q[5], f = q[7];
+        double c00 = d * f - e * e;
+        double c01 = c * e - b * f;
+        double c02 = b * e - c * d;
+        double determinant = a * c00 + b * c01 + c * c02;
+        double scale = a + d + f;
+        if (!(std::fabs(determinant) > 1e-10 * scale * scale * scale))
+        {
+            return false;
+        }
+        double c11 = a * f - c * c;
+        double c12 = b * c - a * e;
+        double c22 = a * d - b * b;
+        double r[3] = {-q[3], -q[6], -q[8]};
+        p[0] = (c00 * r[0] + c01 * r[1] + c02 * r[2]) / determinant;
+        p[1] = (c01 * r[0] + c11 * r[1] + c12 * r[2]) / determinant;
+        p[2] = (c02 * r[0] + c12 * r[1] + c22 * r[2]) / determinant;
+        return true;
+    }
+};
+
+void cross(const double a[3], const double b[3], double result[3]) noexcept
+{
+    result[0] = a[1] * b[2] - a[2] * b[1];
+    result[1] = a[2] * b[0] - a[0] * b[2];
+    result[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+double dot(const double a[3], const double b[3]) noexcept
+{
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+struct Candidate
+{
+    double cost;
+    uint32_t u;
+    uint32_t v;
+    uint32_t versionU;
+    uint32_t versionV;
+    double position[3];
+
+    // min-heap on cost, ties by vertex ids so the result does not depend on the heap implementation
+    bool operator> (const Candidate& other) const noexcept
+    {
+        return cost != other.cost ? cost > other.cost : (u != other.u ? u > other.u : v > other.v);
+    }
+};
+
+// One level of one connected component, in component local vertex ids.
+struct ComponentLevel
+{
+    std::vector<float> point;
+    std::vector<int> face;
+    std::vector<uint32_t> parent;   // per component vertex
+};
+
+// Edge collapse state of one connected component. Faces are corner triples of local vertex ids and every
+// vertex keeps the list of its live faces, which is all the connectivity the collapse checks need.
+class Decimator
+{
+public:
+    Decimator(Span<const float> point, Span<const int> face, const std::vector<uint32_t>& vertex,
+        const std::vector<uint32_t>& faceId, const std::vector<uint32_t>& local) noexcept
+        : position(vertex.size() * 3U), quadric(vertex.size()), vertexFace(vertex.size()), mergedInto(vertex.size(), INVALID),
+          version(vertex.size(), 0U), aliveCount(vertex.size())
+    {
+        for (std::size_t i = 0U; i < vertex.size(); ++i)
+        {
+            std::copy(point.data() + vertex[i] * 3U, point.data() + vertex[i] * 3U + 3U, position.data() + i * 3U);
+        }
+        triangle.reserve(faceId.size());
+        for (uint32_t f : faceId)
+        {
+            std::array<uint32_t, 3> corner = {local[face[f * 3U]], local[face[f * 3U + 1U]], local[face[f * 3U + 2U]]};
+            if (corner[0] == corner[1] || corner[1] == corner[2] || corner[2] == corner[0])
+            {
+                continue;
+            }
+            for (uint32_t c : corner)
+            {
+                vertexFace[c].emplace_back(static_cast<uint32_t>(triangle.size()));
+            }
+            triangle.emplace_back(corner);
+        }
+        faceAlive.assign(triangle.size(), 1);
+        initializeQuadrics();
+        for (uint32_t u = 0U; u < vertexFace.size(); ++u)
+        {
+            for (uint32_t v : neighbors(u))
+            {
+                if (u < v)
+                {
+                    push(u, v);
+                }
+            }
+        }
+    }
+
+    std::size_t vertexCount() const noexcept
+    {
+        return aliveCount;
+    }
+
+    // Collapse the cheapest valid edges until at most target vertices are left or no edge can go.
+    void collapseTo(std::size_t target) noexcept
+    {
+        while (aliveCount > target && !heap.empty())
+        {
+            Candidate candidate = heap.top();
+            heap.pop();
+            if (mergedInto[candidate.u] != INVALID || mergedInto[candidate.v] != INVALID
+                || version[candidate.u] != candidate.versionU || version[candidate.v] != candidate.versionV)
+            {
+                continue;
+            }
+            if (collapse(candidate.u, candidate.v, candidate.position))
+            {
+                --aliveCount;
+            }
+        }
+    }
+
+    ComponentLevel snapshot() noexcept
+    {
+        ComponentLevel level;
+        std::vector<uint32_t> id(mergedInto.size(), INVALID);
+        for (uint32_t v = 0U; v < mergedInto.size(); ++v)
+        {
+            if (mergedInto[v] == INVALID)
+            {
+                id[v] = static_cast<uint32_t>(level.point.size() / 3U);
+                for (std::size_t k = 0U; k < 3U; ++k)
+                {
+                    level.point.emplace_back(static_cast<float>(position[v * 3U + k]));
+                }
+            }
+        }
+        for (std::size_t f = 0U; f < triangle.size(); ++f)
+        {
+            if (faceAlive[f])
+            {
+                for (uint32_t c : triangle[f])
+                {
+                    level.face.emplace_back(static_cast<int>(id[c]));
+                }
+            }
+        }
+        level.parent.resize(mergedInto.size());
+        for (uint32_t v = 0U; v < mergedInto.size(); ++v)
+        {
+            level.parent[v] = id[root(v)];
+        }
+        return level;
+    }
+
+private:
+    const double* at(uint32_t v) const noexcept
+    {
+        return position.data() + v * 3U;
+    }
+
+    // Follow the collapses of v to the live vertex that holds it now, compressing the path.
+    uint32_t root(uint32_t v) noexcept
+    {
+        uint32_t r = v;
+        while (mergedInto[r] != INVALID)
+        {
+            r = mergedInto[r];
+        }
+        while (mergedInto[v] != INVALID && mergedInto[v] != r)
+        {
+            uint32_t next = mergedInto[v];
+            mergedInto[v] = r;
+            v = next;
+        }
+        return r;
+    }
+
+    // Neighbours of v with the number of live faces each edge has, 1 on the boundary.
+    std::vector<std::pair<uint32_t, uint32_t>> edgeFaces(uint32_t v) const noexcept
+    {
+        std::vector<uint32_t> corner;
+        for (uint32_t f : vertexFace[v])
+        {
+            for (uint32_t c : triangle[f])
+            {
+                if (c != v)
+                {
+                    corner.emplace_back(c);
+                }
+            }
+        }
+        std::sort(corner.begin(), corner.end());
+        std::vector<std::pair<uint32_t, uint32_t>> result;
+        for (uint32_t c : corner)
+        {
+            if (result.empty() || result.back().first != c)
+            {
+                result.emplace_back(c, 0U);
+            }
+            ++result.back().second;
+        }
+        return result;
+    }
+
+    std::vector<uint32_t> neighbors(uint32_t v) const noexcept
+    {
+        std::vector<uint32_t> result;
+        for (auto& [w, count] : edgeFaces(v))
+        {
+            result.emplace_back(w);
+        }
+        return result;
+    }
+
+    void initializeQuadrics() noexcept
+    {
+        for (auto& corner : triangle)
+        {
+            double e1[3], e2[3], normal[3];
+            for (std::size_t k = 0U; k < 3U; ++k)
+            {
+                e1[k] = at(corner[1])[k] - at(corner[0])[k];
+                e2[k] = at(corner[2])[k] - at(corner[0])[k];
+            }
+            cross(e1, e2, normal);
+            double length = std::sqrt(dot(normal, normal));
+            if (length == 0.0)
+            {
+                continue;
+            }
+            for (double& n : normal)
+            {
+                n /= length;
+            }
+            // area weighted, so small faces do not pull vertices as hard as large ones
+            double offset = -dot(normal, at(corner[0]));
+            for (uint32_t c : corner)
+            {
+                quadric[c].addPlane(normal, offset, length / 2.0);
+            }
+
+            for (std::size_t k = 0U; k < 3U; ++k)
+            {
+                uint32_t a = corner[k], b = corner[(k + 1U) % 3U];
+                auto count = std::count_if(vertexFace[a].begin(), vertexFace[a].end(), [this, b](uint32_t f)
+                {
+                    return std::find(triangle[f].begin(), triangle[f].end(), b) != triangle[f].end();
+                });
+                if (count != 1)
+                {
+                    continue;
+                }
+                double edge[3] = {at(b)[0] - at(a)[0], at(b)[1] - at(a)[1], at(b)[2] - at(a)[2]};
+                double side[3];
+                cross(edge, normal, side);
+                double sideLength = std::sqrt(dot(side, side));
+                if (sideLength == 0.0)
+                {
+                    continue;
+                }
+                for (double& s : side)
+                {
+                    s /= sideLength;
+                }
+                double sideOffset = -dot(side, at(a));
+                quadric[a].addPlane(side, sideOffset, BOUNDARY_WEIGHT * dot(edge, edge));
+                quadric[b].addPlane(side, sideOffset, BOUNDARY_WEIGHT * dot(edge, edge));
+            }
+        }
+    }
+
+    void push(uint32_t u, uint32_t v) noexcept
+    {
+        Quadric sum = quadric[u];
+        sum += quadric[v];
+        Candidate candidate{0.0, std::min(u, v), std::max(u, v), 0U, 0U, {}};
+        candidate.versionU = version[candidate.u];
+        candidate.versionV = version[candidate.v];
+        if (sum.optimum(candidate.position))
+        {
+            candidate.cost = sum.error(candidate.position);
+        }
+        else
+        {
+            // no unique optimum: the best of the two ends and the midpoint
+            double option[3][3];
+            for (std::size_t k = 0U; k < 3U; ++k)
+            {
+                option[0][k] = at(u)[k];
+                option[1][k] = at(v)[k];
+                option[2][k] = (at(u)[k] + at(v)[k]) / 2.0;
+            }
+            candidate.cost = std::numeric_limits<double>::infinity();
+            for (auto& p : option)
+            {
+                double cost = sum.error(p);
+                if (cost < candidate.cost)
+                {
+                    candidate.cost = cost;
+                    std::copy(p, p + 3, candidate.position);
+                }
+            }
+        }
+        heap.push(candidate);
+    }
+
+    // Would moving v to p (with the faces in skip removed) turn any of its faces over?
+    bool flips(uint32_t v, const std::vector<uint32_t>& skip, const double p[3]) const noexcept
+    {
+        for (uint32_t f : vertexFace[v])
+        {
+            if (std::find(skip.begin(), skip.end(), f) != skip.end())
+            {
+                continue;
+            }
+            auto& corner = triangle[f];
+            std::size_t k = static_cast<std::size_t>(std::find(corner.begin(), corner.end(), v) - corner.begin());
+            const double* a = at(corner[(k + 1U) % 3U]);
+            const double* b = at(corner[(k + 2U) % 3U]);
+            double before[3], after[3], e1[3], e2[3], e3[3];
+            for (std::size_t i = 0U; i < 3U; ++i)
+            {
+                e1[i] = a[i] - at(v)[i];
+                e2[i] = b[i] - at(v)[i];
+                e3[i] = a[i] - p[i];
+            }
+            cross(e1, e2, before);
+            for (std::size_t i = 0U; i < 3U; ++i)
+            {
+                e2[i] = b[i] - p[i];
+            }
+            cross(e3, e2, after);
+            if (dot(before, after) <= 0.0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void removeFace(uint32_t v, uint32_t f) noexcept
+    {
+        auto& list = vertexFace[v];
+        list.erase(std::find(list.begin(), list.end(), f));
+    }
+
+    // Merge v into u at p. Refused when the edge has gone, when u and v share a neighbour that is not
+    // across one of their common faces (the result would not be a manifold), when two boundary vertices
+    // are joined through the interior, or when a face would turn over.
+    bool collapse(uint32_t u, uint32_t v, const double p[3]) noexcept
+    {
+        std::vector<uint32_t> shared;
+        std::vector<uint32_t> opposite;
+        for (uint32_t f : vertexFace[v])
+        {
+            auto& corner = triangle[f];
+            if (std::find(corner.begin(), corner.end(), u) != corner.end())
+            {
+                shared.emplace_back(f);
+                for (uint32_t c : corner)
+                {
+                    if (c != u && c != v)
+                    {
+                        opposite.emplace_back(c);
+                    }
+                }
+            }
+        }
+        if (shared.empty() || shared.size() > 2U)
+        {
+            return false;
+        }
+
+        auto linkU = edgeFaces(u);
+        auto linkV = edgeFaces(v);
+        std::size_t common = 0U;
+        bool boundaryU = false;
+        bool boundaryV = false;
+        for (auto& [w, count] : linkU)
+        {
+            boundaryU = boundaryU || count == 1U;
+        }
+        for (auto& [w, count] : linkV)
+        {
+            boundaryV = boundaryV || count == 1U;
+            bool inU = std::binary_search(linkU.begin(), linkU.end(), std::make_pair(w, 0U),
+                [](const auto& a, const auto& b) { return a.first < b.first; });
+            common += inU && w != u ? 1U : 0U;
+        }
+        std::sort(opposite.begin(), opposite.end());
+        opposite.erase(std::unique(opposite.begin(), opposite.end()), opposite.end());
+        if (common != opposite.size() || (shared.size() == 2U && boundaryU && boundaryV))
+        {
+            return false;
+        }
+        // the last faces of a closed component would fold onto each other
+        if (linkU.size() + linkV.size() <= 6U && shared.size() == 2U && linkU.size() == 3U && linkV.size() == 3U)
+        {
+            return false;
+        }
+        if (flips(u, shared, p) || flips(v, shared, p))
+        {
+            return false;
+        }
+
+        for (uint32_t f : shared)
+        {
+            faceAlive[f] = 0;
+            for (uint32_t c : triangle[f])
+            {
+                if (c != v)
+                {
+                    removeFace(c, f);
+                }
+            }
+        }
+        for (uint32_t f : vertexFace[v])
+        {
+            if (!faceAlive[f])
+            {
+                continue;
+            }
+            std::replace(triangle[f].begin(), triangle[f].end(), v, u);
+            vertexFace[u].emplace_back(f);
+        }
+        vertexFace[v].clear();
+        vertexFace[v].shrink_to_fit();
+        std::copy(p, p + 3, position.data() + u * 3U);
+        quadric[u] += quadric[v];
+        mergedInto[v] = u;
+        ++version[u];
+        ++version[v];
+        for (uint32_t w : neighbors(u))
+        {
+            push(u, w);
+        }
+        return true;
+    }
+
+    std::vector<double> position;
+    std::vector<Quadric> quadric;
+    std::vector<std::array<uint32_t, 3>> triangle;
+    std::vector<char> faceAlive;
+    std::vector<std::vector<uint32_t>> vertexFace;
+    std::vector<uint32_t> mergedInto;
+    std::vector<uint32_t> version;
+    std::size_t aliveCount;
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> heap;
+};
+
+uint32_t findRoot(std::vector<uint32_t>& parent, uint32_t v) noexcept
+{
+    while (parent[v] != v)
+    {
+        parent[v] = parent[parent[v]];
+        v = parent[v];
+    }
+    return v;
+}
+
+// Label of every coarse vertex by majority over the full resolution vertices collapsed into it.
+std::vector<uint32_t> voteLabels(Span<const uint32_t> labelIndex, const std::vector<uint32_t>& parent, std::size_t coarseCount) noexcept
+{
+    // group the full resolution vertices by coarse vertex, in CSR form
+    std::vector<uint32_t> offset(coarseCount + 1U, 0U);
+    for (uint32_t p : parent)
+    {
+        ++offset[p + 1U];
+    }
+    std::partial_sum(offset.begin(), offset.end(), offset.begin());
+    std::vector<uint32_t> member(parent.size());
+    std::vector<uint32_t> cursor(offset.begin(), offset.end() - 1);
+    for (uint32_t v = 0U; v < parent.size(); ++v)
+    {
+        member[cursor[parent[v]]++] = labelIndex[v];
+    }
+
+    std::vector<uint32_t> label(coarseCount, 0U);
+    parallelBlocks(coarseCount, blockCount(coarseCount, VERTEX_GRAIN), [&](std::size_t, std::size_t begin, std::size_t end)
+    {
+        for (std::size_t c = begin; c < end; ++c)
+        {
+            auto first = member.begin() + offset[c];
+            auto last = member.begin() + offset[c + 1U];
+            std::sort(first, last);
+            std::size_t best = 0U;
+            for (auto run = first; run != last;)
+            {
+                auto next = std::upper_bound(run, last, *run);
+                if (static_cast<std::size_t>(next - run) > best)
+                {
+                    best = static_cast<std::size_t>(next - run);
+                    label[c] = *run;
+                }
+                run = next;
+            }
+        }
+    });
+    return label;
+}
+
+bool validFaces(Span<const int> face, std::size_t vertexCount) noexcept
+{
+    return face.size() % 3U == 0U
+        && std::all_of(face.begin(), face.end(), [vertexCount](int v) { return v >= 0 && static_cast<std::size_t>(v) < vertexCount; });
+}
+
+}
+
+std::vector<SurfaceLevel> decimateSurface(Span<const float> point, Span<const int> face, const std::vector<std::size_t>& vertexCounts,
+    Span<const uint32_t> labelIndex) noexcept
+{
+    std::size_t vertexCount = point.size() / 3U;
+    if (vertexCount == 0U || face.size() % 3U != 0U)
+    {
+        logError() << "Invalid surface!";
+        return {};
+    }
+    if (std::any_of(face.begin(), face.end(), [vertexCount](int v) { return v < 0 || static_cast<std::size_t>(v) >= vertexCount; }))
+    {
+        logError() << "Surface faces refer to vertices out of range!";
+        return {};
+    }
+    if (!labelIndex.empty() && labelIndex.size() != vertexCount)
+    {
+        logError() << "Annotation must be defined on the same surface!";
+        return {};
+    }
+    std::vector<std::size_t> target;
+    for (std::size_t count : vertexCounts)
+    {
+        if (count < vertexCount)
+        {
+            target.emplace_back(count);
+        }
+        else
+        {
+            logWarning() << "Skip level of " << count << " vertices, the surface has only " << vertexCount << "!";
+        }
+    }
+    std::sort(target.begin(), target.end(), std::greater<std::size_t>());
+
+    // connected components numbered by their first vertex, so the left hemisphere stays first
+    std::vector<uint32_t> unionParent(vertexCount);
+    std::iota(unionParent.begin(), unionParent.end(), 0U);
+    for (std::size_t f = 0U; f < face.size(); f += 3U)
+    {
+        for (std::size_t k = 1U; k < 3U; ++k)
+        {
+            uint32_t a = findRoot(unionParent, static_cast<uint32_t>(face[f]));
+            uint32_t b = findRoot(unionParent, static_cast<uint32_t>(face[f + k]));
+            unionParent[std::max(a, b)] = std::min(a, b);
+        }
+    }
+    std::vector<uint32_t> componentOf(vertexCount);
+    std::vector<uint32_t> local(vertexCount);
+    std::vector<std::vector<uint32_t>> componentVertex;
+    std::vector<uint32_t> componentId(vertexCount, INVALID);
+    for (uint32_t v = 0U; v < vertexCount; ++v)
+    {
+        uint32_t r = findRoot(unionParent, v);
+        if (componentId[r] == INVALID)
+        {
+            componentId[r] = static_cast<uint32_t>(componentVertex.size());
+            componentVertex.emplace_back();
+        }
+        componentOf[v] = componentId[r];
+        local[v] = static_cast<uint32_t>(componentVertex[componentOf[v]].size());
+        componentVertex[componentOf[v]].emplace_back(v);
+    }
+    std::vector<std::vector<uint32_t>> componentFace(componentVertex.size());
+    for (uint32_t f = 0U; f < face.size() / 3U; ++f)
+    {
+        componentFace[componentOf[face[f * 3U]]].emplace_back(f);
+    }
+
+    // every component runs its own collapse sequence to its share of each target
+    std::size_t componentCount = componentVertex.size();
+    std::vector<std::vector<ComponentLevel>> componentLevel(componentCount);
+    parallelBlocks(componentCount, std::min(componentCount, blockCount(vertexCount, VERTEX_GRAIN)),
+        [&](std::size_t, std::size_t begin, std::size_t end)
+    {
+        for (std::size_t c = begin; c < end; ++c)
+        {
+            std::size_t size = componentVertex[c].size();
+            Decimator decimator(point, face, componentVertex[c], componentFace[c], local);
+            for (std::size_t count : target)
+            {
+                auto share = static_cast<std::size_t>(std::llround(static_cast<double>(count) * size / vertexCount));
+                decimator.collapseTo(std::min(size, std::max<std::size_t>(share, 4U)));
+                componentLevel[c].emplace_back(decimator.snapshot());
+            }
+        }
+    });
+
+    std::vector<SurfaceLevel> levels(target.size());
+    for (std::size_t l = 0U; l < target.size(); ++l)
+    {
+        auto& level = levels[l];
+        std::vector<uint32_t> offset(componentCount, 0U);
+        for (std::size_t c = 0U; c < componentCount; ++c)
+        {
+            auto& part = componentLevel[c][l];
+            offset[c] = static_cast<uint32_t>(level.point.size() / 3U);
+            level.point.insert(level.point.end(), part.point.begin(), part.point.end());
+            std::transform(part.face.begin(), part.face.end(), std::back_inserter(level.face),
+                [&offset, c](int v) { return v + static_cast<int>(offset[c]); });
+        }
+        level.parent.resize(vertexCount);
+        for (uint32_t v = 0U; v < vertexCount; ++v)
+        {
+            level.parent[v] = offset[componentOf[v]] + componentLevel[componentOf[v]][l].parent[local[v]];
+        }
+        if (!labelIndex.empty())
+        {
+            level.labelIndex = voteLabels(labelIndex, level.parent, level.point.size() / 3U);
+        }
+        logInfo() << "Level " << l + 1U << ": " << level.point.size() / 3U << " vertices, " << level.face.size() / 3U << " faces";
+    }
+    return levels;
+}
+
+const SurfaceLevelView& SurfaceLevels::coarsest(std::size_t vertexCount) const noexcept
+{
+    for (auto iter = level.rbegin(); iter != level.rend(); ++iter)
+    {
+        if (iter->vertexCount() >= vertexCount)
+        {
+            return *iter;
+        }
+    }
+    return level.front();
+}
+
+SurfaceLevels SurfaceLevels::open(const std::filesystem::path& path) noexcept
+{
+    SurfaceLevels levels;
+    levels.file = MappedFile::open(path);
+    if (levels.file.empty())
+    {
+        return {};
+    }
+    levels.container = ContainerReader::parse(levels.file.data(), levels.file.size());
+    if (levels.container.empty())
+    {
+        return {};
+    }
+
+    auto& container = levels.container;
+    SurfaceLevelView full{container.section<float>(SectionId::Point), container.section<int>(SectionId::Face),
+        container.section<uint32_t>(SectionId::LabelIndex), {}};
+    auto record = container.section<SurfaceLevelRecord>(SectionId::LevelRecord);
+    auto point = container.section<float>(SectionId::LevelPoint);
+    auto face = container.section<int>(SectionId::LevelFace);
+    auto label = container.section<uint32_t>(SectionId::LevelLabel);
+    auto parent = container.section<uint32_t>(SectionId::LevelParent);
+    std::size_t vertexCount = full.vertexCount();
+    if (full.point.empty() || full.point.size() % 3U != 0U || full.face.empty() || !validFaces(full.face, vertexCount)
+        || record.empty() || parent.size() != record.size() * vertexCount
+        || (full.labelIndex.empty() ? !label.empty() : (full.labelIndex.size() != vertexCount || label.empty())))
+    {
+        logError() << "Invalid surface level file " << path << "!";
+        return {};
+    }
+
+    levels.level.emplace_back(full);
+    for (std::size_t i = 0U; i < record.size(); ++i)
+    {
+        auto& r = record[i];
+        if (r.pointOffset % 3U != 0U || r.pointOffset > point.size() || r.vertexCount > point.size()
+            || r.faceOffset > face.size() || r.faceCount > face.size()
+            || r.pointOffset + r.vertexCount * 3U > point.size() || r.faceOffset + r.faceCount * 3U > face.size()
+            || (!label.empty() && r.pointOffset / 3U + r.vertexCount > label.size()))
+        {
+            logError() << "Invalid surface level file " << path << "!";
+            return {};
+        }
+        SurfaceLevelView view{{point.data() + r.pointOffset, r.vertexCount * 3U}, {face.data() + r.faceOffset, r.faceCount * 3U},
+            label.empty() ? Span<const uint32_t>{} : Span<const uint32_t>{label.data() + r.pointOffset / 3U, r.vertexCount},
+            {parent.data() + i * vertexCount, vertexCount}};
+
+        // consumers index the level through its faces and the parents of the full resolution vertices
+        std::size_t levelCount = r.vertexCount;
+        if (!validFaces(view.face, levelCount)
+            || !std::all_of(view.parent.begin(), view.parent.end(), [levelCount](uint32_t v) { return v < levelCount; }))
+        {
+            logError() << "Invalid surface level file " << path << ", level " << i + 1U << " refers to vertices out of range!";
+            return {};
+        }
+        levels.level.emplace_back(view);
+    }
+    return levels;
+}
+
+bool save(const std::filesystem::path& path, Span<const float> point, Span<const int> face, Span<const uint32_t> labelIndex,
+    const std::vector<SurfaceLevel>& levels) noexcept
+{
+    std::vector<SurfaceLevelRecord> record;
+    std::vector<float> levelPoint;
+    std::vector<int> levelFace;
+    std::vector<uint32_t> levelLabel;
+    std::vector<uint32_t> levelParent;
+    for (auto& level : levels)
+    {
+        record.emplace_back(SurfaceLevelRecord{levelPoint.size(), level.point.size() / 3U, levelFace.size(), level.face.size() / 3U});
+        levelPoint.insert(levelPoint.end(), level.point.begin(), level.point.end());
+        levelFace.insert(levelFace.end(), level.face.begin(), level.face.end());
+        levelLabel.insert(levelLabel.end(), level.labelIndex.begin(), level.labelIndex.end());
+        levelParent.insert(levelParent.end(), level.parent.begin(), level.parent.end());
+    }
+
+    ContainerWriter writer;
+    writer.addSection(SectionId::Point, point.data(), sizeof(float), point.size());
+    writer.addSection(SectionId::Face, face.data(), sizeof(int), face.size());
+    if (!labelIndex.empty())
+    {
+        writer.addSection(SectionId::LabelIndex, labelIndex.data(), sizeof(uint32_t), labelIndex.size());
+        writer.addSection(SectionId::LevelLabel, levelLabel);
+    }
+    writer.addSection(SectionId::LevelRecord, record);
+    writer.addSection(SectionId::LevelPoint, levelPoint);
+    writer.addSection(SectionId::LevelFace, levelFace);
+    writer.addSection(SectionId::LevelParent, levelParent);
+    if (!writer.save(path))
+    {
+        return false;
+    }
+
+    logInfo() << "Save surface levels to " << std::filesystem::absolute(path);
+    return true;
+}
+
+std::string surfaceLevelsFileName(const std::filesystem::path& path) noexcept
+{
+    return path.stem().string() + ".lod.data";
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,496 @@
+// Author: cute-giggle@outlook.com
+
+#include <filesystem>
+#include <algorithm>
+#include <numeric>
+
+#include "freesurfer.h"
+#include "binary_reader.h"
+#include "container.h"
+#include "region_index.h"
+#include "log.h"
+#include "metrics.h"
+
+#include "parallel.h"
+
+namespace fsaverage
+{
+// Refer to [nibabel.freesurfer.io.py].
+// About freesurfer annotation file formats, see [https://surfer.nmr.mgh.harvard.edu/fswiki/LabelsClutsAnnotationFiles].
+
+namespace
+{
+
+constexpr auto ANNOTATION_FILE_NAME_FORMAT = "[lh/rh].xxx.annot";
+
+bool checkAnnotationFilePath(const std::filesystem::path& lpath, const std::filesystem::path& rpath) noexcept
+{
+    if (!std::filesystem::exists(lpath) || !std::filesystem::exists(rpath))
+    {
+        return false;
+    }
+
+    if (lpath.filename().string().find("lh") != 0U || rpath.filename().string().find("rh") != 0U)
+    {
+        return false;
+    }
+    return lpath.extension() == ".annot" && rpath.extension() == ".annot";
+}
+
+// Length-prefixed, NUL-terminated string.
+std::string readName(BinaryCursor& cursor) noexcept
+{
+    int length = cursor.read4Bytes();
+    std::string name = cursor.readString(static_cast<std::size_t>(std::max(length, 0)));
+    return name.empty() ? name : name.substr(0U, name.size() - 1U);
+}
+
+ColorTableItem readColor(BinaryCursor& cursor, std::string name) noexcept
+{
+    int rgba[4] = {cursor.read4Bytes(), cursor.read4Bytes(), cursor.read4Bytes(), cursor.read4Bytes()};
+    return ColorTableItem{rgba[0], rgba[1], rgba[2], 255 - rgba[3], std::move(name)};
+}
+
+std::vector<ColorTableItem> readOldVersionColorTable(BinaryCursor& cursor, int entriesCount) noexcept
+{
+    std::string fileName = readName(cursor);
+    logDebug() << "Original old version color table file name: " << fileName;
+
+    std::vector<ColorTableItem> color;
+    for (int i = 0; i < entriesCount && cursor.valid(); ++i)
+    {
+        std::string labelName = readName(cursor);
+        color.emplace_back(readColor(cursor, std::move(labelName)));
+    }
+    return color;
+}
+
+std::vector<ColorTableItem> readNewVersionColorTable(BinaryCursor& cursor, int newVersion) noexcept
+{
+    if (newVersion != -2)
+    {
+        logError() << "Not support this new color table version: " << newVersion;
+        return {};
+    }
+
+    // read max structure id
+    cursor.read4Bytes();
+
+    std::string fileName = readName(cursor);
+    logDebug() << "Original new version color table file name: " << fileName;
+
+    // read item count
+    int entriesCount = cursor.read4Bytes();
+
+    std::vector<ColorTableItem> color;
+    for (int i = 0; i < entriesCount && cursor.valid(); ++i)
+    {
+        // read item id (not useful?)
+        cursor.read4Bytes();
+        std::string labelName = readName(cursor);
+        color.emplace_back(readColor(cursor, std::move(labelName)));
+    }
+    return color;
+}
+
+// Collision-free hash from the packed colors of one color table to a value per entry, built by hash and
+// displace: colors are grouped into buckets by one hash, and every bucket gets the displacement of a second
+// hash that moves all its colors to free slots. A lookup is then two loads and one compare, without
+// branches, so the per-vertex loop vectorizes. Colors not in the table yield missing.
+class ColorLookup
+{
+public:
+    // Values start as the entry index; for repeated colors the first entry wins, as with the map this replaces.
+    static ColorLookup build(const std::vector<ColorTableItem>& color, bool& unique) noexcept
+    {
+        std::vector<uint32_t> key;
+        std::vector<uint32_t> entry;
+        for (uint32_t i = 0U; i < color.size(); ++i)
+        {
+            uint32_t packed = static_cast<uint32_t>((color[i].B << 16) + (color[i].G << 8) + color[i].R);
+            if (std::find(key.begin(), key.end(), packed) == key.end())
+            {
+                key.emplace_back(packed);
+                entry.emplace_back(i);
+            }
+        }
+        unique = key.size() == color.size();
+
+        ColorLookup lookup;
+        for (lookup.slotBits = 2U; (std::size_t{1U} << lookup.slotBits) < key.size() * 2U; ++lookup.slotBits)
+        {
+        }
+        while (!lookup.place(key, entry))
+        {
+            ++lookup.slotBits;
+        }
+        lookup.entryCount = color.size();
+        return lookup;
+    }
+
+    uint32_t slot(uint32_t color) const noexcept
+    {
+        uint32_t bucket = (color * 0x9E3779B1U) >> (32U - bucketBits);
+        return (((color * 0x85EBCA77U) >> (32U - slotBits)) + displacement[bucket]) & (static_cast<uint32_t>(key.size()) - 1U);
+    }
+
+    uint32_t operator() (uint32_t color) const noexcept
+    {
+        uint32_t index = slot(color);
+        return key[index] == color ? value[index] : missing;
+    }
+
+    // Entry index of a color, or the color table size for colors not in the table.
+    uint32_t find(uint32_t color) const noexcept
+    {
+        uint32_t index = slot(color);
+        return key[index] == color && entry[index] != NONE ? entry[index] : static_cast<uint32_t>(entryCount);
+    }
+
+    // Replace every value, and missing, by table[value]; table is indexed by entry.
+    void translate(const std::vector<uint32_t>& table) noexcept
+    {
+        for (std::size_t i = 0U; i < value.size(); ++i)
+        {
+            value[i] = entry[i] == NONE ? table[0] : table[entry[i]];
+        }
+        missing = table[0];
+    }
+
+private:
+    static constexpr uint32_t NONE = 0xFFFFFFFFU;
+
+    bool place(const std::vector<uint32_t>& colors, const std::vector<uint32_t>& entries) noexcept
+    {
+        bucketBits = std::max(1U, slotBits - 2U);
+        key.assign(std::size_t{1U} << slotBits, 0U);
+        entry.assign(key.size(), NONE);
+        displacement.assign(std::size_t{1U} << bucketBits, 0U);
+
+        std::vector<std::vector<uint32_t>> bucket(displacement.size());
+        for (uint32_t i = 0U; i < colors.size(); ++i)
+        {
+            bucket[(colors[i] * 0x9E3779B1U) >> (32U - bucketBits)].emplace_back(i);
+        }
+        std::vector<uint32_t> order(bucket.size());
+        std::iota(order.begin(), order.end(), 0U);
+        std::stable_sort(order.begin(), order.end(), [&bucket](uint32_t a, uint32_t b) { return bucket[a].size() > bucket[b].size(); });
+
+        uint32_t mask = static_cast<uint32_t>(key.size()) - 1U;
+        for (uint32_t b : order)
+        {
+            if (bucket[b].empty())
+            {
+                break;
+            }
+            bool placed = false;
+            for (uint32_t shift = 0U; shift <= mask && !placed; ++shift)
+            {
+                placed = true;
+                for (std::size_t k = 0U; k < bucket[b].size() && placed; ++k)
+                {
+                    uint32_t index = (((colors[bucket[b][k]] * 0x85EBCA77U) >> (32U - slotBits)) + shift) & mask;
+                    placed = entry[index] == NONE;
+                    entry[index] = placed ? entries[bucket[b][k]] : entry[index];
+                    key[index] = placed ? colors[bucket[b][k]] : key[index];
+                    if (!placed)
+                    {
+                        // undo the colors of this bucket placed so far
+                        for (std::size_t j = 0U; j < k; ++j)
+                        {
+                            uint32_t undo = (((colors[bucket[b][j]] * 0x85EBCA77U) >> (32U - slotBits)) + shift) & mask;
+                            entry[undo] = NONE;
+                            key[undo] = 0U;
+                        }
+                    }
+                }
+                displacement[b] = shift;
+            }
+            if (!placed)
+            {
+                return false;
+            }
+        }
+
+        // an empty slot may still match a color missing from the table, its value is missing then
+        value.assign(key.size(), 0U);
+        for (std::size_t i = 0U; i < key.size(); ++i)
+        {
+            value[i] = entry[i] == NONE ? 0U : entry[i];
+        }
+        missing = 0U;
+        return true;
+    }
+
+    uint32_t slotBits{2U};
+    uint32_t bucketBits{1U};
+    std::size_t entryCount{};
+    std::vector<uint32_t> key;
+    std::vector<uint32_t> value;
+    std::vector<uint32_t> entry;
+    std::vector<uint32_t> displacement;
+    uint32_t missing{};
+};
+
+// One mapped .annot file: the (vertex, color) pairs stay in the mapped pages and are only read by the
+// decode passes, the color table is parsed up front.
+struct Hemisphere
+{
+    MappedFile file;
+    int pointsCount{};
+    const unsigned char* pairs{};
+    std::vector<ColorTableItem> color;
+    ColorLookup lookup;
+    bool sequential{};             // the pairs list vertex 0, 1, ... in order, so labels are written in order
+    std::vector<char> used;        // per color table entry
+};
+
+bool readHemisphere(const std::filesystem::path& path, Hemisphere& hemisphere) noexcept
+{
+    hemisphere.file = MappedFile::open(path);
+    if (hemisphere.file.empty())
+    {
+        return false;
+    }
+
+    BinaryReader reader(hemisphere.file);
+    BinaryCursor cursor(reader);
+    hemisphere.pointsCount = cursor.read4Bytes();
+    if (hemisphere.pointsCount <= 0)
+    {
+        logError() << "Invalid freesurfer annotation header!";
+        return false;
+    }
+    hemisphere.pairs = cursor.take(static_cast<std::size_t>(hemisphere.pointsCount) * 8U);
+
+    cursor.read4Bytes();
+    int entriesCount = cursor.read4Bytes();
+    hemisphere.color = entriesCount > 0 ? readOldVersionColorTable(cursor, entriesCount) : readNewVersionColorTable(cursor, entriesCount);
+    if (!cursor.valid())
+    {
+        logError() << "Freesurfer annotation " << path << " is truncated!";
+        return false;
+    }
+    if (hemisphere.color.empty())
+    {
+        return false;
+    }
+
+    bool unique = true;
+    hemisphere.lookup = ColorLookup::build(hemisphere.color, unique);
+    if (!unique)
+    {
+        // NOTE: This is not an error?
+        logWarning() << "The colors in the color table are not unique!";
+    }
+    return true;
+}
+
+// First pass, over the pairs only: which color table entries end up in the labels. Vertices without a pair
+// keep entry 0. When the pairs are not one per vertex in order, later pairs overwrite earlier ones, so the
+// labels are decoded to entry indices here and the usage is taken from them.
+void markUsedEntries(Hemisphere& hemisphere, uint32_t* label) noexcept
+{
+    std::size_t count = static_cast<std::size_t>(hemisphere.pointsCount);
+    hemisphere.used.assign(hemisphere.color.size() + 1U, 0);
+    hemisphere.sequential = true;
+    for (std::size_t i = 0U; i < count && hemisphere.sequential; ++i)
+    {
+        hemisphere.sequential = BinaryReader::load4Bytes(hemisphere.pairs + i * 8U) == i;
+    }
+
+    if (hemisphere.sequential)
+    {
+        for (std::size_t i = 0U; i < count; ++i)
+        {
+            hemisphere.used[hemisphere.lookup.find(BinaryReader::load4Bytes(hemisphere.pairs + i * 8U + 4U))] = 1;
+        }
+        // colors missing from the table fall back to entry 0
+        hemisphere.used[0] |= hemisphere.used[hemisphere.color.size()];
+    }
+    else
+    {
+        std::fill(label, label + count, 0U);
+        for (std::size_t i = 0U; i < count; ++i)
+        {
+            uint32_t vertex = BinaryReader::load4Bytes(hemisphere.pairs + i * 8U);
+            if (vertex < count)
+            {
+                label[vertex] = hemisphere.lookup(BinaryReader::load4Bytes(hemisphere.pairs + i * 8U + 4U));
+            }
+        }
+        std::for_each(label, label + count, [&hemisphere](uint32_t entry) { hemisphere.used[entry] = 1; });
+    }
+    hemisphere.used.pop_back();
+}
+
+// Second pass: final label ids straight into the output, one lookup per vertex.
+void writeLabels(Hemisphere& hemisphere, const std::vector<uint32_t>& table, uint32_t* label) noexcept
+{
+    std::size_t count = static_cast<std::size_t>(hemisphere.pointsCount);
+    if (hemisphere.sequential)
+    {
+        hemisphere.lookup.translate(table);
+        const ColorLookup& lookup = hemisphere.lookup;
+        const unsigned char* pairs = hemisphere.pairs;
+        for (std::size_t i = 0U; i < count; ++i)
+        {
+            label[i] = lookup(BinaryReader::load4Bytes(pairs + i * 8U + 4U));
+        }
+    }
+    else
+    {
+        std::for_each(label, label + count, [&table](uint32_t& entry) { entry = table[entry]; });
+    }
+}
+
+}
+
+Annotation loadFreeSurferAnnotation(const std::filesystem::path& lpath, const std::filesystem::path& rpath) noexcept
+{
+    if (!checkAnnotationFilePath(lpath, rpath))
+    {
+        logError() << "File not exist or invalid file name!";
+        return {};
+    }
+
+    // map both files and parse their color tables on separate threads
+    Hemisphere hemisphere[2];
+    const std::filesystem::path* path[2] = {&lpath, &rpath};
+    bool valid[2] = {false, false};
+    parallelInvoke(2U, [&](std::size_t i) { valid[i] = readHemisphere(*path[i], hemisphere[i]); });
+    if (!valid[0] || !valid[1])
+    {
+        return {};
+    }
+
+    std::vector<uint32_t> labelIndex(static_cast<std::size_t>(hemisphere[0].pointsCount) + hemisphere[1].pointsCount);
+    uint32_t* begin[2] = {labelIndex.data(), labelIndex.data() + hemisphere[0].pointsCount};
+    // the decode phases are timed once around both hemispheres, so the stages of this function are
+    // consecutive wall-clock intervals
+    uint64_t pointsCount = labelIndex.size();
+    {
+        StageTimer timer(Stage::Decode, pointsCount * 8U);
+        parallelInvoke(2U, [&](std::size_t i) { markUsedEntries(hemisphere[i], begin[i]); });
+    }
+
+    // merge left and right color table by name, the right entries whose name the left table lacks are
+    // appended; merged[1] maps right color index to merged color index
+    std::vector<ColorTableItem>& left = hemisphere[0].color;
+    std::vector<ColorTableItem>& right = hemisphere[1].color;
+    std::vector<uint32_t> merged[2] = {std::vector<uint32_t>(left.size()), std::vector<uint32_t>(right.size())};
+    std::size_t mergedCount = left.size();
+    {
+        StageTimer timer(Stage::Merge);
+        std::iota(merged[0].begin(), merged[0].end(), 0U);
+        std::vector<uint32_t> byName(left.size());
+        std::iota(byName.begin(), byName.end(), 0U);
+        std::stable_sort(byName.begin(), byName.end(), [&left](uint32_t a, uint32_t b) { return left[a].name < left[b].name; });
+        for (uint32_t i = 0U; i < right.size(); ++i)
+        {
+            auto iter = std::lower_bound(byName.begin(), byName.end(), right[i].name,
+                [&left](uint32_t a, const std::string& name) { return left[a].name < name; });
+            merged[1][i] = iter != byName.end() && left[*iter].name == right[i].name ? *iter : static_cast<uint32_t>(mergedCount++);
+        }
+    }
+
+    // only hold useful color item: number the merged entries used by either half in merged order, and fold
+    // merge and compaction into one table per half
+    Annotation annotation;
+    {
+        StageTimer timer(Stage::Remap);
+        std::vector<char> flag(mergedCount, 0);
+        std::vector<const ColorTableItem*> source(mergedCount, nullptr);
+        for (std::size_t h = 0U; h < 2U; ++h)
+        {
+            for (std::size_t i = 0U; i < merged[h].size(); ++i)
+            {
+                flag[merged[h][i]] |= hemisphere[h].used[i];
+                source[merged[h][i]] = source[merged[h][i]] == nullptr ? &hemisphere[h].color[i] : source[merged[h][i]];
+            }
+        }
+        std::vector<uint32_t> compact(mergedCount, 0U);
+        for (std::size_t i = 0U; i < mergedCount; ++i)
+        {
+            if (flag[i])
+            {
+                compact[i] = static_cast<uint32_t>(annotation.colorTable.size());
+                annotation.colorTable.emplace_back(*source[i]);
+            }
+        }
+        for (auto& table : merged)
+        {
+            std::for_each(table.begin(), table.end(), [&compact](uint32_t& i) { i = compact[i]; });
+        }
+    }
+
+    {
+        StageTimer timer(Stage::Decode, pointsCount * 4U);
+        parallelInvoke(2U, [&](std::size_t i) { writeLabels(hemisphere[i], merged[i], begin[i]); });
+    }
+    annotation.labelIndex = std::move(labelIndex);
+    return annotation;
+}
+
+void showAnnotationInformation(const Annotation& annotation) noexcept
+{
+    logInfo() << "Annotation information:";
+    logInfo() << "    Color table size: " << annotation.colorTable.size();
+    logInfo() << "    Label index size: " << annotation.labelIndex.size();
+
+    // one line per region is only wanted when debugging
+    if (logEnabled(LogLevel::Debug))
+    {
+        logDebug() << "Label name:";
+        for (auto& colorItem : annotation.colorTable)
+        {
+            logDebug() << "    " << colorItem.name;
+        }
+    }
+}
+
+bool save(const std::filesystem::path& path, const Annotation& annotation, bool regionIndex) noexcept
+{
+    // label names go to one string pool, so the color table itself is fixed size
+    std::vector<ColorRecord> record;
+    std::vector<char> namePool;
+    for (auto& colorItem : annotation.colorTable)
+    {
+        record.emplace_back(ColorRecord{colorItem.R, colorItem.G, colorItem.B, colorItem.A,
+            static_cast<uint32_t>(namePool.size()), static_cast<uint32_t>(colorItem.name.length())});
+        namePool.insert(namePool.end(), colorItem.name.begin(), colorItem.name.end());
+    }
+
+    ContainerWriter writer;
+    writer.addSection(SectionId::ColorTable, record);
+    writer.addSection(SectionId::NamePool, namePool);
+
+    // labels take a few bits per vertex instead of a full uint32_t
+    auto labels = CompressedLabels::encode({annotation.labelIndex.data(), annotation.labelIndex.size()}, annotation.colorTable.size());
+    labels.addSections(writer);
+
+    // the inverted index on request, so per-region queries need no scan after loading
+    RegionIndex index;
+    if (regionIndex)
+    {
+        index = RegionIndex::build(annotation);
+        writer.addSection(SectionId::RegionOffset, index.offsetStorage);
+        writer.addSection(SectionId::RegionVertex, index.vertexStorage);
+    }
+    if (!writer.save(path))
+    {
+        return false;
+    }
+
+    logInfo() << "Save annotation to " << std::filesystem::absolute(path);
+    return true;
+}
+
+std::string annotationDataFileName(const std::filesystem::path& lpath) noexcept
+{
+    auto stem = lpath.stem().string();
+    auto pos = stem.find_first_of('.');
+    return "annotation." + (pos == stem.npos ? "" : stem.substr(pos + 1)) + ".data";
+}
+
+}
\ No newline at end of file
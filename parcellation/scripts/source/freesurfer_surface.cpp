@@ -0,0 +1,326 @@
+// Author: cute-giggle@outlook.com
+
+#include <set>
+#include <filesystem>
+
+#include "freesurfer.h"
+#include "binary_reader.h"
+#include "container.h"
+#include "vertex_area.h"
+#include "mesh_topology.h"
+#include "spatial_index.h"
+#include "log.h"
+#include "metrics.h"
+
+#include "parallel.h"
+
+namespace fsaverage
+{
+// Refer to [nibabel.freesurfer.io.py].
+// About freesurfer surrface file formats, see [http://www.grahamwideman.com/gw/brain/fs/surfacefileformats.htm].
+
+namespace
+{
+constexpr int TRIA_MAGIC = 16777214;
+constexpr int QUAD_MAGIC = 16777215;
+constexpr int NEWQ_MAGIC = 16777213;
+
+constexpr auto SURFACE_FILE_NAME_FORMAT = "[lh/rh].[orig/white/pial/inflated/sphere/sphere.reg]";
+
+bool checkSurfaceFilePath(const std::filesystem::path& lpath, const std::filesystem::path& rpath) noexcept
+{
+    if (!std::filesystem::exists(lpath) || !std::filesystem::exists(rpath))
+    {
+        return false;
+    }
+
+    // the surface kind is everything after the hemisphere, e.g. sphere.reg for lh.sphere.reg
+    auto lname = lpath.filename().string();
+    auto rname = rpath.filename().string();
+    static const std::set<std::string> kindSet{"orig", "white", "pial", "inflated", "sphere", "sphere.reg"};
+    return lname.find("lh.") == 0U && rname.find("rh.") == 0U && lname.substr(3U) == rname.substr(3U) && kindSet.count(lname.substr(3U));
+}
+
+// Number of elements decoded per chunk, so the staging buffer stays cache resident.
+// A multiple of 3 and 4, so every chunk starts at an x coordinate and at a quad.
+constexpr std::size_t CHUNK_ELEMENTS = 12U * 1024U;
+
+struct SurfaceHeader
+{
+    int magic{};
+    int vertCount{};
+    int faceCount{};  // faces as stored in the file, quads for QUAD_MAGIC and NEWQ_MAGIC
+    std::size_t pointOffset{};
+
+    std::size_t triangleCount() const noexcept
+    {
+        return magic == TRIA_MAGIC ? static_cast<std::size_t>(faceCount) : static_cast<std::size_t>(faceCount) * 2U;
+    }
+
+    std::size_t pointBytes() const noexcept
+    {
+        return static_cast<std::size_t>(vertCount) * 3U * (magic == QUAD_MAGIC ? sizeof(short) : sizeof(float));
+    }
+
+    std::size_t faceOffset() const noexcept
+    {
+        return pointOffset + pointBytes();
+    }
+
+    std::size_t faceBytes() const noexcept
+    {
+        return static_cast<std::size_t>(faceCount) * (magic == TRIA_MAGIC ? 3U * sizeof(int) : 4U * 3U);
+    }
+};
+
+// Widen range by the x coordinates in [begin, end), begin must point at an x coordinate.
+void updateSurfaceRange(const float* begin, const float* end, std::pair<float, float>& range) noexcept
+{
+    for (auto iter = begin; iter < end; iter += 3)
+    {
+        range.first = std::min(range.first, *iter);
+        range.second = std::max(range.second, *iter);
+    }
+}
+
+SurfaceHeader readHeader(const BinaryReader& reader) noexcept
+{
+    BinaryCursor cursor(reader);
+
+    // read magic
+    SurfaceHeader header{cursor.read3Bytes()};
+
+    if (header.magic == TRIA_MAGIC)
+    {
+        // jump two lines file information
+        cursor.skipLine();
+        cursor.skipLine();
+
+        // get vertex count
+        header.vertCount = cursor.read4Bytes();
+        // get face count
+        header.faceCount = cursor.read4Bytes();
+    }
+    else if (header.magic == QUAD_MAGIC || header.magic == NEWQ_MAGIC)
+    {
+        // read vertex count
+        header.vertCount = cursor.read3Bytes();
+        // read face count
+        header.faceCount = cursor.read3Bytes();
+    }
+    else
+    {
+        logError() << "File does not appear to be a freesurfer surface!";
+        return {};
+    }
+
+    if (!cursor.valid() || header.vertCount <= 0 || header.faceCount <= 0)
+    {
+        logError() << "Invalid freesurfer surface header!";
+        return {};
+    }
+    header.pointOffset = cursor.offset();
+    if (!reader.contains(header.faceOffset(), header.faceBytes()))
+    {
+        logError() << "Freesurfer surface data is truncated!";
+        return {};
+    }
+    return header;
+}
+
+// Decode the vertex section into point, which must hold vertCount * 3 floats. The x axis range (always
+// including 0) is collected while each chunk is still in cache.
+void readPoints(const BinaryReader& reader, const SurfaceHeader& header, float* point, std::pair<float, float>& range) noexcept
+{
+    range = {0.f, 0.f};
+    StageAccumulator swap(Stage::Swap);
+    std::size_t pointCount = static_cast<std::size_t>(header.vertCount) * 3U;
+    if (header.magic == QUAD_MAGIC)
+    {
+        // fixed point coordinates in hundredths of a millimetre
+        std::vector<short> buffer(CHUNK_ELEMENTS);
+        for (std::size_t done = 0U; done < pointCount;)
+        {
+            std::size_t count = std::min(CHUNK_ELEMENTS, pointCount - done);
+            swap.measure(count * sizeof(short), [&]() { reader.readSequence(header.pointOffset + done * sizeof(short), buffer.data(), count); });
+            std::transform(buffer.begin(), buffer.begin() + count, point + done, [](short val) -> float { return static_cast<float>(val) / 100.f; });
+            updateSurfaceRange(point + done, point + done + count, range);
+            done += count;
+        }
+        return;
+    }
+
+    // float data has its final size, so copy and swap it in place chunk by chunk while it is still in cache
+    for (std::size_t done = 0U; done < pointCount;)
+    {
+        std::size_t count = std::min(CHUNK_ELEMENTS, pointCount - done);
+        swap.measure(count * sizeof(float), [&]() { reader.readSequence(header.pointOffset + done * sizeof(float), point + done, count); });
+        updateSurfaceRange(point + done, point + done + count, range);
+        done += count;
+    }
+}
+
+// Decode the face section into face, which must hold triangleCount() * 3 ints. faceOffset is added to every
+// vertex index.
+void readFaces(const BinaryReader& reader, const SurfaceHeader& header, int* face, int faceOffset) noexcept
+{
+    StageAccumulator swap(Stage::Swap);
+    std::size_t offset = header.faceOffset();
+    if (header.magic == TRIA_MAGIC)
+    {
+        std::size_t faceCount = static_cast<std::size_t>(header.faceCount) * 3U;
+        for (std::size_t done = 0U; done < faceCount;)
+        {
+            std::size_t count = std::min(CHUNK_ELEMENTS, faceCount - done);
+            swap.measure(count * sizeof(int), [&]() { reader.readSequence(offset + done * sizeof(int), face + done, count); });
+            std::for_each(face + done, face + done + count, [faceOffset](int& i) { i += faceOffset; });
+            done += count;
+        }
+        return;
+    }
+
+    // split every quad into two triangles, choosing the diagonal by the parity of the first vertex
+    constexpr std::size_t CHUNK_QUADS = CHUNK_ELEMENTS / 4U;
+    std::vector<int> quad(CHUNK_QUADS * 4U);
+    for (std::size_t done = 0U; done < static_cast<std::size_t>(header.faceCount);)
+    {
+        std::size_t count = std::min(CHUNK_QUADS, static_cast<std::size_t>(header.faceCount) - done);
+        swap.measure(count * 4U * 3U, [&]() { reader.read3BytesMany(offset + done * 4U * 3U, quad.data(), count * 4U); });
+        int* output = face + done * 6U;
+        for (std::size_t i = 0U; i < count; ++i, output += 6)
+        {
+            const int* q = quad.data() + i * 4U;
+            if (q[0] % 2 == 0)
+            {
+                output[0] = q[0]; output[1] = q[1]; output[2] = q[3];
+                output[3] = q[2]; output[4] = q[3]; output[5] = q[1];
+            }
+            else
+            {
+                output[0] = q[0]; output[1] = q[1]; output[2] = q[2];
+                output[3] = q[0]; output[4] = q[2]; output[5] = q[3];
+            }
+            std::for_each(output, output + 6, [faceOffset](int& i) { i += faceOffset; });
+        }
+        done += count;
+    }
+}
+
+}
+
+Surface loadFreeSurferSurface(const std::filesystem::path& lpath, const std::filesystem::path& rpath) noexcept
+{
+    if (!checkSurfaceFilePath(lpath, rpath))
+    {
+        logError() << "File not exist or invalid file name!";
+        return {};
+    }
+
+    MappedFile file[2] = {MappedFile::open(lpath), MappedFile::open(rpath)};
+    if (file[0].empty() || file[1].empty())
+    {
+        return {};
+    }
+
+    // size the merged surface once from both headers, which also check that every section is in the file
+    BinaryReader reader[2] = {BinaryReader(file[0]), BinaryReader(file[1])};
+    SurfaceHeader header[2] = {readHeader(reader[0]), readHeader(reader[1])};
+    if (header[0].magic == 0 || header[1].magic == 0)
+    {
+        return {};
+    }
+    std::size_t lpointCount = static_cast<std::size_t>(header[0].vertCount) * 3U;
+    std::size_t lfaceCount = header[0].triangleCount() * 3U;
+    Surface surface;
+    surface.point.resize(lpointCount + static_cast<std::size_t>(header[1].vertCount) * 3U);
+    surface.face.resize(lfaceCount + header[1].triangleCount() * 3U);
+
+    // decode the vertex and face sections of both hemispheres on separate threads, right faces refer to
+    // vertices after the left ones
+    float* point[2] = {surface.point.data(), surface.point.data() + lpointCount};
+    float* pointEnd[2] = {point[1], surface.point.data() + surface.point.size()};
+    int* face[2] = {surface.face.data(), surface.face.data() + lfaceCount};
+    int faceOffset[2] = {0, header[0].vertCount};
+    std::pair<float, float> range[2];
+    parallelInvoke(4U, [&](std::size_t task)
+    {
+        std::size_t i = task / 2U;
+        if (task % 2U == 0U)
+        {
+            StageTimer timer(Stage::Decode, header[i].pointBytes());
+            readPoints(reader[i], header[i], point[i], range[i]);
+        }
+        else
+        {
+            StageTimer timer(Stage::Decode, header[i].faceBytes());
+            readFaces(reader[i], header[i], face[i], faceOffset[i]);
+        }
+    });
+
+    // spheres keep the coordinates of the files: the hemispheres of a registered sphere are both centred on
+    // the origin, and a shift by the extent of each mesh would move two meshes of one space apart
+    auto kind = lpath.filename().string().substr(3U);
+    if (kind == "sphere" || kind == "sphere.reg")
+    {
+        return surface;
+    }
+
+    // adjust coordinate, left hemisphere ends at x = 0 and right hemisphere starts at x = 0
+    parallelInvoke(2U, [&](std::size_t i)
+    {
+        StageTimer timer(Stage::Merge, static_cast<uint64_t>(pointEnd[i] - point[i]) * sizeof(float));
+        float shift = (i == 0U ? -range[i].second : -range[i].first);
+        for (auto iter = point[i]; iter < pointEnd[i]; iter += 3)
+        {
+            *iter += shift;
+        }
+    });
+    return surface;
+}
+
+void showSurfaceInformation(const Surface& surface) noexcept
+{
+    logInfo() << "Surface information:";
+    logInfo() << "    Point count: " << surface.point.size() / 3U;
+    logInfo() << "    Face  count: " << surface.face.size()  / 3U;
+}
+
+bool save(const std::filesystem::path& path, const Surface& surface, bool index) noexcept
+{
+    ContainerWriter writer;
+    writer.addSection(SectionId::Point, surface.point);
+    writer.addSection(SectionId::Face, surface.face);
+
+    // on request, cache the area weights, the connectivity and the spatial index, so analysis tools map them
+    // instead of rebuilding them on every load
+    Span<const float> point{surface.point.data(), surface.point.size()};
+    Span<const int> face{surface.face.data(), surface.face.size()};
+    std::vector<float> area;
+    MeshTopology topology;
+    SpatialIndex spatialIndex;
+    if (index)
+    {
+        area = computeVertexArea(point, face, FaceIncidence::build(face, surface.point.size() / 3U));
+        writer.addSection(SectionId::VertexArea, area);
+        topology = MeshTopology::build(face, surface.point.size() / 3U);
+        topology.addSections(writer);
+        spatialIndex = SpatialIndex::build(point, face);
+        spatialIndex.addSections(writer);
+    }
+    if (!writer.save(path))
+    {
+        return false;
+    }
+
+    logInfo() << "Save surface to " << std::filesystem::absolute(path);
+    return true;
+}
+
+std::string surfaceDataFileName(const std::filesystem::path& lpath) noexcept
+{
+    auto name = lpath.filename().string();
+    auto pos = name.find_first_of('.');
+    return "surface." + (pos == name.npos ? name : name.substr(pos + 1U)) + ".data";
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,241 @@
+// Author: cute-giggle@outlook.com
+
+#include "geodesic.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "parallel.h"
+#include "thread_pool.h"
+#include "log.h"
+
+namespace fsaverage
+{
+
+namespace
+{
+constexpr std::size_t VERTEX_GRAIN = 1U << 15;
+
+// Upper bound of the bucket ring, which bounds the width of a bucket from below on meshes with tiny edges.
+constexpr std::size_t MAX_BUCKETS = 1U << 12;
+
+constexpr float INFINITE = std::numeric_limits<float>::infinity();
+
+// Circular array of buckets of width delta (Dial's queue). Tentative distances never exceed the current
+// bucket by more than the longest edge, so a ring of maxEdge / delta + 2 buckets holds them all. Vertices
+// inside one bucket are expanded in any order and may be expanded again when improved within it, which is
+// still exact: the search is label-correcting inside a bucket and label-setting across buckets.
+class BucketQueue
+{
+public:
+    BucketQueue(float delta, std::size_t bucketCount) noexcept : delta(delta), bucket(bucketCount) {}
+
+    void push(uint32_t vertex, float distance) noexcept
+    {
+        bucket[index(distance) % bucket.size()].emplace_back(vertex);
+        ++count;
+    }
+
+    bool empty() const noexcept
+    {
+        return count == 0U;
+    }
+
+    // Move the contents of the lowest non-empty bucket to items and return its index.
+    std::size_t popBucket(std::vector<uint32_t>& items) noexcept
+    {
+        while (bucket[current % bucket.size()].empty())
+        {
+            ++current;
+        }
+        items.clear();
+        items.swap(bucket[current % bucket.size()]);
+        count -= items.size();
+        return current;
+    }
+
+    std::size_t index(float distance) const noexcept
+    {
+        return static_cast<std::size_t>(distance / delta);
+    }
+
+private:
+    float delta;
+    std::vector<std::vector<uint32_t>> bucket;
+    std::size_t current{0U};
+    std::size_t count{0U};
+};
+
+struct BucketLayout
+{
+    float delta;
+    std::size_t bucketCount;
+};
+
+BucketLayout bucketLayout(Span<const float> edgeLength) noexcept
+{
+    float shortest = INFINITE;
+    float longest = 0.f;
+    for (float length : edgeLength)
+    {
+        if (length > 0.f)
+        {
+            shortest = std::min(shortest, length);
+        }
+        longest = std::max(longest, length);
+    }
+    if (longest <= 0.f)
+    {
+        return {1.f, 2U};
+    }
+
+    float delta = std::max(shortest, longest / static_cast<float>(MAX_BUCKETS));
+    return {delta, static_cast<std::size_t>(std::ceil(longest / delta)) + 2U};
+}
+
+void search(const MeshTopology& topology, Span<const float> edgeLength, Span<const uint32_t> sources, float maxDistance,
+    const BucketLayout& layout, std::vector<float>& distance) noexcept
+{
+    distance.assign(topology.vertexCount(), INFINITE);
+    BucketQueue queue(layout.delta, layout.bucketCount);
+    for (uint32_t vertex : sources)
+    {
+        if (vertex < distance.size() && distance[vertex] != 0.f)
+        {
+            distance[vertex] = 0.f;
+            queue.push(vertex, 0.f);
+        }
+    }
+
+    std::vector<uint32_t> items;
+    while (!queue.empty())
+    {
+        std::size_t current = queue.popBucket(items);
+        for (std::size_t i = 0U; i < items.size(); ++i)
+        {
+            uint32_t vertex = items[i];
+            float base = distance[vertex];
+            if (queue.index(base) != current || base > maxDistance)
+            {
+                continue;   // stale entry, the vertex was improved into an earlier bucket since
+            }
+            for (uint32_t e = topology.neighborOffset[vertex]; e < topology.neighborOffset[vertex + 1U]; ++e)
+            {
+                uint32_t neighbor = topology.neighbor[e];
+                float candidate = base + edgeLength[e];
+                if (candidate < distance[neighbor])
+                {
+                    distance[neighbor] = candidate;
+                    if (queue.index(candidate) == current)
+                    {
+                        items.emplace_back(neighbor);
+                    }
+                    else
+                    {
+                        queue.push(neighbor, candidate);
+                    }
+                }
+            }
+        }
+    }
+}
+
+}
+
+std::vector<float> computeEdgeLength(Span<const float> point, const MeshTopology& topology) noexcept
+{
+    std::size_t vertexCount = topology.vertexCount();
+    std::vector<float> length(topology.neighbor.size());
+    if (point.size() / 3U != vertexCount)
+    {
+        logError() << "Mesh topology does not match the surface!";
+        return {};
+    }
+
+    parallelBlocks(vertexCount, blockCount(vertexCount, VERTEX_GRAIN), [&](std::size_t, std::size_t begin, std::size_t end)
+    {
+        for (std::size_t v = begin; v < end; ++v)
+        {
+            const float* a = point.data() + v * 3U;
+            for (uint32_t e = topology.neighborOffset[v]; e < topology.neighborOffset[v + 1U]; ++e)
+            {
+                const float* b = point.data() + topology.neighbor[e] * std::size_t{3U};
+                float x = b[0] - a[0];
+                float y = b[1] - a[1];
+                float z = b[2] - a[2];
+                length[e] = std::sqrt(x * x + y * y + z * z);
+            }
+        }
+    });
+    return length;
+}
+
+std::vector<float> computeGeodesicDistance(const MeshTopology& topology, Span<const float> edgeLength,
+    Span<const uint32_t> sources, float maxDistance) noexcept
+{
+    if (edgeLength.size() != topology.neighbor.size())
+    {
+        logError() << "Edge lengths do not match the mesh topology!";
+        return {};
+    }
+
+    std::vector<float> distance;
+    search(topology, edgeLength, sources, maxDistance, bucketLayout(edgeLength), distance);
+    return distance;
+}
+
+RegionDistance computeRegionDistance(const MeshTopology& topology, Span<const float> edgeLength, const RegionIndex& regions,
+    Span<const uint32_t> labelIndex, const std::vector<bool>& source, float maxDistance, std::size_t threadCount) noexcept
+{
+    std::size_t regionCount = regions.regionCount();
+    if (edgeLength.size() != topology.neighbor.size() || labelIndex.size() != topology.vertexCount() || source.size() != regionCount)
+    {
+        logError() << "Mesh topology, edge lengths, annotation and region selection do not match!";
+        return {};
+    }
+
+    RegionDistance result{regionCount, std::vector<float>(regionCount * regionCount, INFINITE)};
+    BucketLayout layout = bucketLayout(edgeLength);
+    {
+        // one task per source region; tasks differ a lot in cost, which is what the stealing is for
+        ThreadPool pool(threadCount);
+        for (uint32_t region = 0U; region < regionCount; ++region)
+        {
+            if (!source[region] || regions.count(region) == 0U)
+            {
+                continue;
+            }
+            pool.submit([&, region]()
+            {
+                std::vector<float> distance;
+                search(topology, edgeLength, regions.vertices(region), maxDistance, layout, distance);
+
+                float* row = result.distance.data() + region * regionCount;
+                for (std::size_t v = 0U; v < distance.size(); ++v)
+                {
+                    uint32_t label = labelIndex[v];
+                    if (label < regionCount && distance[v] <= maxDistance)
+                    {
+                        row[label] = std::min(row[label], distance[v]);
+                    }
+                }
+            });
+        }
+        pool.wait();
+    }
+
+    // searches from other regions still reach the unselected ones
+    for (std::size_t row = 0U; row < regionCount; ++row)
+    {
+        for (std::size_t region = 0U; region < regionCount; ++region)
+        {
+            if (!source[region])
+            {
+                result.distance[row * regionCount + region] = INFINITE;
+            }
+        }
+    }
+    return result;
+}
+
+}
\ No newline at end of file
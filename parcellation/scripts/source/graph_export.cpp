@@ -0,0 +1,142 @@
+// Author: cute-giggle@outlook.com
+
+#include "graph_export.h"
+
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <future>
+#include <algorithm>
+
+#include "parallel.h"
+#include "log.h"
+
+namespace fsaverage
+{
+
+namespace
+{
+constexpr std::size_t ROW_GRAIN = 1U << 14;
+
+// Rows formatted per window; bounds the text held in memory to two windows whatever the store size.
+constexpr std::size_t WINDOW_ROWS = 1U << 20;
+
+// Every field is quoted, so names with commas or quotes survive; quotes inside are doubled.
+void appendQuoted(std::string& text, std::string_view field) noexcept
+{
+    text.push_back('"');
+    for (char c : field)
+    {
+        if (c == '"')
+        {
+            text.push_back('"');
+        }
+        text.push_back(c);
+    }
+    text.push_back('"');
+}
+
+// Stream rowCount rows to path. Window k + 1 is formatted in parallel blocks while window k is written.
+template<typename Format>
+bool writeCsv(const std::filesystem::path& path, std::string_view header, std::size_t rowCount, Format&& format) noexcept
+{
+    std::ofstream output(path, std::ios::binary);
+    if (!output.is_open())
+    {
+        logError() << "Open " << path << " failed!";
+        return false;
+    }
+    output.write(header.data(), header.size());
+
+    std::vector<std::string> buffer[2];
+    std::future<void> writing;
+    for (std::size_t window = 0U, begin = 0U; begin < rowCount; ++window, begin += WINDOW_ROWS)
+    {
+        std::size_t size = std::min(WINDOW_ROWS, rowCount - begin);
+        auto& blocks = buffer[window % 2U];
+        blocks.resize(blockCount(size, ROW_GRAIN));
+        parallelBlocks(size, blocks.size(), [&](std::size_t block, std::size_t first, std::size_t last)
+        {
+            auto& text = blocks[block];
+            text.clear();
+            for (std::size_t row = first; row < last; ++row)
+            {
+                format(begin + row, text);
+            }
+        });
+
+        if (writing.valid())
+        {
+            writing.get();
+        }
+        writing = std::async(std::launch::async, [&output, &blocks]()
+        {
+            for (auto& text : blocks)
+            {
+                output.write(text.data(), text.size());
+            }
+        });
+    }
+    if (writing.valid())
+    {
+        writing.get();
+    }
+
+    output.close();
+    if (!output)
+    {
+        logError() << "Write " << path << " failed!";
+        return false;
+    }
+    return true;
+}
+
+}
+
+bool exportNeo4jImport(const TripleStore& store, const std::filesystem::path& directory) noexcept
+{
+    if (store.empty())
+    {
+        return false;
+    }
+
+    // terms are already interned and triples deduplicated, so a node is a term used as subject or object
+    std::vector<uint8_t> isEntity(store.termCount(), 0U);
+    for (auto& triple : store.spo)
+    {
+        isEntity[triple.subject] = 1U;
+        isEntity[triple.object] = 1U;
+    }
+    std::vector<uint32_t> entity;
+    for (uint32_t id = 0U; id < isEntity.size(); ++id)
+    {
+        if (isEntity[id])
+        {
+            entity.emplace_back(id);
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    bool entities = writeCsv(directory / NEO4J_ENTITY_FILE, "name:ID(Entity),:LABEL\n", entity.size(),
+        [&](std::size_t row, std::string& text)
+    {
+        appendQuoted(text, store.term(entity[row]));
+        text.append(",Entity\n");
+    });
+    bool relations = entities && writeCsv(directory / NEO4J_RELATION_FILE, ":START_ID(Entity),:END_ID(Entity),:TYPE,name\n",
+        store.size(), [&](std::size_t row, std::string& text)
+    {
+        const Triple& triple = store.spo[row];
+        appendQuoted(text, store.term(triple.subject));
+        text.push_back(',');
+        appendQuoted(text, store.term(triple.object));
+        text.append(",RELATION,");
+        appendQuoted(text, store.term(triple.relation));
+        text.push_back('\n');
+    });
+    return relations;
+}
+
+}
\ No newline at end of file
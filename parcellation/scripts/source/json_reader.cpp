@@ -0,0 +1,345 @@
+// Author: cute-giggle@outlook.com
+
+#include "json_reader.h"
+
+#include <charconv>
+#include <limits>
+
+#include "mapped_file.h"
+#include "log.h"
+
+namespace fsaverage
+{
+
+namespace
+{
+// Deeper documents are rejected instead of overflowing the stack of the recursive descent.
+constexpr std::size_t MAX_DEPTH = 512U;
+
+class Parser
+{
+public:
+    explicit Parser(std::string_view text) noexcept : text(text) {}
+
+    bool document(JsonValue& result) noexcept
+    {
+        if (!value(result, 0U))
+        {
+            return false;
+        }
+        skipSpace();
+        return position == text.size();
+    }
+
+    std::size_t offset() const noexcept
+    {
+        return position;
+    }
+
+private:
+    void skipSpace() noexcept
+    {
+        while (position < text.size() && (text[position] == ' ' || text[position] == '\n' || text[position] == '\r' || text[position] == '\t'))
+        {
+            ++position;
+        }
+    }
+
+    bool literal(std::string_view word) noexcept
+    {
+        if (text.substr(position, word.size()) != word)
+        {
+            return false;
+        }
+        position += word.size();
+        return true;
+    }
+
+    bool value(JsonValue& result, std::size_t depth) noexcept
+    {
+        skipSpace();
+        if (position == text.size() || depth > MAX_DEPTH)
+        {
+            return false;
+        }
+
+        switch (text[position])
+        {
+        case '{':
+            return object(result, depth);
+        case '[':
+            return array(result, depth);
+        case '"':
+            result.type = JsonValue::Type::String;
+            return string(result.text);
+        case 't':
+            result.type = JsonValue::Type::Boolean;
+            result.boolean = true;
+            return literal("true");
+        case 'f':
+            result.type = JsonValue::Type::Boolean;
+            return literal("false");
+        case 'n':
+            result.type = JsonValue::Type::Null;
+            return literal("null");
+        default:
+            result.type = JsonValue::Type::Number;
+            return number(result.number);
+        }
+    }
+
+    bool object(JsonValue& result, std::size_t depth) noexcept
+    {
+        result.type = JsonValue::Type::Object;
+        ++position;
+        skipSpace();
+        if (position < text.size() && text[position] == '}')
+        {
+            ++position;
+            return true;
+        }
+        while (true)
+        {
+            skipSpace();
+            result.name.emplace_back();
+            if (position == text.size() || text[position] != '"' || !string(result.name.back()))
+            {
+                return false;
+            }
+            skipSpace();
+            if (position == text.size() || text[position++] != ':')
+            {
+                return false;
+            }
+            result.item.emplace_back();
+            if (!value(result.item.back(), depth + 1U))
+            {
+                return false;
+            }
+            skipSpace();
+            if (position == text.size())
+            {
+                return false;
+            }
+            char c = text[position++];
+            if (c == '}')
+            {
+                return true;
+            }
+            if (c != ',')
+            {
+                return false;
+            }
+        }
+    }
+
+    bool array(JsonValue& result, std::size_t depth) noexcept
+    {
+        result.type = JsonValue::Type::Array;
+        ++position;
+        skipSpace();
+        if (position < text.size() && text[position] == ']')
+        {
+            ++position;
+            return true;
+        }
+        while (true)
+        {
+            result.item.emplace_back();
+            if (!value(result.item.back(), depth + 1U))
+            {
+                return false;
+            }
+            skipSpace();
+            if (position == text.size())
+            {
+                return false;
+            }
+            char c = text[position++];
+            if (c == ']')
+            {
+                return true;
+            }
+            if (c != ',')
+            {
+                return false;
+            }
+        }
+    }
+
+    // NaN and +-Infinity are accepted because json.dump and JsonWriter both emit them.
+    bool number(double& result) noexcept
+    {
+        if (literal("NaN"))
+        {
+            result = std::numeric_limits<double>::quiet_NaN();
+            return true;
+        }
+        bool negative = position < text.size() && text[position] == '-';
+        if (literal(negative ? "-Infinity" : "Infinity"))
+        {
+            result = negative ? -std::numeric_limits<double>::infinity() : std::numeric_limits<double>::infinity();
+            return true;
+        }
+
+        auto [end, error] = std::from_chars(text.data() + position, text.data() + text.size(), result);
+        if (error != std::errc() || end == text.data() + position)
+        {
+            return false;
+        }
+        position = end - text.data();
+        return true;
+    }
+
+    bool hex(uint32_t& code) noexcept
+    {
+        if (text.size() - position < 4U)
+        {
+            return false;
+        }
+        auto [end, error] = std::from_chars(text.data() + position, text.data() + position + 4U, code, 16);
+        if (error != std::errc() || end != text.data() + position + 4U)
+        {
+            return false;
+        }
+        position += 4U;
+        return true;
+    }
+
+    static void appendUtf8(std::string& output, uint32_t code) noexcept
+    {
+        if (code < 0x80U)
+        {
+            output.push_back(static_cast<char>(code));
+        }
+        else if (code < 0x800U)
+        {
+            output.push_back(static_cast<char>(0xC0U | (code >> 6)));
+            output.push_back(static_cast<char>(0x80U | (code & 0x3FU)));
+        }
+        else if (code < 0x10000U)
+        {
+            output.push_back(static_cast<char>(0xE0U | (code >> 12)));
+            output.push_back(static_cast<char>(0x80U | ((code >> 6) & 0x3FU)));
+            output.push_back(static_cast<char>(0x80U | (code & 0x3FU)));
+        }
+        else
+        {
+            output.push_back(static_cast<char>(0xF0U | (code >> 18)));
+            output.push_back(static_cast<char>(0x80U | ((code >> 12) & 0x3FU)));
+            output.push_back(static_cast<char>(0x80U | ((code >> 6) & 0x3FU)));
+            output.push_back(static_cast<char>(0x80U | (code & 0x3FU)));
+        }
+    }
+
+    bool string(std::string& result) noexcept
+    {
+        ++position;
+        while (position < text.size())
+        {
+            // copy the run up to the next quote or escape in one go
+            std::size_t end = position;
+            while (end < text.size() && text[end] != '"' && text[end] != '\\')
+            {
+                ++end;
+            }
+            result.append(text.data() + position, end - position);
+            position = end;
+            if (position == text.size())
+            {
+                return false;
+            }
+            if (text[position++] == '"')
+            {
+                return true;
+            }
+            if (position == text.size())
+            {
+                return false;
+            }
+
+            char c = text[position++];
+            switch (c)
+            {
+            case '"':  result.push_back('"'); break;
+            case '\\': result.push_back('\\'); break;
+            case '/':  result.push_back('/'); break;
+            case 'b':  result.push_back('\b'); break;
+            case 'f':  result.push_back('\f'); break;
+            case 'n':  result.push_back('\n'); break;
+            case 'r':  result.push_back('\r'); break;
+            case 't':  result.push_back('\t'); break;
+            case 'u':
+            {
+                uint32_t code{};
+                if (!hex(code))
+                {
+                    return false;
+                }
+                // json.dump escapes everything outside ASCII, astral characters as surrogate pairs
+                if (code >= 0xD800U && code < 0xDC00U)
+                {
+                    uint32_t low{};
+                    if (!literal("\\u") || !hex(low) || low < 0xDC00U || low >= 0xE000U)
+                    {
+                        return false;
+                    }
+                    code = 0x10000U + ((code - 0xD800U) << 10) + (low - 0xDC00U);
+                }
+                appendUtf8(result, code);
+                break;
+            }
+            default:
+                return false;
+            }
+        }
+        return false;
+    }
+
+    std::string_view text;
+    std::size_t position{0U};
+};
+
+}
+
+const JsonValue* JsonValue::find(std::string_view key) const noexcept
+{
+    for (std::size_t i = 0U; i < name.size(); ++i)
+    {
+        if (name[i] == key)
+        {
+            return &item[i];
+        }
+    }
+    return nullptr;
+}
+
+JsonValue JsonValue::parse(std::string_view text) noexcept
+{
+    Parser parser(text);
+    JsonValue result;
+    if (!parser.document(result))
+    {
+        logError() << "Invalid JSON near offset " << parser.offset() << "!";
+        return {};
+    }
+    return result;
+}
+
+JsonValue JsonValue::load(const std::filesystem::path& path) noexcept
+{
+    auto file = MappedFile::open(path);
+    if (file.empty())
+    {
+        return {};
+    }
+
+    auto result = parse({reinterpret_cast<const char*>(file.data()), file.size()});
+    if (result.empty())
+    {
+        logError() << "Parse " << path << " failed!";
+    }
+    return result;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,184 @@
+// Author: cute-giggle@outlook.com
+
+#include "json_writer.h"
+
+#include <charconv>
+#include <algorithm>
+#include <cmath>
+
+namespace fsaverage
+{
+
+namespace
+{
+constexpr std::size_t BUFFER_SIZE = 1U << 16;
+}
+
+JsonWriter::JsonWriter(std::ostream& output, int indent) noexcept : output(output), indent(indent)
+{
+    buffer.reserve(BUFFER_SIZE + BUFFER_SIZE / 4U);
+}
+
+JsonWriter::~JsonWriter() noexcept
+{
+    flush();
+}
+
+void JsonWriter::flush() noexcept
+{
+    output.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    buffer.clear();
+}
+
+void JsonWriter::newline() noexcept
+{
+    if (indent > 0)
+    {
+        buffer.push_back('\n');
+        buffer.append(count.size() * static_cast<std::size_t>(indent), ' ');
+    }
+}
+
+void JsonWriter::separate() noexcept
+{
+    if (buffer.size() >= BUFFER_SIZE)
+    {
+        flush();
+    }
+    if (afterKey)
+    {
+        afterKey = false;
+        return;
+    }
+    if (!count.empty())
+    {
+        if (count.back()++ > 0U)
+        {
+            put(',');
+        }
+        newline();
+    }
+}
+
+void JsonWriter::close(char bracket) noexcept
+{
+    bool empty = count.back() == 0U;
+    count.pop_back();
+    if (!empty)
+    {
+        newline();
+    }
+    put(bracket);
+    if (count.empty())
+    {
+        flush();
+        if (indent > 0)
+        {
+            output.flush();
+        }
+    }
+}
+
+void JsonWriter::beginObject() noexcept
+{
+    separate();
+    put('{');
+    count.push_back(0U);
+}
+
+void JsonWriter::endObject() noexcept
+{
+    close('}');
+}
+
+void JsonWriter::beginArray() noexcept
+{
+    separate();
+    put('[');
+    count.push_back(0U);
+}
+
+void JsonWriter::endArray() noexcept
+{
+    close(']');
+}
+
+void JsonWriter::key(std::string_view name) noexcept
+{
+    separate();
+    string(name);
+    write(indent > 0 ? ": " : ":", indent > 0 ? 2 : 1);
+    afterKey = true;
+}
+
+void JsonWriter::value(std::string_view text) noexcept
+{
+    separate();
+    string(text);
+}
+
+void JsonWriter::value(double number) noexcept
+{
+    separate();
+    if (!std::isfinite(number))
+    {
+        write(std::isnan(number) ? "NaN" : (number > 0.0 ? "Infinity" : "-Infinity"), std::isnan(number) ? 3 : (number > 0.0 ? 8 : 9));
+        return;
+    }
+
+    // shortest round-trip form, with the trailing ".0" Python adds to integral floats
+    char digits[32];
+    auto end = std::to_chars(digits, digits + sizeof(digits), number).ptr;
+    bool integral = std::find_if(digits, end, [](char c) { return c == '.' || c == 'e' || c == 'n' || c == 'i'; }) == end;
+    write(digits, end - digits);
+    if (integral)
+    {
+        write(".0", 2);
+    }
+}
+
+void JsonWriter::value(int64_t number) noexcept
+{
+    separate();
+    char digits[24];
+    auto end = std::to_chars(digits, digits + sizeof(digits), number).ptr;
+    write(digits, end - digits);
+}
+
+void JsonWriter::value(uint64_t number) noexcept
+{
+    separate();
+    char digits[24];
+    auto end = std::to_chars(digits, digits + sizeof(digits), number).ptr;
+    write(digits, end - digits);
+}
+
+void JsonWriter::string(std::string_view text) noexcept
+{
+    static const char* hex = "0123456789abcdef";
+    put('"');
+    for (char c : text)
+    {
+        switch (c)
+        {
+        case '"':  write("\\\"", 2); break;
+        case '\\': write("\\\\", 2); break;
+        case '\n': write("\\n", 2); break;
+        case '\r': write("\\r", 2); break;
+        case '\t': write("\\t", 2); break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20U)
+            {
+                char escape[6] = {'\\', 'u', '0', '0', hex[(c >> 4) & 0xF], hex[c & 0xF]};
+                write(escape, 6);
+            }
+            else
+            {
+                put(c);
+            }
+        }
+    }
+    put('"');
+}
+
+}
\ No newline at end of file
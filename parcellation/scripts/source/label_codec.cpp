@@ -0,0 +1,258 @@
+// Author: cute-giggle@outlook.com
+
+#include "label_codec.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "BigEndianHelper.h"
+#include "parallel.h"
+#include "log.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define FSAVERAGE_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(FSAVERAGE_X86) && (defined(__GNUC__) || defined(__clang__))
+#define FSAVERAGE_TARGET(isa) __attribute__((target(isa)))
+#else
+#define FSAVERAGE_TARGET(isa)
+#endif
+
+namespace fsaverage
+{
+
+namespace
+{
+constexpr std::size_t VERTEX_GRAIN = 1U << 16;
+
+uint32_t bitWidth(uint32_t value) noexcept
+{
+    uint32_t width = 1U;
+    while (width < 32U && (value >> width) != 0U)
+    {
+        ++width;
+    }
+    return width;
+}
+
+// Every label is read with one unaligned 8-byte load at its first byte, which covers the at most
+// 7 + 32 bits it spans; the padding word keeps the load of the last label inside the array.
+std::size_t packedWordCount(std::size_t count, uint32_t width) noexcept
+{
+    return (count * width + 63U) / 64U + 1U;
+}
+
+uint32_t unpackOne(const unsigned char* bytes, uint32_t width, std::size_t i) noexcept
+{
+    std::size_t bit = i * width;
+    uint64_t value{};
+    std::memcpy(&value, bytes + (bit >> 3U), sizeof(value));
+    return static_cast<uint32_t>((value >> (bit & 7U)) & ((uint64_t{1} << width) - 1U));
+}
+
+void unpackScalar(const unsigned char* bytes, uint32_t width, std::size_t begin, std::size_t end, uint32_t* destination) noexcept
+{
+    for (std::size_t i = begin; i < end; ++i)
+    {
+        *destination++ = unpackOne(bytes, width, i);
+    }
+}
+
+#ifdef FSAVERAGE_X86
+
+FSAVERAGE_TARGET("avx2")
+void unpackAVX2(const unsigned char* bytes, uint32_t width, std::size_t begin, std::size_t end, uint32_t* destination) noexcept
+{
+    // 8 labels per step: two gathers of 4 unaligned 64-bit words, a variable shift and a mask per lane,
+    // then the low halves of the 64-bit lanes are packed to 8 integers
+    const long long w = width;
+    const __m256i lane = _mm256_setr_epi64x(0, w, 2 * w, 3 * w);
+    const __m256i step = _mm256_set1_epi64x(4 * w);
+    const __m256i mask = _mm256_set1_epi64x(static_cast<long long>((uint64_t{1} << width) - 1U));
+    const __m256i seven = _mm256_set1_epi64x(7);
+    const __m256i pick = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+    const auto* base = reinterpret_cast<const long long*>(bytes);
+
+    std::size_t i = begin;
+    for (; i + 8U <= end; i += 8U, destination += 8)
+    {
+        __m256i bit0 = _mm256_add_epi64(_mm256_set1_epi64x(static_cast<long long>(i) * w), lane);
+        __m256i bit1 = _mm256_add_epi64(bit0, step);
+        __m256i value0 = _mm256_i64gather_epi64(base, _mm256_srli_epi64(bit0, 3), 1);
+        __m256i value1 = _mm256_i64gather_epi64(base, _mm256_srli_epi64(bit1, 3), 1);
+        value0 = _mm256_and_si256(_mm256_srlv_epi64(value0, _mm256_and_si256(bit0, seven)), mask);
+        value1 = _mm256_and_si256(_mm256_srlv_epi64(value1, _mm256_and_si256(bit1, seven)), mask);
+        __m128i low = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(value0, pick));
+        __m128i high = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(value1, pick));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination), low);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + 4), high);
+    }
+    unpackScalar(bytes, width, i, end, destination);
+}
+
+#endif
+
+using UnpackKernel = void (*)(const unsigned char*, uint32_t, std::size_t, std::size_t, uint32_t*) noexcept;
+
+UnpackKernel unpackKernel() noexcept
+{
+#ifdef FSAVERAGE_X86
+    static const UnpackKernel selected = BigEndianHelper::simdLevel() == BigEndianHelper::SimdLevel::AVX2 ? unpackAVX2 : unpackScalar;
+#else
+    static const UnpackKernel selected = unpackScalar;
+#endif
+    return selected;
+}
+
+}
+
+uint32_t CompressedLabels::operator[] (std::size_t vertex) const noexcept
+{
+    if (encoding() == LabelEncoding::Packed)
+    {
+        return unpackOne(reinterpret_cast<const unsigned char*>(word.data()), header.bitWidth, vertex);
+    }
+    auto iter = std::upper_bound(run.begin(), run.end(), vertex, [](std::size_t v, const LabelRun& r) { return v < r.start; });
+    return (iter - 1)->label;
+}
+
+void CompressedLabels::decode(std::size_t begin, std::size_t end, uint32_t* destination) const noexcept
+{
+    if (encoding() == LabelEncoding::Packed)
+    {
+        unpackKernel()(reinterpret_cast<const unsigned char*>(word.data()), header.bitWidth, begin, end, destination);
+        return;
+    }
+
+    auto iter = std::upper_bound(run.begin(), run.end(), begin, [](std::size_t v, const LabelRun& r) { return v < r.start; }) - 1;
+    for (std::size_t i = begin; i < end; ++iter)
+    {
+        std::size_t runEnd = iter + 1 == run.end() ? end : std::min<std::size_t>(iter[1].start, end);
+        destination = std::fill_n(destination, runEnd - i, iter->label);
+        i = runEnd;
+    }
+}
+
+std::vector<uint32_t> CompressedLabels::decode() const noexcept
+{
+    std::vector<uint32_t> labelIndex(size());
+    parallelBlocks(labelIndex.size(), blockCount(labelIndex.size(), VERTEX_GRAIN), [&](std::size_t, std::size_t begin, std::size_t end)
+    {
+        decode(begin, end, labelIndex.data() + begin);
+    });
+    return labelIndex;
+}
+
+void CompressedLabels::addSections(ContainerWriter& writer) const noexcept
+{
+    writer.addSection(SectionId::LabelCodec, &header, sizeof(header), 1U);
+    if (encoding() == LabelEncoding::Packed)
+    {
+        writer.addSection(SectionId::PackedLabel, word.data(), sizeof(uint64_t), word.size());
+    }
+    else
+    {
+        writer.addSection(SectionId::LabelRun, run.data(), sizeof(LabelRun), run.size());
+    }
+}
+
+CompressedLabels CompressedLabels::pack(Span<const uint32_t> labelIndex, std::size_t regionCount) noexcept
+{
+    CompressedLabels labels;
+    if (labelIndex.empty())
+    {
+        return labels;
+    }
+
+    uint32_t maxLabel = regionCount > 0U ? static_cast<uint32_t>(regionCount - 1U) : 0U;
+    maxLabel = std::max(maxLabel, *std::max_element(labelIndex.begin(), labelIndex.end()));
+    uint32_t width = bitWidth(maxLabel);
+
+    // written through the same unaligned 8-byte window the decoder reads, so the layout does not depend on
+    // the word order of the host
+    labels.wordStorage.assign(packedWordCount(labelIndex.size(), width), 0U);
+    auto* bytes = reinterpret_cast<unsigned char*>(labels.wordStorage.data());
+    for (std::size_t i = 0U; i < labelIndex.size(); ++i)
+    {
+        std::size_t bit = i * width;
+        uint64_t value{};
+        std::memcpy(&value, bytes + (bit >> 3U), sizeof(value));
+        value |= static_cast<uint64_t>(labelIndex[i]) << (bit & 7U);
+        std::memcpy(bytes + (bit >> 3U), &value, sizeof(value));
+    }
+
+    labels.header = LabelCodecHeader{static_cast<uint32_t>(LabelEncoding::Packed), width, labelIndex.size()};
+    labels.word = {labels.wordStorage.data(), labels.wordStorage.size()};
+    return labels;
+}
+
+CompressedLabels CompressedLabels::runLength(Span<const uint32_t> labelIndex) noexcept
+{
+    CompressedLabels labels;
+    for (std::size_t i = 0U; i < labelIndex.size(); ++i)
+    {
+        if (i == 0U || labelIndex[i] != labelIndex[i - 1U])
+        {
+            labels.runStorage.emplace_back(LabelRun{static_cast<uint32_t>(i), labelIndex[i]});
+        }
+    }
+
+    labels.header = LabelCodecHeader{static_cast<uint32_t>(LabelEncoding::RunLength), 0U, labelIndex.size()};
+    labels.run = {labels.runStorage.data(), labels.runStorage.size()};
+    return labels;
+}
+
+CompressedLabels CompressedLabels::encode(Span<const uint32_t> labelIndex, std::size_t regionCount) noexcept
+{
+    std::size_t runCount = 0U;
+    for (std::size_t i = 0U; i < labelIndex.size(); ++i)
+    {
+        runCount += (i == 0U || labelIndex[i] != labelIndex[i - 1U]) ? 1U : 0U;
+    }
+
+    auto packed = pack(labelIndex, regionCount);
+    if (runCount * sizeof(LabelRun) < packed.byteSize())
+    {
+        return runLength(labelIndex);
+    }
+    return packed;
+}
+
+CompressedLabels CompressedLabels::load(const ContainerReader& container) noexcept
+{
+    CompressedLabels labels;
+    auto header = container.section<LabelCodecHeader>(SectionId::LabelCodec);
+    if (header.size() != 1U)
+    {
+        return labels;
+    }
+    labels.header = header[0];
+
+    bool valid = false;
+    if (labels.encoding() == LabelEncoding::Packed)
+    {
+        labels.word = container.section<uint64_t>(SectionId::PackedLabel);
+        valid = labels.header.bitWidth >= 1U && labels.header.bitWidth <= 32U
+            && labels.word.size() >= packedWordCount(labels.size(), labels.header.bitWidth);
+    }
+    else if (labels.encoding() == LabelEncoding::RunLength)
+    {
+        labels.run = container.section<LabelRun>(SectionId::LabelRun);
+        valid = !labels.run.empty() && labels.run[0].start == 0U && labels.run[labels.run.size() - 1U].start < labels.size();
+        for (std::size_t i = 1U; valid && i < labels.run.size(); ++i)
+        {
+            valid = labels.run[i - 1U].start < labels.run[i].start;
+        }
+    }
+
+    if (!valid)
+    {
+        logError() << "Invalid compressed label sections!";
+        return {};
+    }
+    return labels;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,163 @@
+// Author: cute-giggle@outlook.com
+
+#include "log.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <vector>
+#include <utility>
+
+namespace fsaverage
+{
+
+namespace
+{
+
+LogLevel levelFromEnvironment() noexcept
+{
+    const char* value = std::getenv("FSAVERAGE_LOG");
+    if (value == nullptr)
+    {
+        return LogLevel::Info;
+    }
+    const char* names[] = {"debug", "info", "warning", "error", "off"};
+    for (std::size_t i = 0U; i < sizeof(names) / sizeof(names[0]); ++i)
+    {
+        if (std::strcmp(value, names[i]) == 0)
+        {
+            return static_cast<LogLevel>(i);
+        }
+    }
+    return LogLevel::Info;
+}
+
+std::atomic<LogLevel>& currentLevel() noexcept
+{
+    static std::atomic<LogLevel> level{levelFromEnvironment()};
+    return level;
+}
+
+const char* prefix(LogLevel level) noexcept
+{
+    switch (level)
+    {
+    case LogLevel::Debug:   return "debug: ";
+    case LogLevel::Warning: return "warning: ";
+    case LogLevel::Error:   return "error: ";
+    default:                return "";
+    }
+}
+
+// Writer thread started by the first message. Producers only append to pending under the lock; the writer
+// swaps the whole batch out and writes it without holding the lock.
+class LogSink
+{
+public:
+    ~LogSink() noexcept
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wakeup.notify_one();
+        if (writer.joinable())
+        {
+            writer.join();
+        }
+    }
+
+    void push(LogLevel level, std::string message) noexcept
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!writer.joinable())
+            {
+                writer = std::thread([this]() { run(); });
+            }
+            pending.emplace_back(level, std::move(message));
+            ++queued;
+        }
+        wakeup.notify_one();
+    }
+
+    void flush() noexcept
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        drained.wait(lock, [this]() { return written == queued || !writer.joinable(); });
+    }
+
+private:
+    void run() noexcept
+    {
+        std::vector<std::pair<LogLevel, std::string>> batch;
+        std::string text;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true)
+        {
+            wakeup.wait(lock, [this]() { return stopping || !pending.empty(); });
+            if (pending.empty())
+            {
+                return;
+            }
+            batch.swap(pending);
+            lock.unlock();
+
+            text.clear();
+            for (auto& [level, message] : batch)
+            {
+                text.append(prefix(level)).append(message).push_back('\n');
+            }
+            std::fwrite(text.data(), 1U, text.size(), stderr);
+            std::fflush(stderr);
+
+            lock.lock();
+            written += batch.size();
+            batch.clear();
+            drained.notify_all();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::condition_variable drained;
+    std::vector<std::pair<LogLevel, std::string>> pending;
+    std::size_t queued{0U};
+    std::size_t written{0U};
+    bool stopping{false};
+    std::thread writer;
+};
+
+LogSink& sink() noexcept
+{
+    static LogSink instance;
+    return instance;
+}
+
+}
+
+void setLogLevel(LogLevel level) noexcept
+{
+    currentLevel().store(level, std::memory_order_relaxed);
+}
+
+LogLevel logLevel() noexcept
+{
+    return currentLevel().load(std::memory_order_relaxed);
+}
+
+void logMessage(LogLevel level, std::string message) noexcept
+{
+    sink().push(level, std::move(message));
+}
+
+void flushLog() noexcept
+{
+    sink().flush();
+}
+
+}
\ No newline at end of file
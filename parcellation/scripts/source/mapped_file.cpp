@@ -0,0 +1,136 @@
+// Author: cute-giggle@outlook.com
+
+#include "mapped_file.h"
+
+#include <utility>
+
+#include "log.h"
+#include "metrics.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fsaverage
+{
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator= (MappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        std::swap(address, other.address);
+        std::swap(length, other.length);
+#ifdef _WIN32
+        std::swap(mapping, other.mapping);
+#endif
+    }
+    return *this;
+}
+
+MappedFile::~MappedFile() noexcept
+{
+    release();
+}
+
+void MappedFile::release() noexcept
+{
+#ifdef _WIN32
+    if (address != nullptr)
+    {
+        UnmapViewOfFile(address);
+    }
+    if (mapping != nullptr)
+    {
+        CloseHandle(mapping);
+    }
+    mapping = nullptr;
+#else
+    if (address != nullptr)
+    {
+        munmap(const_cast<unsigned char*>(address), length);
+    }
+#endif
+    address = nullptr;
+    length = 0U;
+}
+
+MappedFile MappedFile::open(const std::filesystem::path& path) noexcept
+{
+    StageTimer timer(Stage::Open);
+    MappedFile file;
+#ifdef _WIN32
+    HANDLE handle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        logError() << "Open " << path << " failed!";
+        return {};
+    }
+
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(handle, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(handle);
+        logError() << "File " << path << " is empty!";
+        return {};
+    }
+
+    file.mapping = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(handle);
+    if (file.mapping == nullptr)
+    {
+        logError() << "Map " << path << " failed!";
+        return {};
+    }
+
+    file.address = static_cast<const unsigned char*>(MapViewOfFile(file.mapping, FILE_MAP_READ, 0, 0, 0));
+    if (file.address == nullptr)
+    {
+        logError() << "Map " << path << " failed!";
+        return {};
+    }
+    file.length = static_cast<std::size_t>(size.QuadPart);
+#else
+    int handle = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (handle < 0)
+    {
+        logError() << "Open " << path << " failed!";
+        return {};
+    }
+
+    struct stat status{};
+    if (fstat(handle, &status) != 0 || status.st_size <= 0)
+    {
+        close(handle);
+        logError() << "File " << path << " is empty!";
+        return {};
+    }
+
+    void* address = mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_SHARED, handle, 0);
+    close(handle);
+    if (address == MAP_FAILED)
+    {
+        logError() << "Map " << path << " failed!";
+        return {};
+    }
+    file.address = static_cast<const unsigned char*>(address);
+    file.length = static_cast<std::size_t>(status.st_size);
+#endif
+    timer.addBytes(file.length);
+    return file;
+}
+
+}
\ No newline at end of file
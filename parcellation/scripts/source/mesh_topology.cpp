@@ -0,0 +1,266 @@
+// Author: cute-giggle@outlook.com
+
+#include "mesh_topology.h"
+
+#include <algorithm>
+
+#include "parallel.h"
+#include "log.h"
+
+namespace fsaverage
+{
+
+namespace
+{
+constexpr std::size_t EDGE_GRAIN = 1U << 16;
+constexpr std::size_t VERTEX_GRAIN = 1U << 15;
+
+constexpr unsigned RADIX_BITS = 11U;
+constexpr std::size_t RADIX = std::size_t{1U} << RADIX_BITS;
+
+// Set on the sort values of the reversed copy of a half-edge.
+constexpr uint32_t REVERSED = 0x80000000U;
+
+unsigned bitWidth(std::size_t value) noexcept
+{
+    unsigned width = 1U;
+    while (width < 64U && (value >> width) != 0U)
+    {
+        ++width;
+    }
+    return width;
+}
+
+// Stable LSD radix sort of (key, value) pairs on the low keyBits bits of key. Every pass takes per-block
+// digit histograms in parallel, turns them into block write positions and scatters in parallel.
+void radixSort(std::vector<uint64_t>& key, std::vector<uint32_t>& value, unsigned keyBits) noexcept
+{
+    std::vector<uint64_t> keyBuffer(key.size());
+    std::vector<uint32_t> valueBuffer(value.size());
+    std::size_t blocks = blockCount(key.size(), EDGE_GRAIN);
+    std::vector<std::size_t> position(blocks * RADIX);
+    for (unsigned shift = 0U; shift < keyBits; shift += RADIX_BITS)
+    {
+        std::fill(position.begin(), position.end(), 0U);
+        parallelBlocks(key.size(), blocks, [&](std::size_t block, std::size_t begin, std::size_t end)
+        {
+            std::size_t* histogram = position.data() + block * RADIX;
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                ++histogram[(key[i] >> shift) & (RADIX - 1U)];
+            }
+        });
+
+        // digit-major, block-minor positions keep equal digits in input order
+        std::size_t total = 0U;
+        for (std::size_t digit = 0U; digit < RADIX; ++digit)
+        {
+            for (std::size_t block = 0U; block < blocks; ++block)
+            {
+                std::size_t count = position[block * RADIX + digit];
+                position[block * RADIX + digit] = total;
+                total += count;
+            }
+        }
+
+        parallelBlocks(key.size(), blocks, [&](std::size_t block, std::size_t begin, std::size_t end)
+        {
+            std::size_t* cursor = position.data() + block * RADIX;
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                std::size_t target = cursor[(key[i] >> shift) & (RADIX - 1U)]++;
+                keyBuffer[target] = key[i];
+                valueBuffer[target] = value[i];
+            }
+        });
+        key.swap(keyBuffer);
+        value.swap(valueBuffer);
+    }
+}
+
+}
+
+MeshTopology MeshTopology::build(Span<const int> face, std::size_t vertexCount) noexcept
+{
+    MeshTopology topology;
+    std::size_t halfEdgeCount = face.size() / 3U * 3U;
+    if (vertexCount == 0U || halfEdgeCount >= REVERSED)
+    {
+        logError() << "Mesh is empty or too large for 32-bit half-edge ids!";
+        return topology;
+    }
+    for (std::size_t h = 0U; h < halfEdgeCount; ++h)
+    {
+        if (static_cast<std::size_t>(face[h]) >= vertexCount)
+        {
+            logError() << "Face refers to vertex " << face[h] << " out of range!";
+            return topology;
+        }
+    }
+    topology.face = {face.data(), halfEdgeCount};
+
+    // every half-edge u -> v is sorted once as (u, v) and once reversed as (v, u), so after sorting the
+    // group of key (u, v) holds all directed edges between u and v: its half-edges and their twins
+    unsigned width = bitWidth(vertexCount - 1U);
+    uint64_t targetMask = (uint64_t{1} << width) - 1U;
+    std::vector<uint64_t> key(halfEdgeCount * 2U);
+    std::vector<uint32_t> value(halfEdgeCount * 2U);
+    parallelBlocks(halfEdgeCount, blockCount(halfEdgeCount, EDGE_GRAIN), [&](std::size_t, std::size_t begin, std::size_t end)
+    {
+        for (std::size_t h = begin; h < end; ++h)
+        {
+            uint64_t u = topology.origin(static_cast<uint32_t>(h));
+            uint64_t v = topology.target(static_cast<uint32_t>(h));
+            key[h * 2U] = (u << width) | v;
+            value[h * 2U] = static_cast<uint32_t>(h);
+            key[h * 2U + 1U] = (v << width) | u;
+            value[h * 2U + 1U] = static_cast<uint32_t>(h) | REVERSED;
+        }
+    });
+    radixSort(key, value, width * 2U);
+
+    // blocks start at the first group that begins inside them and finish the group they end in
+    std::size_t blocks = blockCount(key.size(), EDGE_GRAIN);
+    auto groupStart = [&key](std::size_t i, std::size_t end)
+    {
+        while (i > 0U && i < end && key[i] == key[i - 1U])
+        {
+            ++i;
+        }
+        return i;
+    };
+    auto isSelfEdge = [targetMask, width](uint64_t k) { return (k >> width) == (k & targetMask); };
+
+    std::vector<std::size_t> uniqueCount(blocks + 1U, 0U);
+    parallelBlocks(key.size(), blocks, [&](std::size_t block, std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = groupStart(begin, end); i < end; ++i)
+        {
+            if ((i == 0U || key[i] != key[i - 1U]) && !isSelfEdge(key[i]))
+            {
+                ++uniqueCount[block + 1U];
+            }
+        }
+    });
+    for (std::size_t block = 0U; block < blocks; ++block)
+    {
+        uniqueCount[block + 1U] += uniqueCount[block];
+    }
+
+    std::vector<uint64_t> uniqueKey(uniqueCount[blocks]);
+    topology.neighborStorage.resize(uniqueKey.size());
+    topology.twinStorage.assign(halfEdgeCount, INVALID);
+    parallelBlocks(key.size(), blocks, [&](std::size_t block, std::size_t begin, std::size_t end)
+    {
+        std::size_t cursor = uniqueCount[block];
+        std::size_t i = groupStart(begin, end);
+        while (i < end)
+        {
+            std::size_t groupEnd = i + 1U;
+            while (groupEnd < key.size() && key[groupEnd] == key[i])
+            {
+                ++groupEnd;
+            }
+            if (!isSelfEdge(key[i]))
+            {
+                uniqueKey[cursor] = key[i];
+                topology.neighborStorage[cursor++] = static_cast<uint32_t>(key[i] & targetMask);
+
+                // twins only on manifold edges: one half-edge each way
+                uint32_t forward = INVALID, backward = INVALID;
+                std::size_t forwardCount = 0U, backwardCount = 0U;
+                for (std::size_t j = i; j < groupEnd; ++j)
+                {
+                    if (value[j] & REVERSED)
+                    {
+                        backward = value[j] & ~REVERSED;
+                        ++backwardCount;
+                    }
+                    else
+                    {
+                        forward = value[j];
+                        ++forwardCount;
+                    }
+                }
+                if (forwardCount == 1U && backwardCount == 1U)
+                {
+                    topology.twinStorage[forward] = backward;
+                }
+            }
+            i = groupEnd;
+        }
+    });
+
+    topology.neighborOffsetStorage.resize(vertexCount + 1U);
+    parallelBlocks(vertexCount + 1U, blockCount(vertexCount + 1U, VERTEX_GRAIN), [&](std::size_t, std::size_t begin, std::size_t end)
+    {
+        for (std::size_t v = begin; v < end; ++v)
+        {
+            auto iter = std::lower_bound(uniqueKey.begin(), uniqueKey.end(), static_cast<uint64_t>(v) << width);
+            topology.neighborOffsetStorage[v] = static_cast<uint32_t>(iter - uniqueKey.begin());
+        }
+    });
+
+    // prefer a boundary half-edge, so walking twin(prev(h)) from it sweeps the whole fan of the vertex
+    topology.vertexHalfEdgeStorage.assign(vertexCount, INVALID);
+    for (uint32_t h = 0U; h < halfEdgeCount; ++h)
+    {
+        uint32_t& outgoing = topology.vertexHalfEdgeStorage[face[h]];
+        if (outgoing == INVALID || (topology.twinStorage[h] == INVALID && topology.twinStorage[outgoing] != INVALID))
+        {
+            outgoing = h;
+        }
+    }
+
+    topology.neighborOffset = {topology.neighborOffsetStorage.data(), topology.neighborOffsetStorage.size()};
+    topology.neighbor = {topology.neighborStorage.data(), topology.neighborStorage.size()};
+    topology.twin = {topology.twinStorage.data(), topology.twinStorage.size()};
+    topology.vertexHalfEdge = {topology.vertexHalfEdgeStorage.data(), topology.vertexHalfEdgeStorage.size()};
+    return topology;
+}
+
+MeshTopology MeshTopology::load(const SurfaceView& view) noexcept
+{
+    std::size_t vertexCount = view.point.size() / 3U;
+    std::size_t halfEdgeCount = view.face.size() / 3U * 3U;
+
+    MeshTopology topology;
+    topology.face = {view.face.data(), halfEdgeCount};
+    topology.neighborOffset = view.container.section<uint32_t>(SectionId::NeighborOffset);
+    topology.neighbor = view.container.section<uint32_t>(SectionId::Neighbor);
+    topology.twin = view.container.section<uint32_t>(SectionId::HalfEdgeTwin);
+    topology.vertexHalfEdge = view.container.section<uint32_t>(SectionId::VertexHalfEdge);
+
+    bool valid = topology.neighborOffset.size() == vertexCount + 1U && topology.neighborOffset[0] == 0U
+        && topology.neighborOffset[vertexCount] == topology.neighbor.size()
+        && topology.twin.size() == halfEdgeCount && topology.vertexHalfEdge.size() == vertexCount;
+    for (std::size_t v = 0U; valid && v < vertexCount; ++v)
+    {
+        valid = topology.neighborOffset[v] <= topology.neighborOffset[v + 1U]
+            && (topology.vertexHalfEdge[v] < halfEdgeCount || topology.vertexHalfEdge[v] == INVALID);
+    }
+    valid = valid && std::all_of(topology.neighbor.begin(), topology.neighbor.end(), [vertexCount](uint32_t v) { return v < vertexCount; })
+        && std::all_of(topology.twin.begin(), topology.twin.end(), [halfEdgeCount](uint32_t h) { return h < halfEdgeCount || h == INVALID; })
+        && std::all_of(topology.face.begin(), topology.face.end(),
+               [vertexCount](int v) { return v >= 0 && static_cast<std::size_t>(v) < vertexCount; });
+    if (valid)
+    {
+        return topology;
+    }
+
+    if (!topology.neighborOffset.empty())
+    {
+        logError() << "Invalid mesh topology sections, rebuild the topology!";
+    }
+    return build(view.face, vertexCount);
+}
+
+void MeshTopology::addSections(ContainerWriter& writer) const noexcept
+{
+    writer.addSection(SectionId::NeighborOffset, neighborOffset.data(), sizeof(uint32_t), neighborOffset.size());
+    writer.addSection(SectionId::Neighbor, neighbor.data(), sizeof(uint32_t), neighbor.size());
+    writer.addSection(SectionId::HalfEdgeTwin, twin.data(), sizeof(uint32_t), twin.size());
+    writer.addSection(SectionId::VertexHalfEdge, vertexHalfEdge.data(), sizeof(uint32_t), vertexHalfEdge.size());
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,107 @@
+// Author: cute-giggle@outlook.com
+
+#include "metrics.h"
+
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+
+#include "json_writer.h"
+#include "log.h"
+
+namespace fsaverage
+{
+
+namespace
+{
+
+struct StageCounter
+{
+    std::atomic<uint64_t> count{0U};
+    std::atomic<uint64_t> bytes{0U};
+    std::atomic<uint64_t> nanoseconds{0U};
+};
+
+StageCounter counters[STAGE_COUNT];
+
+// Writes the report at exit when FSAVERAGE_METRICS is set. The log sink is created on first use, after this
+// object, so it has already drained when the report goes to stderr.
+struct ExitReport
+{
+    ~ExitReport() noexcept
+    {
+        const char* path = std::getenv("FSAVERAGE_METRICS");
+        if (path == nullptr || *path == '\0')
+        {
+            return;
+        }
+        if (std::strcmp(path, "-") == 0)
+        {
+            writeMetricsReport(std::cerr);
+            return;
+        }
+        std::ofstream output(path);
+        if (!output.is_open())
+        {
+            std::cerr << "error: Open \"" << path << "\" failed!" << std::endl;
+            return;
+        }
+        writeMetricsReport(output);
+    }
+} exitReport;
+
+}
+
+const char* stageName(Stage stage) noexcept
+{
+    static const char* names[STAGE_COUNT] = {"open", "decode", "swap", "merge", "remap", "write"};
+    return names[static_cast<std::size_t>(stage)];
+}
+
+void recordStage(Stage stage, uint64_t bytes, std::chrono::steady_clock::duration duration) noexcept
+{
+    auto& counter = counters[static_cast<std::size_t>(stage)];
+    counter.count.fetch_add(1U, std::memory_order_relaxed);
+    counter.bytes.fetch_add(bytes, std::memory_order_relaxed);
+    counter.nanoseconds.fetch_add(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()),
+        std::memory_order_relaxed);
+}
+
+StageTotals stageTotals(Stage stage) noexcept
+{
+    auto& counter = counters[static_cast<std::size_t>(stage)];
+    return {counter.count.load(std::memory_order_relaxed), counter.bytes.load(std::memory_order_relaxed),
+        counter.nanoseconds.load(std::memory_order_relaxed)};
+}
+
+void writeMetricsReport(std::ostream& output) noexcept
+{
+    JsonWriter writer(output, 4);
+    writer.beginObject();
+    writer.key("stages");
+    writer.beginObject();
+    for (std::size_t i = 0U; i < STAGE_COUNT; ++i)
+    {
+        auto totals = stageTotals(static_cast<Stage>(i));
+        double seconds = static_cast<double>(totals.nanoseconds) * 1e-9;
+        writer.key(stageName(static_cast<Stage>(i)));
+        writer.beginObject();
+        writer.key("count");
+        writer.value(totals.count);
+        writer.key("bytes");
+        writer.value(totals.bytes);
+        writer.key("seconds");
+        writer.value(seconds);
+        writer.key("megabytesPerSecond");
+        writer.value(seconds > 0.0 ? static_cast<double>(totals.bytes) / (1024.0 * 1024.0) / seconds : 0.0);
+        writer.endObject();
+    }
+    writer.endObject();
+    writer.endObject();
+    writer.flush();
+    output << std::endl;
+}
+
+}
\ No newline at end of file
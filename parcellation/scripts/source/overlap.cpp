@@ -0,0 +1,169 @@
+// Author: cute-giggle@outlook.com
+
+#include "overlap.h"
+
+#include "parallel.h"
+#include "log.h"
+
+namespace fsaverage
+{
+
+namespace
+{
+constexpr std::size_t VERTEX_GRAIN = 1U << 15;
+
+// Share of a region above which one region "mostly" contains or belongs to the other.
+constexpr double MOST_THRESHOLD = 0.7;
+
+// Exact integer counts without weights, double sums with them.
+template<typename T>
+OverlapResult accumulateOverlap(const std::vector<OverlapInput>& inputs, Span<const float> weight) noexcept
+{
+    OverlapResult result;
+    std::size_t vertexCount = inputs[0].labelIndex.size();
+
+    // layout of one block histogram: region sizes of every annotation, then the dense matrix of every pair
+    std::vector<std::size_t> sizeOffset(inputs.size());
+    std::size_t histogramSize = 0U;
+    for (std::size_t i = 0U; i < inputs.size(); ++i)
+    {
+        sizeOffset[i] = histogramSize;
+        histogramSize += inputs[i].regionCount;
+    }
+    for (std::size_t i = 0U; i < inputs.size(); ++i)
+    {
+        for (std::size_t j = i + 1U; j < inputs.size(); ++j)
+        {
+            result.pairs.emplace_back(AnnotationPairOverlap{i, j, {}});
+        }
+    }
+    std::vector<std::size_t> pairOffset(result.pairs.size());
+    for (std::size_t p = 0U; p < result.pairs.size(); ++p)
+    {
+        pairOffset[p] = histogramSize;
+        histogramSize += inputs[result.pairs[p].first].regionCount * inputs[result.pairs[p].second].regionCount;
+    }
+
+    std::size_t blocks = blockCount(vertexCount, VERTEX_GRAIN);
+    std::vector<T> histogram(blocks * histogramSize, T{});
+    parallelBlocks(vertexCount, blocks, [&](std::size_t block, std::size_t begin, std::size_t end)
+    {
+        T* local = histogram.data() + block * histogramSize;
+        std::vector<uint32_t> label(inputs.size());
+        for (std::size_t v = begin; v < end; ++v)
+        {
+            bool valid = true;
+            for (std::size_t i = 0U; i < inputs.size(); ++i)
+            {
+                label[i] = inputs[i].labelIndex[v];
+                valid = valid && label[i] < inputs[i].regionCount;
+            }
+            if (!valid)
+            {
+                continue;
+            }
+            T amount = weight.empty() ? T{1} : static_cast<T>(weight[v]);
+            for (std::size_t i = 0U; i < inputs.size(); ++i)
+            {
+                local[sizeOffset[i] + label[i]] += amount;
+            }
+            for (std::size_t p = 0U; p < result.pairs.size(); ++p)
+            {
+                auto& pair = result.pairs[p];
+                local[pairOffset[p] + label[pair.first] * inputs[pair.second].regionCount + label[pair.second]] += amount;
+            }
+        }
+    });
+
+    // reduce the block histograms into the first one
+    parallelBlocks(histogramSize, blockCount(histogramSize, 1U << 12), [&](std::size_t, std::size_t begin, std::size_t end)
+    {
+        for (std::size_t block = 1U; block < blocks; ++block)
+        {
+            const T* local = histogram.data() + block * histogramSize;
+            for (std::size_t i = begin; i < end; ++i)
+            {
+                histogram[i] += local[i];
+            }
+        }
+    });
+
+    for (std::size_t i = 0U; i < inputs.size(); ++i)
+    {
+        result.regionSize.emplace_back(histogram.begin() + sizeOffset[i], histogram.begin() + sizeOffset[i] + inputs[i].regionCount);
+    }
+    for (std::size_t p = 0U; p < result.pairs.size(); ++p)
+    {
+        auto& pair = result.pairs[p];
+        std::size_t columns = inputs[pair.second].regionCount;
+        for (std::size_t r = 0U; r < inputs[pair.first].regionCount; ++r)
+        {
+            for (std::size_t c = 0U; c < columns; ++c)
+            {
+                T size = histogram[pairOffset[p] + r * columns + c];
+                if (size != T{})
+                {
+                    pair.entries.emplace_back(RegionPairOverlap{static_cast<uint32_t>(r), static_cast<uint32_t>(c), static_cast<double>(size)});
+                }
+            }
+        }
+    }
+    return result;
+}
+
+}
+
+OverlapResult computeOverlap(const std::vector<OverlapInput>& inputs, Span<const float> weight) noexcept
+{
+    if (inputs.empty())
+    {
+        return {};
+    }
+
+    std::size_t vertexCount = inputs[0].labelIndex.size();
+    for (auto& input : inputs)
+    {
+        if (input.labelIndex.size() != vertexCount)
+        {
+            logError() << "Annotations must be defined on the same surface!";
+            return {};
+        }
+    }
+    if (!weight.empty() && weight.size() != vertexCount)
+    {
+        logError() << "Vertex weights must be defined on the same surface as the annotations!";
+        return {};
+    }
+    return weight.empty() ? accumulateOverlap<uint32_t>(inputs, weight) : accumulateOverlap<double>(inputs, weight);
+}
+
+OverlapRelation classifyOverlap(double with1, double with2) noexcept
+{
+    if (with1 >= 1.0 && with2 >= 1.0)
+    {
+        return {"coincide", "coincide"};
+    }
+    if (with2 >= 1.0)
+    {
+        return {"contain", "belong to"};
+    }
+    if (with1 >= 1.0)
+    {
+        return {"belong to", "contain"};
+    }
+    if (with1 > MOST_THRESHOLD && with2 > MOST_THRESHOLD)
+    {
+        return {"most coincide", "most coincide"};
+    }
+    if (with2 > MOST_THRESHOLD)
+    {
+        return {"most contain", "most belong to"};
+    }
+    if (with1 > MOST_THRESHOLD)
+    {
+        return {"most belong to", "most contain"};
+    }
+    return {"intersect", "intersect"};
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,213 @@
+// Author: cute-giggle@outlook.com
+
+#include "overlay.h"
+
+#include <algorithm>
+
+#include "binary_reader.h"
+#include "log.h"
+#include "metrics.h"
+
+#include "parallel.h"
+
+namespace fsaverage
+{
+// Refer to [nibabel.freesurfer.io.py] and [nibabel.freesurfer.mghformat.py].
+// About freesurfer curv file formats, see [http://www.grahamwideman.com/gw/brain/fs/surfacefileformats.htm].
+
+namespace
+{
+constexpr int NEW_CURV_MAGIC = 16777215;
+
+// The MGH header has a fixed size whatever the value of its goodRASFlag.
+constexpr std::size_t MGH_HEADER_SIZE = 284U;
+constexpr int MGH_UCHAR = 0;
+constexpr int MGH_INT = 1;
+constexpr int MGH_FLOAT = 3;
+constexpr int MGH_SHORT = 4;
+
+constexpr std::size_t CHUNK_ELEMENTS = 16U * 1024U;
+
+// Convert chunk by chunk through a staging buffer that stays in cache.
+template<typename T, typename Convert>
+bool readConverted(const BinaryReader& reader, std::size_t offset, float* destination, std::size_t count, Convert convert) noexcept
+{
+    std::vector<T> buffer(std::min(CHUNK_ELEMENTS, count));
+    for (std::size_t done = 0U; done < count;)
+    {
+        std::size_t chunk = std::min(CHUNK_ELEMENTS, count - done);
+        if (!reader.readSequence(offset + done * sizeof(T), buffer.data(), chunk))
+        {
+            return false;
+        }
+        std::transform(buffer.begin(), buffer.begin() + chunk, destination + done, convert);
+        done += chunk;
+    }
+    return true;
+}
+
+}
+
+OverlayFile OverlayFile::open(const std::filesystem::path& path) noexcept
+{
+    if (path.extension() == ".mgz")
+    {
+        logError() << "Compressed overlay " << path << " is not supported, decompress it to .mgh first!";
+        return {};
+    }
+
+    OverlayFile overlay;
+    overlay.file = MappedFile::open(path);
+    if (overlay.file.empty())
+    {
+        return {};
+    }
+
+    BinaryReader reader(overlay.file);
+    BinaryCursor cursor(reader);
+    std::size_t valueSize = sizeof(float);
+    if (path.extension() == ".mgh")
+    {
+        int version = cursor.read4Bytes();
+        int dimension[4] = {cursor.read4Bytes(), cursor.read4Bytes(), cursor.read4Bytes(), cursor.read4Bytes()};
+        int type = cursor.read4Bytes();
+        if (!cursor.valid() || version != 1 || std::any_of(dimension, dimension + 4, [](int d) { return d <= 0; }))
+        {
+            logError() << "Invalid MGH header in " << path << "!";
+            return {};
+        }
+
+        // a surface overlay is a volume of width * height * depth vertices, usually width only
+        overlay.vertices = static_cast<std::size_t>(dimension[0]) * dimension[1] * dimension[2];
+        overlay.frames = static_cast<std::size_t>(dimension[3]);
+        overlay.offset = MGH_HEADER_SIZE;
+        switch (type)
+        {
+        case MGH_FLOAT:
+            overlay.encoding = Encoding::Float;
+            break;
+        case MGH_INT:
+            overlay.encoding = Encoding::Int;
+            break;
+        case MGH_SHORT:
+            overlay.encoding = Encoding::Short;
+            valueSize = sizeof(short);
+            break;
+        case MGH_UCHAR:
+            overlay.encoding = Encoding::UnsignedChar;
+            valueSize = 1U;
+            break;
+        default:
+            logError() << "Not support this MGH data type: " << type;
+            return {};
+        }
+    }
+    else if (cursor.read3Bytes() == NEW_CURV_MAGIC)
+    {
+        int vertexCount = cursor.read4Bytes();
+        // read face count
+        cursor.read4Bytes();
+        int valuesPerVertex = cursor.read4Bytes();
+        if (!cursor.valid() || vertexCount <= 0 || valuesPerVertex != 1)
+        {
+            logError() << "Invalid freesurfer curv header in " << path << "!";
+            return {};
+        }
+        overlay.vertices = static_cast<std::size_t>(vertexCount);
+        overlay.frames = 1U;
+        overlay.offset = cursor.offset();
+    }
+    else
+    {
+        // old curv format: the first 3 bytes were the vertex count
+        BinaryCursor old(reader);
+        int vertexCount = old.read3Bytes();
+        // read face count
+        old.read3Bytes();
+        if (!old.valid() || vertexCount <= 0)
+        {
+            logError() << "File " << path << " does not appear to be a freesurfer overlay!";
+            return {};
+        }
+        overlay.vertices = static_cast<std::size_t>(vertexCount);
+        overlay.frames = 1U;
+        overlay.offset = old.offset();
+        overlay.encoding = Encoding::OldCurv;
+        valueSize = sizeof(short);
+    }
+
+    if (overlay.vertices > reader.size() / valueSize / overlay.frames
+        || !reader.contains(overlay.offset, overlay.vertices * overlay.frames * valueSize))
+    {
+        logError() << "Freesurfer overlay " << path << " is truncated!";
+        return {};
+    }
+    return overlay;
+}
+
+bool OverlayFile::read(std::size_t frame, float* destination) const noexcept
+{
+    if (frame >= frames)
+    {
+        logError() << "Frame " << frame << " is out of range, the overlay has " << frames << " frames!";
+        return false;
+    }
+
+    StageTimer timer(Stage::Decode);
+    BinaryReader reader(file);
+    switch (encoding)
+    {
+    case Encoding::Float:
+        timer.addBytes(vertices * sizeof(float));
+        return reader.readSequence(offset + frame * vertices * sizeof(float), destination, vertices);
+    case Encoding::Int:
+        timer.addBytes(vertices * sizeof(int));
+        return readConverted<int>(reader, offset + frame * vertices * sizeof(int), destination, vertices,
+            [](int val) -> float { return static_cast<float>(val); });
+    case Encoding::Short:
+        timer.addBytes(vertices * sizeof(short));
+        return readConverted<short>(reader, offset + frame * vertices * sizeof(short), destination, vertices,
+            [](short val) -> float { return static_cast<float>(val); });
+    case Encoding::OldCurv:
+        timer.addBytes(vertices * sizeof(short));
+        return readConverted<short>(reader, offset, destination, vertices,
+            [](short val) -> float { return static_cast<float>(val) / 100.f; });
+    case Encoding::UnsignedChar:
+    {
+        timer.addBytes(vertices);
+        auto* bytes = reader.bytes(offset + frame * vertices, vertices);
+        std::transform(bytes, bytes + vertices, destination, [](unsigned char val) -> float { return static_cast<float>(val); });
+        return true;
+    }
+    }
+    return false;
+}
+
+Overlay Overlay::load(const std::filesystem::path& lpath, const std::filesystem::path& rpath, std::size_t frame) noexcept
+{
+    Overlay overlay;
+    if (!read(lpath, rpath, frame, overlay.value))
+    {
+        return {};
+    }
+    return overlay;
+}
+
+bool Overlay::read(const std::filesystem::path& lpath, const std::filesystem::path& rpath, std::size_t frame,
+    std::vector<float>& value) noexcept
+{
+    OverlayFile file[2] = {OverlayFile::open(lpath), OverlayFile::open(rpath)};
+    if (file[0].empty() || file[1].empty())
+    {
+        return false;
+    }
+
+    // decode left and right overlay into their halves on separate threads
+    value.resize(file[0].vertexCount() + file[1].vertexCount());
+    float* begin[2] = {value.data(), value.data() + file[0].vertexCount()};
+    bool valid[2] = {false, false};
+    parallelInvoke(2U, [&](std::size_t i) { valid[i] = file[i].read(frame, begin[i]); });
+    return valid[0] && valid[1];
+}
+
+}
\ No newline at end of file
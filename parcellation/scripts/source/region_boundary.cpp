@@ -0,0 +1,143 @@
+// Author: cute-giggle@outlook.com
+
+#include "region_boundary.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "parallel.h"
+#include "log.h"
+
+namespace fsaverage
+{
+
+namespace
+{
+constexpr std::size_t FACE_GRAIN = 1U << 15;
+
+struct BorderSegment
+{
+    uint64_t key;       // first << 32 | second, first < second
+    double length;
+};
+
+struct BlockBoundary
+{
+    std::vector<BorderSegment> segment;
+    std::vector<uint32_t> vertex;
+};
+
+struct Point3
+{
+    double x;
+    double y;
+    double z;
+};
+
+Point3 pointOf(Span<const float> point, int vertex) noexcept
+{
+    const float* p = point.data() + static_cast<std::size_t>(vertex) * 3U;
+    return {p[0], p[1], p[2]};
+}
+
+Point3 middle(const Point3& a, const Point3& b) noexcept
+{
+    return {(a.x + b.x) * 0.5, (a.y + b.y) * 0.5, (a.z + b.z) * 0.5};
+}
+
+double distance(const Point3& a, const Point3& b) noexcept
+{
+    return std::sqrt((a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y) + (a.z - b.z) * (a.z - b.z));
+}
+
+uint64_t borderKey(uint32_t a, uint32_t b) noexcept
+{
+    return a < b ? (static_cast<uint64_t>(a) << 32U) | b : (static_cast<uint64_t>(b) << 32U) | a;
+}
+
+void scanFace(Span<const float> point, const int* f, Span<const uint32_t> labelIndex, BlockBoundary& block) noexcept
+{
+    uint32_t label[3] = {labelIndex[f[0]], labelIndex[f[1]], labelIndex[f[2]]};
+    if (label[0] == label[1] && label[1] == label[2])
+    {
+        return;
+    }
+    block.vertex.insert(block.vertex.end(), {static_cast<uint32_t>(f[0]), static_cast<uint32_t>(f[1]), static_cast<uint32_t>(f[2])});
+
+    Point3 corner[3] = {pointOf(point, f[0]), pointOf(point, f[1]), pointOf(point, f[2])};
+    if (label[0] != label[1] && label[1] != label[2] && label[0] != label[2])
+    {
+        Point3 centroid{(corner[0].x + corner[1].x + corner[2].x) / 3.0, (corner[0].y + corner[1].y + corner[2].y) / 3.0,
+            (corner[0].z + corner[1].z + corner[2].z) / 3.0};
+        for (int k = 0; k < 3; ++k)
+        {
+            int n = (k + 1) % 3;
+            block.segment.emplace_back(BorderSegment{borderKey(label[k], label[n]), distance(middle(corner[k], corner[n]), centroid)});
+        }
+        return;
+    }
+
+    // the odd corner out is the one whose label differs from both others
+    int odd = label[0] == label[1] ? 2 : (label[0] == label[2] ? 1 : 0);
+    int a = (odd + 1) % 3;
+    int b = (odd + 2) % 3;
+    block.segment.emplace_back(BorderSegment{borderKey(label[odd], label[a]),
+        distance(middle(corner[odd], corner[a]), middle(corner[odd], corner[b]))});
+}
+
+}
+
+BoundaryResult computeBoundary(Span<const float> point, Span<const int> face, Span<const uint32_t> labelIndex) noexcept
+{
+    std::size_t vertexCount = point.size() / 3U;
+    if (labelIndex.size() != vertexCount)
+    {
+        logError() << "Annotation must be defined on the surface!";
+        return {};
+    }
+
+    std::size_t faceCount = face.size() / 3U;
+    std::size_t blocks = blockCount(faceCount, FACE_GRAIN);
+    std::vector<BlockBoundary> local(blocks);
+    parallelBlocks(faceCount, blocks, [&](std::size_t block, std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            const int* f = face.data() + i * 3U;
+            if (static_cast<std::size_t>(f[0]) < vertexCount && static_cast<std::size_t>(f[1]) < vertexCount
+                && static_cast<std::size_t>(f[2]) < vertexCount)
+            {
+                scanFace(point, f, labelIndex, local[block]);
+            }
+        }
+        std::sort(local[block].segment.begin(), local[block].segment.end(),
+            [](const BorderSegment& a, const BorderSegment& b) { return a.key < b.key; });
+        std::sort(local[block].vertex.begin(), local[block].vertex.end());
+        local[block].vertex.erase(std::unique(local[block].vertex.begin(), local[block].vertex.end()), local[block].vertex.end());
+    });
+
+    // the border faces are a thin fraction of the mesh, so merging the sorted block lists serially is cheap
+    BoundaryResult result;
+    std::vector<BorderSegment> segment;
+    for (auto& block : local)
+    {
+        auto middleSegment = segment.insert(segment.end(), block.segment.begin(), block.segment.end());
+        std::inplace_merge(segment.begin(), middleSegment, segment.end(),
+            [](const BorderSegment& a, const BorderSegment& b) { return a.key < b.key; });
+        auto middleVertex = result.boundaryVertex.insert(result.boundaryVertex.end(), block.vertex.begin(), block.vertex.end());
+        std::inplace_merge(result.boundaryVertex.begin(), middleVertex, result.boundaryVertex.end());
+    }
+    result.boundaryVertex.erase(std::unique(result.boundaryVertex.begin(), result.boundaryVertex.end()), result.boundaryVertex.end());
+
+    for (std::size_t i = 0U; i < segment.size(); ++i)
+    {
+        if (i == 0U || segment[i].key != segment[i - 1U].key)
+        {
+            result.borders.emplace_back(RegionBorder{static_cast<uint32_t>(segment[i].key >> 32U), static_cast<uint32_t>(segment[i].key), 0.0});
+        }
+        result.borders.back().length += segment[i].length;
+    }
+    return result;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,112 @@
+// Author: cute-giggle@outlook.com
+
+#include "region_index.h"
+
+#include <algorithm>
+
+#include "parallel.h"
+#include "log.h"
+
+namespace fsaverage
+{
+
+namespace
+{
+constexpr std::size_t VERTEX_GRAIN = 1U << 16;
+}
+
+RegionIndex RegionIndex::build(Span<const uint32_t> labelIndex, std::size_t regionCount) noexcept
+{
+    RegionIndex index;
+    if (regionCount == 0U)
+    {
+        return index;
+    }
+    index.vertexCount = labelIndex.size();
+
+    // histogram of every block, then the write position of (region, block) is the count of all
+    // smaller regions plus the count of this region in earlier blocks, which keeps vertices ascending
+    std::size_t blocks = blockCount(labelIndex.size(), VERTEX_GRAIN);
+    std::vector<uint32_t> position(blocks * regionCount, 0U);
+    parallelBlocks(labelIndex.size(), blocks, [&](std::size_t block, std::size_t begin, std::size_t end)
+    {
+        uint32_t* histogram = position.data() + block * regionCount;
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            if (labelIndex[i] < regionCount)
+            {
+                ++histogram[labelIndex[i]];
+            }
+        }
+    });
+
+    index.offsetStorage.resize(regionCount + 1U);
+    uint32_t total = 0U;
+    for (std::size_t region = 0U; region < regionCount; ++region)
+    {
+        index.offsetStorage[region] = total;
+        for (std::size_t block = 0U; block < blocks; ++block)
+        {
+            uint32_t count = position[block * regionCount + region];
+            position[block * regionCount + region] = total;
+            total += count;
+        }
+    }
+    index.offsetStorage[regionCount] = total;
+
+    index.vertexStorage.resize(total);
+    parallelBlocks(labelIndex.size(), blocks, [&](std::size_t block, std::size_t begin, std::size_t end)
+    {
+        uint32_t* cursor = position.data() + block * regionCount;
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            if (labelIndex[i] < regionCount)
+            {
+                index.vertexStorage[cursor[labelIndex[i]]++] = static_cast<uint32_t>(i);
+            }
+        }
+    });
+
+    index.offset = {index.offsetStorage.data(), index.offsetStorage.size()};
+    index.vertex = {index.vertexStorage.data(), index.vertexStorage.size()};
+    return index;
+}
+
+RegionIndex RegionIndex::build(const Annotation& annotation) noexcept
+{
+    return build({annotation.labelIndex.data(), annotation.labelIndex.size()}, annotation.colorTable.size());
+}
+
+RegionIndex RegionIndex::load(const AnnotationView& view) noexcept
+{
+    RegionIndex index;
+    index.offset = view.container.section<uint32_t>(SectionId::RegionOffset);
+    index.vertex = view.container.section<uint32_t>(SectionId::RegionVertex);
+    index.vertexCount = view.labelIndex.empty() ? view.labels.size() : view.labelIndex.size();
+
+    bool valid = index.offset.size() == view.colorTable.size() + 1U && index.offset[0] == 0U
+        && index.offset[index.offset.size() - 1U] == index.vertex.size();
+    for (std::size_t i = 1U; valid && i < index.offset.size(); ++i)
+    {
+        valid = index.offset[i - 1U] <= index.offset[i];
+    }
+    std::size_t vertexCount = index.vertexCount;
+    valid = valid && std::all_of(index.vertex.begin(), index.vertex.end(), [vertexCount](uint32_t v) { return v < vertexCount; });
+    if (valid)
+    {
+        return index;
+    }
+
+    if (!index.offset.empty())
+    {
+        logError() << "Invalid region index sections, rebuild the index!";
+    }
+    if (view.labelIndex.empty() && !view.labels.empty())
+    {
+        auto labelIndex = view.labels.decode();
+        return build({labelIndex.data(), labelIndex.size()}, view.colorTable.size());
+    }
+    return build(view.labelIndex, view.colorTable.size());
+}
+
+}
\ No newline at end of file
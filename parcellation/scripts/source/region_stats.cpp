@@ -0,0 +1,267 @@
+// Author: cute-giggle@outlook.com
+
+#include "region_stats.h"
+
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <cmath>
+
+#include "BigEndianHelper.h"
+#include "parallel.h"
+#include "log.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define FSAVERAGE_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(FSAVERAGE_X86) && (defined(__GNUC__) || defined(__clang__))
+#define FSAVERAGE_TARGET(isa) __attribute__((target(isa)))
+#else
+#define FSAVERAGE_TARGET(isa)
+#endif
+
+namespace fsaverage
+{
+
+namespace
+{
+constexpr std::size_t VERTEX_GRAIN = 1U << 15;
+
+// Sums in double, so the deviation of large regions keeps its precision.
+struct Moments
+{
+    double weight{};
+    double sum{};
+    double square{};
+    float min{std::numeric_limits<float>::infinity()};
+    float max{-std::numeric_limits<float>::infinity()};
+};
+
+// Reduce the values of vertex[0, count), also gathering them (and their weights) to contiguous arrays when
+// percentiles need them. weight, gatheredValue and gatheredWeight may be null.
+using ReduceKernel = void (*)(const uint32_t* vertex, std::size_t count, const float* value, const float* weight,
+    float* gatheredValue, float* gatheredWeight, Moments& moments) noexcept;
+
+void reduceScalar(const uint32_t* vertex, std::size_t count, const float* value, const float* weight,
+    float* gatheredValue, float* gatheredWeight, Moments& moments) noexcept
+{
+    for (std::size_t i = 0U; i < count; ++i)
+    {
+        float x = value[vertex[i]];
+        float w = weight == nullptr ? 1.f : weight[vertex[i]];
+        moments.min = std::min(moments.min, x);
+        moments.max = std::max(moments.max, x);
+        moments.weight += w;
+        moments.sum += static_cast<double>(w) * x;
+        moments.square += static_cast<double>(w) * x * x;
+        if (gatheredValue != nullptr)
+        {
+            gatheredValue[i] = x;
+        }
+        if (gatheredWeight != nullptr)
+        {
+            gatheredWeight[i] = w;
+        }
+    }
+}
+
+#ifdef FSAVERAGE_X86
+
+FSAVERAGE_TARGET("avx2")
+double horizontalSum(__m256d value) noexcept
+{
+    __m128d pair = _mm_add_pd(_mm256_castpd256_pd128(value), _mm256_extractf128_pd(value, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(pair, _mm_unpackhi_pd(pair, pair)));
+}
+
+FSAVERAGE_TARGET("avx2")
+void reduceAVX2(const uint32_t* vertex, std::size_t count, const float* value, const float* weight,
+    float* gatheredValue, float* gatheredWeight, Moments& moments) noexcept
+{
+    // 8 vertices per step: gather their values and weights, keep min and max in float lanes and widen to
+    // two double vectors for the sums
+    const __m256 one = _mm256_set1_ps(1.f);
+    __m256 low = _mm256_set1_ps(moments.min);
+    __m256 high = _mm256_set1_ps(moments.max);
+    __m256d total[2] = {_mm256_setzero_pd(), _mm256_setzero_pd()};
+    __m256d sum[2] = {_mm256_setzero_pd(), _mm256_setzero_pd()};
+    __m256d square[2] = {_mm256_setzero_pd(), _mm256_setzero_pd()};
+
+    std::size_t i = 0U;
+    for (; i + 8U <= count; i += 8U)
+    {
+        __m256i id = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(vertex + i));
+        __m256 x = _mm256_i32gather_ps(value, id, 4);
+        __m256 w = weight == nullptr ? one : _mm256_i32gather_ps(weight, id, 4);
+        low = _mm256_min_ps(low, x);
+        high = _mm256_max_ps(high, x);
+        if (gatheredValue != nullptr)
+        {
+            _mm256_storeu_ps(gatheredValue + i, x);
+        }
+        if (gatheredWeight != nullptr)
+        {
+            _mm256_storeu_ps(gatheredWeight + i, w);
+        }
+
+        __m256d xd[2] = {_mm256_cvtps_pd(_mm256_castps256_ps128(x)), _mm256_cvtps_pd(_mm256_extractf128_ps(x, 1))};
+        __m256d wd[2] = {_mm256_cvtps_pd(_mm256_castps256_ps128(w)), _mm256_cvtps_pd(_mm256_extractf128_ps(w, 1))};
+        for (std::size_t h = 0U; h < 2U; ++h)
+        {
+            __m256d wx = _mm256_mul_pd(wd[h], xd[h]);
+            total[h] = _mm256_add_pd(total[h], wd[h]);
+            sum[h] = _mm256_add_pd(sum[h], wx);
+            square[h] = _mm256_add_pd(square[h], _mm256_mul_pd(wx, xd[h]));
+        }
+    }
+
+    float lane[8];
+    _mm256_storeu_ps(lane, low);
+    moments.min = *std::min_element(lane, lane + 8);
+    _mm256_storeu_ps(lane, high);
+    moments.max = *std::max_element(lane, lane + 8);
+    moments.weight += horizontalSum(_mm256_add_pd(total[0], total[1]));
+    moments.sum += horizontalSum(_mm256_add_pd(sum[0], sum[1]));
+    moments.square += horizontalSum(_mm256_add_pd(square[0], square[1]));
+    reduceScalar(vertex + i, count - i, value, weight, gatheredValue == nullptr ? nullptr : gatheredValue + i,
+        gatheredWeight == nullptr ? nullptr : gatheredWeight + i, moments);
+}
+
+#endif
+
+ReduceKernel reduceKernel() noexcept
+{
+#ifdef FSAVERAGE_X86
+    static const ReduceKernel selected = BigEndianHelper::simdLevel() == BigEndianHelper::SimdLevel::AVX2 ? reduceAVX2 : reduceScalar;
+#else
+    static const ReduceKernel selected = reduceScalar;
+#endif
+    return selected;
+}
+
+// Percentiles of value[0, count) in ascending order of order, linear between the closest ranks. Every
+// selection only partitions the range above the previous one, so k percentiles cost about k linear passes.
+void unweightedPercentiles(float* value, std::size_t count, const std::vector<double>& percentiles,
+    const std::vector<std::size_t>& order, float* result) noexcept
+{
+    float* lower = value;
+    for (std::size_t p : order)
+    {
+        double rank = std::clamp(percentiles[p], 0.0, 100.0) / 100.0 * static_cast<double>(count - 1U);
+        std::size_t k = static_cast<std::size_t>(rank);
+        float* nth = value + k;
+        std::nth_element(lower, nth, value + count);
+        lower = nth;
+        float next = k + 1U < count && rank > static_cast<double>(k) ? *std::min_element(nth + 1, value + count) : *nth;
+        result[p] = *nth + static_cast<float>(rank - static_cast<double>(k)) * (next - *nth);
+    }
+}
+
+// Weighted percentiles: the first value in ascending order whose cumulative weight reaches the share.
+void weightedPercentiles(const float* value, const float* weight, std::size_t count, const std::vector<double>& percentiles,
+    const std::vector<std::size_t>& order, std::vector<uint32_t>& rank, float* result) noexcept
+{
+    rank.resize(count);
+    std::iota(rank.begin(), rank.end(), 0U);
+    std::sort(rank.begin(), rank.end(), [value](uint32_t a, uint32_t b) { return value[a] < value[b]; });
+
+    double total = std::accumulate(weight, weight + count, 0.0);
+    double cumulative = 0.0;
+    std::size_t i = 0U;
+    for (std::size_t p : order)
+    {
+        double target = std::clamp(percentiles[p], 0.0, 100.0) / 100.0 * total;
+        while (i + 1U < count && cumulative + weight[rank[i]] < target)
+        {
+            cumulative += weight[rank[i++]];
+        }
+        result[p] = value[rank[i]];
+    }
+}
+
+}
+
+std::vector<RegionStatistics> computeRegionStatistics(const RegionIndex& index, Span<const float> value,
+    Span<const float> weight, const std::vector<double>& percentiles, std::size_t threadCount) noexcept
+{
+    if (index.empty())
+    {
+        return {};
+    }
+    if (!weight.empty() && weight.size() != value.size())
+    {
+        logError() << "Vertex weights must be defined on the same surface as the overlay!";
+        return {};
+    }
+    if (value.size() < index.vertexCount)
+    {
+        logError() << "Overlay must be defined on the same surface as the annotation!";
+        return {};
+    }
+
+    std::vector<std::size_t> order(percentiles.size());
+    std::iota(order.begin(), order.end(), std::size_t{0U});
+    std::sort(order.begin(), order.end(), [&percentiles](std::size_t a, std::size_t b) { return percentiles[a] < percentiles[b]; });
+
+    // every block takes the regions that start inside its share of the vertex list, the last one also the
+    // empty regions at the end
+    std::vector<RegionStatistics> result(index.regionCount());
+    std::size_t vertexCount = index.vertex.size();
+    std::size_t blocks = std::min(blockCount(vertexCount, VERTEX_GRAIN), std::max<std::size_t>(threadCount, 1U));
+    const uint32_t* offsetEnd = index.offset.end() - 1;
+    parallelBlocks(vertexCount, blocks, [&](std::size_t, std::size_t begin, std::size_t end)
+    {
+        auto first = static_cast<std::size_t>(std::lower_bound(index.offset.begin(), offsetEnd, begin) - index.offset.begin());
+        auto last = end == vertexCount ? index.regionCount()
+                  : static_cast<std::size_t>(std::lower_bound(index.offset.begin(), offsetEnd, end) - index.offset.begin());
+
+        std::vector<float> gatheredValue;
+        std::vector<float> gatheredWeight;
+        std::vector<uint32_t> rank;
+        for (std::size_t region = first; region < last; ++region)
+        {
+            auto vertex = index.vertices(static_cast<uint32_t>(region));
+            auto& statistics = result[region];
+            statistics.percentile.assign(percentiles.size(), 0.f);
+            if (vertex.empty())
+            {
+                continue;
+            }
+
+            bool gather = !percentiles.empty();
+            gatheredValue.resize(gather ? vertex.size() : 0U);
+            gatheredWeight.resize(gather && !weight.empty() ? vertex.size() : 0U);
+            Moments moments;
+            reduceKernel()(vertex.data(), vertex.size(), value.data(), weight.empty() ? nullptr : weight.data(),
+                gatheredValue.empty() ? nullptr : gatheredValue.data(), gatheredWeight.empty() ? nullptr : gatheredWeight.data(), moments);
+
+            statistics.count = static_cast<uint32_t>(vertex.size());
+            statistics.weight = moments.weight;
+            statistics.min = moments.min;
+            statistics.max = moments.max;
+            if (moments.weight > 0.0)
+            {
+                statistics.mean = moments.sum / moments.weight;
+                statistics.deviation = std::sqrt(std::max(moments.square / moments.weight - statistics.mean * statistics.mean, 0.0));
+            }
+            if (!gather)
+            {
+                continue;
+            }
+            if (weight.empty())
+            {
+                unweightedPercentiles(gatheredValue.data(), vertex.size(), percentiles, order, statistics.percentile.data());
+            }
+            else
+            {
+                weightedPercentiles(gatheredValue.data(), gatheredWeight.data(), vertex.size(), percentiles, order, rank,
+                    statistics.percentile.data());
+            }
+        }
+    });
+    return result;
+}
+
+}
\ No newline at end of file
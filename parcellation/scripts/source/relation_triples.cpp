@@ -0,0 +1,45 @@
+// Author: cute-giggle@outlook.com
+
+#include "relation_triples.h"
+
+#include "log.h"
+
+namespace fsaverage
+{
+
+bool RelationTripleWriter::open(const std::filesystem::path& path) noexcept
+{
+    output.open(path);
+    if (!output.is_open())
+    {
+        logError() << "Open " << path << " failed!";
+        return false;
+    }
+    this->path = path;
+    writer = std::make_unique<JsonWriter>(output);
+    writer->beginArray();
+    return true;
+}
+
+void RelationTripleWriter::write(std::string_view subject, std::string_view relation, std::string_view object) noexcept
+{
+    writer->beginArray();
+    writer->value(subject);
+    writer->value(relation);
+    writer->value(object);
+    writer->endArray();
+}
+
+void RelationTripleWriter::close() noexcept
+{
+    if (!writer)
+    {
+        return;
+    }
+    writer->endArray();
+    writer.reset();
+    output.close();
+    logInfo() << "Save relation triples to " << std::filesystem::absolute(path);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,216 @@
+// Author: cute-giggle@outlook.com
+
+#include "resample.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include "spatial_index.h"
+#include "parallel.h"
+#include "log.h"
+
+namespace fsaverage
+{
+
+namespace
+{
+constexpr uint32_t INVALID = 0xFFFFFFFFU;
+constexpr std::size_t VERTEX_GRAIN = 1U << 14;
+
+// A connected part of a surface over the vertices [begin, end), with its faces rebased to begin.
+struct SurfacePart
+{
+    std::size_t begin{};
+    std::size_t end{};
+    std::vector<int> face;
+};
+
+uint32_t findRoot(std::vector<uint32_t>& parent, uint32_t v) noexcept
+{
+    while (parent[v] != v)
+    {
+        parent[v] = parent[parent[v]];
+        v = parent[v];
+    }
+    return v;
+}
+
+SurfacePart wholeSurface(std::size_t vertexCount, Span<const int> face) noexcept
+{
+    return SurfacePart{0U, vertexCount, std::vector<int>(face.begin(), face.begin() + face.size() / 3U * 3U)};
+}
+
+// Connected parts in vertex order, each owning the vertices up to the first vertex of the next one, so
+// vertices without faces go to the part before them. Parts that interleave in vertex order leave the
+// surface whole.
+std::vector<SurfacePart> splitParts(std::size_t vertexCount, Span<const int> face) noexcept
+{
+    std::size_t faceCount = face.size() / 3U;
+    std::vector<uint32_t> parent(vertexCount);
+    std::iota(parent.begin(), parent.end(), 0U);
+    for (std::size_t f = 0U; f < faceCount; ++f)
+    {
+        for (std::size_t k = 1U; k < 3U; ++k)
+        {
+            uint32_t a = findRoot(parent, static_cast<uint32_t>(face[f * 3U]));
+            uint32_t b = findRoot(parent, static_cast<uint32_t>(face[f * 3U + k]));
+            // the root of a part is its first vertex
+            parent[std::max(a, b)] = std::min(a, b);
+        }
+    }
+
+    std::vector<uint32_t> partOf(vertexCount, INVALID);
+    std::vector<SurfacePart> parts;
+    for (std::size_t f = 0U; f < faceCount; ++f)
+    {
+        uint32_t root = findRoot(parent, static_cast<uint32_t>(face[f * 3U]));
+        if (partOf[root] == INVALID)
+        {
+            partOf[root] = 0U;
+            parts.emplace_back(SurfacePart{root, vertexCount, {}});
+        }
+    }
+    if (parts.size() < 2U)
+    {
+        return parts.empty() ? parts : std::vector<SurfacePart>{wholeSurface(vertexCount, face)};
+    }
+
+    std::sort(parts.begin(), parts.end(), [](const SurfacePart& a, const SurfacePart& b) { return a.begin < b.begin; });
+    for (std::size_t i = 0U; i < parts.size(); ++i)
+    {
+        partOf[parts[i].begin] = static_cast<uint32_t>(i);
+        if (i + 1U < parts.size())
+        {
+            parts[i].end = parts[i + 1U].begin;
+        }
+    }
+    parts.front().begin = 0U;
+    for (std::size_t f = 0U; f < faceCount; ++f)
+    {
+        auto& part = parts[partOf[findRoot(parent, static_cast<uint32_t>(face[f * 3U]))]];
+        for (std::size_t k = 0U; k < 3U; ++k)
+        {
+            auto v = static_cast<std::size_t>(face[f * 3U + k]);
+            if (v < part.begin || v >= part.end)
+            {
+                return {wholeSurface(vertexCount, face)};
+            }
+            part.face.emplace_back(static_cast<int>(v - part.begin));
+        }
+    }
+    return parts;
+}
+
+// The corners of the face vote with their barycentric weights, corners of one label pooling them; ties go
+// to the label of the heavier corner.
+uint32_t vote(const ClosestPoint& closest, const int* face, const uint32_t* label) noexcept
+{
+    const int* corner = face + closest.face * std::size_t{3U};
+    std::size_t order[3] = {0U, 1U, 2U};
+    std::sort(order, order + 3, [&closest](std::size_t a, std::size_t b) { return closest.weight[a] > closest.weight[b]; });
+
+    uint32_t best = INVALID;
+    float bestWeight = -1.f;
+    for (std::size_t i : order)
+    {
+        uint32_t candidate = label[corner[i]];
+        float weight = 0.f;
+        for (std::size_t j = 0U; j < 3U; ++j)
+        {
+            weight += label[corner[j]] == candidate ? closest.weight[j] : 0.f;
+        }
+        if (weight > bestWeight)
+        {
+            best = candidate;
+            bestWeight = weight;
+        }
+    }
+    return best;
+}
+
+bool validFaces(std::size_t vertexCount, Span<const int> face) noexcept
+{
+    return std::all_of(face.begin(), face.end(), [vertexCount](int v) { return v >= 0 && static_cast<std::size_t>(v) < vertexCount; });
+}
+
+}
+
+std::vector<uint32_t> resampleLabels(Span<const float> sourcePoint, Span<const int> sourceFace, Span<const uint32_t> sourceLabel,
+    Span<const float> targetPoint, Span<const int> targetFace) noexcept
+{
+    std::size_t sourceCount = sourcePoint.size() / 3U;
+    std::size_t targetCount = targetPoint.size() / 3U;
+    if (sourceLabel.size() != sourceCount)
+    {
+        logError() << "Annotation must be defined on the source surface!";
+        return {};
+    }
+    if (sourceFace.size() < 3U || !validFaces(sourceCount, sourceFace) || !validFaces(targetCount, targetFace))
+    {
+        logError() << "Invalid surface faces!";
+        return {};
+    }
+
+    auto sourcePart = splitParts(sourceCount, sourceFace);
+    auto targetPart = splitParts(targetCount, targetFace);
+    if (sourcePart.size() != targetPart.size())
+    {
+        logWarning() << "Source surface has " << sourcePart.size() << " parts and target surface has " << targetPart.size()
+                     << ", search the whole source surface!";
+        sourcePart = {wholeSurface(sourceCount, sourceFace)};
+        targetPart = {wholeSurface(targetCount, targetFace)};
+    }
+
+    // the hierarchies of the hemispheres build on separate threads, the queries split into blocks themselves
+    std::vector<SpatialIndex> index(sourcePart.size());
+    parallelInvoke(sourcePart.size(), [&](std::size_t i)
+    {
+        auto& source = sourcePart[i];
+        index[i] = SpatialIndex::build({sourcePoint.data() + source.begin * 3U, (source.end - source.begin) * 3U},
+            {source.face.data(), source.face.size()});
+    });
+    if (std::any_of(index.begin(), index.end(), [](const SpatialIndex& part) { return part.empty(); }))
+    {
+        return {};
+    }
+
+    std::vector<uint32_t> label(targetCount, INVALID);
+    std::vector<ClosestPoint> closest;
+    for (std::size_t i = 0U; i < sourcePart.size(); ++i)
+    {
+        auto& source = sourcePart[i];
+        auto& target = targetPart[i];
+        std::size_t count = target.end - target.begin;
+        closest.resize(count);
+        index[i].closestPoint(targetPoint.data() + target.begin * 3U, count, closest.data());
+        parallelBlocks(count, blockCount(count, VERTEX_GRAIN), [&](std::size_t, std::size_t begin, std::size_t end)
+        {
+            for (std::size_t q = begin; q < end; ++q)
+            {
+                label[target.begin + q] = vote(closest[q], source.face.data(), sourceLabel.data() + source.begin);
+            }
+        });
+    }
+    return label;
+}
+
+Annotation resampleAnnotation(const Surface& source, const Annotation& annotation, const Surface& target) noexcept
+{
+    Annotation result;
+    result.labelIndex = resampleLabels({source.point.data(), source.point.size()}, {source.face.data(), source.face.size()},
+        {annotation.labelIndex.data(), annotation.labelIndex.size()}, {target.point.data(), target.point.size()},
+        {target.face.data(), target.face.size()});
+    if (result.labelIndex.empty())
+    {
+        return {};
+    }
+    result.colorTable = annotation.colorTable;
+    return result;
+}
+
+std::string resampledAnnotationFileName(const std::filesystem::path& path) noexcept
+{
+    return path.stem().string() + ".resampled.data";
+}
+
+}
\ No newline at end of file
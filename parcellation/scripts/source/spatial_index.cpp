@@ -0,0 +1,399 @@
+// Author: cute-giggle@outlook.com
+
+#include "spatial_index.h"
+
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+#include "parallel.h"
+#include "log.h"
+
+namespace fsaverage
+{
+
+namespace
+{
+constexpr std::size_t QUERY_GRAIN = 1U << 12;
+constexpr std::size_t VERTEX_LEAF = 8U;
+constexpr std::size_t FACE_LEAF = 4U;
+
+// Deep enough for any tree built from 32-bit ids by median splits; trees read from a file are checked
+// against it, as a walk holds at most one pending sibling per level plus the two children of the node.
+constexpr std::size_t STACK_DEPTH = 64U;
+
+constexpr float INFINITE = std::numeric_limits<float>::infinity();
+
+float squaredDistance(const float* a, const float* b) noexcept
+{
+    float x = a[0] - b[0];
+    float y = a[1] - b[1];
+    float z = a[2] - b[2];
+    return x * x + y * y + z * z;
+}
+
+float boxDistance(const BvhNode& node, const float* p) noexcept
+{
+    float sum = 0.f;
+    for (int k = 0; k < 3; ++k)
+    {
+        float d = std::max({node.lower[k] - p[k], 0.f, p[k] - node.upper[k]});
+        sum += d * d;
+    }
+    return sum;
+}
+
+// Top-down median split along the longest axis of the item centroids. bounds(id, lower, upper) grows the
+// box by one item.
+template<typename Bounds>
+void buildNode(Bvh& bvh, uint32_t index, std::size_t begin, std::size_t end, const std::vector<float>& centroid,
+    std::size_t leafSize, const Bounds& bounds) noexcept
+{
+    BvhNode node{{INFINITE, INFINITE, INFINITE}, 0U, {-INFINITE, -INFINITE, -INFINITE}, 0U};
+    float lower[3] = {INFINITE, INFINITE, INFINITE};
+    float upper[3] = {-INFINITE, -INFINITE, -INFINITE};
+    for (std::size_t i = begin; i < end; ++i)
+    {
+        uint32_t id = bvh.itemStorage[i];
+        bounds(id, node.lower, node.upper);
+        for (int k = 0; k < 3; ++k)
+        {
+            lower[k] = std::min(lower[k], centroid[id * 3U + k]);
+            upper[k] = std::max(upper[k], centroid[id * 3U + k]);
+        }
+    }
+
+    if (end - begin <= leafSize)
+    {
+        node.first = static_cast<uint32_t>(begin);
+        node.count = static_cast<uint32_t>(end - begin);
+        bvh.nodeStorage[index] = node;
+        return;
+    }
+
+    int axis = 0;
+    for (int k = 1; k < 3; ++k)
+    {
+        if (upper[k] - lower[k] > upper[axis] - lower[axis])
+        {
+            axis = k;
+        }
+    }
+    std::size_t middle = begin + (end - begin) / 2U;
+    std::nth_element(bvh.itemStorage.begin() + begin, bvh.itemStorage.begin() + middle, bvh.itemStorage.begin() + end,
+        [&centroid, axis](uint32_t a, uint32_t b) { return centroid[a * 3U + axis] < centroid[b * 3U + axis]; });
+
+    node.first = static_cast<uint32_t>(bvh.nodeStorage.size());
+    bvh.nodeStorage[index] = node;
+    bvh.nodeStorage.resize(bvh.nodeStorage.size() + 2U);
+    buildNode(bvh, node.first, begin, middle, centroid, leafSize, bounds);
+    buildNode(bvh, node.first + 1U, middle, end, centroid, leafSize, bounds);
+}
+
+template<typename Bounds>
+Bvh buildBvh(std::size_t count, const std::vector<float>& centroid, std::size_t leafSize, const Bounds& bounds) noexcept
+{
+    Bvh bvh;
+    if (count == 0U)
+    {
+        return bvh;
+    }
+    bvh.itemStorage.resize(count);
+    for (std::size_t i = 0U; i < count; ++i)
+    {
+        bvh.itemStorage[i] = static_cast<uint32_t>(i);
+    }
+    bvh.nodeStorage.reserve(count / leafSize * 2U + 1U);
+    bvh.nodeStorage.resize(1U);
+    buildNode(bvh, 0U, 0U, count, centroid, leafSize, bounds);
+
+    bvh.node = {bvh.nodeStorage.data(), bvh.nodeStorage.size()};
+    bvh.item = {bvh.itemStorage.data(), bvh.itemStorage.size()};
+    return bvh;
+}
+
+// Nearest-first depth-first walk: visit(leafItem, best) tests one item and may shrink best.
+template<typename Visit>
+void traverse(const Bvh& bvh, const float* p, float& best, const Visit& visit) noexcept
+{
+    if (bvh.node.empty())
+    {
+        return;
+    }
+    uint32_t stack[STACK_DEPTH];
+    std::size_t top = 0U;
+    stack[top++] = 0U;
+    while (top > 0U)
+    {
+        const BvhNode& node = bvh.node[stack[--top]];
+        if (boxDistance(node, p) >= best)
+        {
+            continue;
+        }
+        if (node.count > 0U)
+        {
+            for (uint32_t i = node.first; i < node.first + node.count; ++i)
+            {
+                visit(bvh.item[i], best);
+            }
+            continue;
+        }
+
+        float left = boxDistance(bvh.node[node.first], p);
+        float right = boxDistance(bvh.node[node.first + 1U], p);
+        uint32_t nearer = left <= right ? node.first : node.first + 1U;
+        stack[top++] = nearer == node.first ? node.first + 1U : node.first;
+        stack[top++] = nearer;
+    }
+}
+
+// Closest point of triangle abc to p with its barycentric weights (Ericson, Real-Time Collision Detection 5.1.5).
+void closestOnTriangle(const float* p, const float* a, const float* b, const float* c, float* result, float* weight) noexcept
+{
+    auto set = [weight](float u, float v, float w) { weight[0] = u; weight[1] = v; weight[2] = w; };
+    float ab[3], ac[3], ap[3], bp[3], cp[3];
+    for (int k = 0; k < 3; ++k)
+    {
+        ab[k] = b[k] - a[k];
+        ac[k] = c[k] - a[k];
+        ap[k] = p[k] - a[k];
+        bp[k] = p[k] - b[k];
+        cp[k] = p[k] - c[k];
+    }
+    auto dot = [](const float* x, const float* y) { return x[0] * y[0] + x[1] * y[1] + x[2] * y[2]; };
+
+    float d1 = dot(ab, ap), d2 = dot(ac, ap);
+    float d3 = dot(ab, bp), d4 = dot(ac, bp);
+    float d5 = dot(ab, cp), d6 = dot(ac, cp);
+    float va = d3 * d6 - d5 * d4;
+    float vb = d5 * d2 - d1 * d6;
+    float vc = d1 * d4 - d3 * d2;
+    if (d1 <= 0.f && d2 <= 0.f)
+    {
+        set(1.f, 0.f, 0.f);
+    }
+    else if (d3 >= 0.f && d4 <= d3)
+    {
+        set(0.f, 1.f, 0.f);
+    }
+    else if (vc <= 0.f && d1 >= 0.f && d3 <= 0.f)
+    {
+        float v = d1 / (d1 - d3);
+        set(1.f - v, v, 0.f);
+    }
+    else if (d6 >= 0.f && d5 <= d6)
+    {
+        set(0.f, 0.f, 1.f);
+    }
+    else if (vb <= 0.f && d2 >= 0.f && d6 <= 0.f)
+    {
+        float w = d2 / (d2 - d6);
+        set(1.f - w, 0.f, w);
+    }
+    else if (va <= 0.f && d4 - d3 >= 0.f && d5 - d6 >= 0.f)
+    {
+        float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        set(0.f, 1.f - w, w);
+    }
+    else if (va + vb + vc > 0.f)
+    {
+        float denominator = 1.f / (va + vb + vc);
+        set(1.f - (vb + vc) * denominator, vb * denominator, vc * denominator);
+    }
+    else
+    {
+        set(1.f, 0.f, 0.f);     // degenerate triangle
+    }
+    for (int k = 0; k < 3; ++k)
+    {
+        result[k] = weight[0] * a[k] + weight[1] * b[k] + weight[2] * c[k];
+    }
+}
+
+bool validBvh(const Bvh& bvh, std::size_t itemCount) noexcept
+{
+    if (bvh.node.empty() || bvh.item.size() != itemCount)
+    {
+        return false;
+    }
+    // children always follow their parent, which also rules out cycles, and the levels must fit the
+    // traversal stack
+    std::vector<uint8_t> depth(bvh.node.size(), 0U);
+    for (std::size_t i = 0U; i < bvh.node.size(); ++i)
+    {
+        auto& node = bvh.node[i];
+        bool valid = node.count > 0U ? node.first <= itemCount && node.count <= itemCount - node.first
+                                     : node.first > i && node.first + 1U < bvh.node.size() && depth[i] + 2U < STACK_DEPTH;
+        if (!valid)
+        {
+            return false;
+        }
+        if (node.count == 0U)
+        {
+            for (uint32_t child : {node.first, node.first + 1U})
+            {
+                depth[child] = std::max(depth[child], static_cast<uint8_t>(depth[i] + 1U));
+            }
+        }
+    }
+    return std::all_of(bvh.item.begin(), bvh.item.end(), [itemCount](uint32_t id) { return id < itemCount; });
+}
+
+}
+
+uint32_t ClosestPoint::nearestCorner(Span<const int> faces) const noexcept
+{
+    int corner = weight[0] >= weight[1] ? (weight[0] >= weight[2] ? 0 : 2) : (weight[1] >= weight[2] ? 1 : 2);
+    return static_cast<uint32_t>(faces[face * std::size_t{3U} + corner]);
+}
+
+void SpatialIndex::nearestVertex(const float* query, std::size_t count, NearestVertex* result) const noexcept
+{
+    parallelBlocks(count, blockCount(count, QUERY_GRAIN), [&](std::size_t, std::size_t begin, std::size_t end)
+    {
+        for (std::size_t q = begin; q < end; ++q)
+        {
+            const float* p = query + q * 3U;
+            NearestVertex nearest;
+            float best = INFINITE;
+            traverse(vertexTree, p, best, [&](uint32_t vertex, float& bound)
+            {
+                float distance = squaredDistance(p, point.data() + vertex * std::size_t{3U});
+                if (distance < bound)
+                {
+                    bound = distance;
+                    nearest.vertex = vertex;
+                }
+            });
+            nearest.distance = std::sqrt(best);
+            result[q] = nearest;
+        }
+    });
+}
+
+void SpatialIndex::closestPoint(const float* query, std::size_t count, ClosestPoint* result) const noexcept
+{
+    parallelBlocks(count, blockCount(count, QUERY_GRAIN), [&](std::size_t, std::size_t begin, std::size_t end)
+    {
+        for (std::size_t q = begin; q < end; ++q)
+        {
+            const float* p = query + q * 3U;
+            ClosestPoint closest;
+            float best = INFINITE;
+            traverse(faceTree, p, best, [&](uint32_t id, float& bound)
+            {
+                const int* f = face.data() + id * std::size_t{3U};
+                float candidate[3], weight[3];
+                closestOnTriangle(p, point.data() + f[0] * std::size_t{3U}, point.data() + f[1] * std::size_t{3U},
+                    point.data() + f[2] * std::size_t{3U}, candidate, weight);
+                float distance = squaredDistance(p, candidate);
+                if (distance < bound)
+                {
+                    bound = distance;
+                    closest.face = id;
+                    std::copy(candidate, candidate + 3, closest.point);
+                    std::copy(weight, weight + 3, closest.weight);
+                }
+            });
+            closest.distance = std::sqrt(best);
+            result[q] = closest;
+        }
+    });
+}
+
+std::vector<uint32_t> SpatialIndex::locate(const float* query, std::size_t count, Span<const uint32_t> labelIndex) const noexcept
+{
+    std::vector<ClosestPoint> closest(count);
+    closestPoint(query, count, closest.data());
+
+    std::vector<uint32_t> label(count, 0xFFFFFFFFU);
+    for (std::size_t q = 0U; q < count; ++q)
+    {
+        if (closest[q].face != 0xFFFFFFFFU)
+        {
+            uint32_t vertex = closest[q].nearestCorner(face);
+            label[q] = vertex < labelIndex.size() ? labelIndex[vertex] : 0xFFFFFFFFU;
+        }
+    }
+    return label;
+}
+
+SpatialIndex SpatialIndex::build(Span<const float> point, Span<const int> face) noexcept
+{
+    SpatialIndex index;
+    std::size_t vertexCount = point.size() / 3U;
+    std::size_t faceCount = face.size() / 3U;
+    if (std::any_of(face.begin(), face.begin() + faceCount * 3U, [vertexCount](int v) { return static_cast<std::size_t>(v) >= vertexCount; }))
+    {
+        logError() << "Face refers to a vertex out of range!";
+        return index;
+    }
+    index.point = point;
+    index.face = {face.data(), faceCount * 3U};
+
+    std::vector<float> centroid(point.begin(), point.end());
+    index.vertexTree = buildBvh(vertexCount, centroid, VERTEX_LEAF, [&point](uint32_t id, float* lower, float* upper)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            lower[k] = std::min(lower[k], point[id * 3U + k]);
+            upper[k] = std::max(upper[k], point[id * 3U + k]);
+        }
+    });
+
+    centroid.resize(faceCount * 3U);
+    parallelBlocks(faceCount, blockCount(faceCount, QUERY_GRAIN), [&](std::size_t, std::size_t begin, std::size_t end)
+    {
+        for (std::size_t f = begin; f < end; ++f)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                centroid[f * 3U + k] = (point[face[f * 3U] * 3U + k] + point[face[f * 3U + 1U] * 3U + k] + point[face[f * 3U + 2U] * 3U + k]) / 3.f;
+            }
+        }
+    });
+    index.faceTree = buildBvh(faceCount, centroid, FACE_LEAF, [&point, &face](uint32_t id, float* lower, float* upper)
+    {
+        for (int corner = 0; corner < 3; ++corner)
+        {
+            const float* p = point.data() + face[id * 3U + corner] * std::size_t{3U};
+            for (int k = 0; k < 3; ++k)
+            {
+                lower[k] = std::min(lower[k], p[k]);
+                upper[k] = std::max(upper[k], p[k]);
+            }
+        }
+    });
+    return index;
+}
+
+SpatialIndex SpatialIndex::load(const SurfaceView& view) noexcept
+{
+    SpatialIndex index;
+    index.point = view.point;
+    index.face = {view.face.data(), view.face.size() / 3U * 3U};
+    index.vertexTree.node = view.container.section<BvhNode>(SectionId::VertexBvhNode);
+    index.vertexTree.item = view.container.section<uint32_t>(SectionId::VertexBvhItem);
+    index.faceTree.node = view.container.section<BvhNode>(SectionId::FaceBvhNode);
+    index.faceTree.item = view.container.section<uint32_t>(SectionId::FaceBvhItem);
+    if (validBvh(index.vertexTree, view.point.size() / 3U) && validBvh(index.faceTree, view.face.size() / 3U))
+    {
+        return index;
+    }
+
+    if (!index.vertexTree.node.empty() || !index.faceTree.node.empty())
+    {
+        logError() << "Invalid spatial index sections, rebuild the index!";
+    }
+    return build(view.point, view.face);
+}
+
+void SpatialIndex::addSections(ContainerWriter& writer) const noexcept
+{
+    writer.addSection(SectionId::VertexBvhNode, vertexTree.node.data(), sizeof(BvhNode), vertexTree.node.size());
+    writer.addSection(SectionId::VertexBvhItem, vertexTree.item.data(), sizeof(uint32_t), vertexTree.item.size());
+    writer.addSection(SectionId::FaceBvhNode, faceTree.node.data(), sizeof(BvhNode), faceTree.node.size());
+    writer.addSection(SectionId::FaceBvhItem, faceTree.item.data(), sizeof(uint32_t), faceTree.item.size());
+}
+
+}
\ No newline at end of file
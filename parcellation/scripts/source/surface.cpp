@@ -2,35 +2,97 @@
 
 #include "surface.h"
 
-#include <iostream>
+#include <cstring>
+
+#include "container.h"
+#include "log.h"
 #include <unordered_set>
 
 namespace fsaverage
 {
 
-Surface Surface::load(const std::filesystem::path& path) noexcept
+namespace
+{
+
+bool checkSurfaceDataPath(const std::filesystem::path& path) noexcept
 {
     if (!std::filesystem::exists(path))
     {
-        std::cout << "File " << path << " does not exist!" << std::endl;
-        return {};
+        logError() << "File " << path << " does not exist!";
+        return false;
     }
 
     static const std::unordered_set<std::string> setter{
-        "surface.inflated.data", "surface.orig.data", "surface.pial.data", "surface.white.data"};
+        "surface.inflated.data", "surface.orig.data", "surface.pial.data", "surface.white.data", "surface.sphere.data",
+        "surface.sphere.reg.data"};
     if (!setter.count(path.filename().string()))
     {
-        std::cout << "Only support [surface.[inflated/orig/pial/white].data]!" << std::endl;
+        logError() << "Only support [surface.[inflated/orig/pial/white/sphere/sphere.reg].data]!";
+        return false;
+    }
+    return true;
+}
+
+// layout: [point count][point count * 3 float][face count][face count * 3 int]
+bool openLegacySurface(SurfaceView& view) noexcept
+{
+    auto pointCount = view.file.span<uint32_t>(0U, 1U);
+    if (pointCount.empty())
+    {
+        return false;
+    }
+    std::size_t offset = sizeof(uint32_t);
+    view.point = view.file.span<float>(offset, pointCount[0] * std::size_t{3U});
+    offset += view.point.size() * sizeof(float);
+
+    auto faceCount = view.file.span<uint32_t>(offset, 1U);
+    if (view.point.empty() || faceCount.empty())
+    {
+        return false;
+    }
+    offset += sizeof(uint32_t);
+    view.face = view.file.span<int>(offset, faceCount[0] * std::size_t{3U});
+    return !view.face.empty();
+}
+
+bool openContainerSurface(SurfaceView& view) noexcept
+{
+    view.container = ContainerReader::parse(view.file.data(), view.file.size());
+    if (view.container.empty())
+    {
+        return false;
+    }
+    view.point = view.container.section<float>(SectionId::Point);
+    view.face = view.container.section<int>(SectionId::Face);
+    return view.point.size() % 3U == 0U && view.face.size() % 3U == 0U;
+}
+
+}
+
+Surface Surface::load(const std::filesystem::path& path) noexcept
+{
+    if (!checkSurfaceDataPath(path))
+    {
         return {};
     }
 
     std::ifstream input(path, std::ios::binary);
     if (!input.is_open())
     {
-        std::cout << "Open " << path << "failed!" << std::endl;
+        logError() << "Open " << path << "failed!";
         return {};
     }
 
+    char magic[sizeof(CONTAINER_MAGIC)] = {0};
+    input.read(magic, sizeof(magic));
+    if (ContainerReader::isContainer(reinterpret_cast<const unsigned char*>(magic), input.gcount()))
+    {
+        auto view = SurfaceView::open(path);
+        return {{view.point.begin(), view.point.end()}, {view.face.begin(), view.face.end()}};
+    }
+    input.clear();
+    input.seekg(0);
+
     uint32_t pointCount{};
     input.read(reinterpret_cast<char*>(&pointCount), sizeof(uint32_t));
     Surface surface;
@@ -44,4 +106,27 @@ Surface Surface::load(const std::filesystem::path& path) noexcept
     return surface;
 }
 
+SurfaceView SurfaceView::open(const std::filesystem::path& path) noexcept
+{
+    if (!checkSurfaceDataPath(path))
+    {
+        return {};
+    }
+
+    SurfaceView view;
+    view.file = MappedFile::open(path);
+    if (view.file.empty())
+    {
+        return {};
+    }
+
+    bool valid = ContainerReader::isContainer(view.file.data(), view.file.size()) ? openContainerSurface(view) : openLegacySurface(view);
+    if (!valid || view.empty())
+    {
+        logError() << "Invalid surface data file " << path << "!";
+        return {};
+    }
+    return view;
+}
+
 }
\ No newline at end of file
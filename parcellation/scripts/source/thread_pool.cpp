@@ -0,0 +1,139 @@
+// Author: cute-giggle@outlook.com
+
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace fsaverage
+{
+
+namespace
+{
+// Index of the worker running on this thread, or SIZE_MAX outside the pool.
+thread_local std::size_t currentWorker = SIZE_MAX;
+thread_local const void* currentPool = nullptr;
+}
+
+ThreadPool::ThreadPool(std::size_t threadCount) noexcept
+{
+    threadCount = std::max<std::size_t>(threadCount, 1U);
+    for (std::size_t i = 0U; i < threadCount; ++i)
+    {
+        workers.emplace_back(std::make_unique<Worker>());
+    }
+    for (std::size_t i = 0U; i < threadCount; ++i)
+    {
+        threads.emplace_back(&ThreadPool::run, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() noexcept
+{
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeup.notify_all();
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) noexcept
+{
+    pending.fetch_add(1U);
+    std::size_t target = (currentPool == this ? currentWorker : next.fetch_add(1U) % workers.size());
+    {
+        std::lock_guard<std::mutex> lock(workers[target]->mutex);
+        workers[target]->tasks.emplace_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queued.fetch_add(1U);
+    }
+    wakeup.notify_one();
+}
+
+void ThreadPool::wait() noexcept
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this]() { return pending.load() == 0U; });
+}
+
+bool ThreadPool::pop(std::size_t self, std::function<void()>& task) noexcept
+{
+    {
+        auto& own = *workers[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty())
+        {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    for (std::size_t i = 1U; i < workers.size(); ++i)
+    {
+        auto& victim = *workers[(self + i) % workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::run(std::size_t self) noexcept
+{
+    currentWorker = self;
+    currentPool = this;
+    std::function<void()> task;
+    while (true)
+    {
+        if (pop(self, task))
+        {
+            queued.fetch_sub(1U);
+            task();
+            task = nullptr;
+            if (pending.fetch_sub(1U) == 1U)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                idle.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        wakeup.wait(lock, [this]() { return stopping || queued.load() > 0U; });
+        if (stopping && queued.load() == 0U)
+        {
+            return;
+        }
+    }
+}
+
+std::size_t MemoryBudget::acquire(std::size_t bytes) noexcept
+{
+    bytes = std::min(bytes, capacity);
+    std::unique_lock<std::mutex> lock(mutex);
+    released.wait(lock, [this, bytes]() { return available >= bytes; });
+    available -= bytes;
+    return bytes;
+}
+
+void MemoryBudget::release(std::size_t bytes) noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        available += bytes;
+    }
+    released.notify_all();
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,457 @@
+// Author: cute-giggle@outlook.com
+
+#include "triple_store.h"
+
+#include <algorithm>
+#include <numeric>
+#include <iterator>
+#include <functional>
+
+#include "parallel.h"
+#include "log.h"
+
+namespace fsaverage
+{
+
+namespace
+{
+
+constexpr std::size_t TRIPLE_GRAIN = 1U << 14;
+constexpr std::size_t NAME_GRAIN = 1U << 18;
+
+using Order = uint32_t Triple::*[3];
+
+constexpr Order SPO_ORDER = {&Triple::subject, &Triple::relation, &Triple::object};
+constexpr Order POS_ORDER = {&Triple::relation, &Triple::object, &Triple::subject};
+constexpr Order OSP_ORDER = {&Triple::object, &Triple::subject, &Triple::relation};
+
+// Lexicographic comparison of the first length terms in the given order.
+bool less(const Triple& a, const Triple& b, const Order& order, std::size_t length) noexcept
+{
+    for (std::size_t i = 0U; i < length; ++i)
+    {
+        if (a.*order[i] != b.*order[i])
+        {
+            return a.*order[i] < b.*order[i];
+        }
+    }
+    return false;
+}
+
+Span<const Triple> range(Span<const Triple> sorted, const Order& order, const Triple& key, std::size_t length) noexcept
+{
+    auto compare = [&order, length](const Triple& a, const Triple& b) { return less(a, b, order, length); };
+    auto lower = std::lower_bound(sorted.begin(), sorted.end(), key, compare);
+    auto upper = std::upper_bound(lower, sorted.end(), key, compare);
+    return {lower, static_cast<std::size_t>(upper - lower)};
+}
+
+// Full sort in the order A, B, C; the fixed member pointers let the comparison inline to two integer compares.
+template<uint32_t Triple::* A, uint32_t Triple::* B, uint32_t Triple::* C>
+void sortTriples(std::vector<Triple>& triples) noexcept
+{
+    std::sort(triples.begin(), triples.end(), [](const Triple& a, const Triple& b)
+    {
+        uint64_t x = (uint64_t{a.*A} << 32) | a.*B;
+        uint64_t y = (uint64_t{b.*A} << 32) | b.*B;
+        return x != y ? x < y : a.*C < b.*C;
+    });
+}
+
+// Open addressing map from name to id over one shard of the names, linear probing in a power of two table
+// kept at most half full. The whole hash is stored, so probing compares strings only on a full hash match.
+class NameTable
+{
+public:
+    uint32_t intern(std::string_view name, uint64_t hash, std::vector<std::string_view>& names) noexcept
+    {
+        if ((names.size() + 1U) * 2U > slot.size())
+        {
+            grow();
+        }
+        std::size_t mask = slot.size() - 1U;
+        for (std::size_t i = hash & mask;; i = (i + 1U) & mask)
+        {
+            if (slot[i].id == EMPTY)
+            {
+                slot[i] = {hash, static_cast<uint32_t>(names.size())};
+                names.emplace_back(name);
+                return slot[i].id;
+            }
+            if (slot[i].hash == hash && names[slot[i].id] == name)
+            {
+                return slot[i].id;
+            }
+        }
+    }
+
+private:
+    static constexpr uint32_t EMPTY = 0xFFFFFFFFU;
+
+    struct Slot
+    {
+        uint64_t hash;
+        uint32_t id{EMPTY};
+    };
+
+    void grow() noexcept
+    {
+        std::vector<Slot> old(std::max<std::size_t>(slot.size() * 2U, 1024U));
+        old.swap(slot);
+        std::size_t mask = slot.size() - 1U;
+        for (auto& entry : old)
+        {
+            if (entry.id != EMPTY)
+            {
+                std::size_t i = entry.hash & mask;
+                while (slot[i].id != EMPTY)
+                {
+                    i = (i + 1U) & mask;
+                }
+                slot[i] = entry;
+            }
+        }
+    }
+
+    std::vector<Slot> slot;
+};
+
+bool strictlySorted(Span<const Triple> triples, const Order& order, std::size_t termCount) noexcept
+{
+    for (std::size_t i = 0U; i < triples.size(); ++i)
+    {
+        const Triple& t = triples[i];
+        if (t.subject >= termCount || t.relation >= termCount || t.object >= termCount)
+        {
+            return false;
+        }
+        if (i > 0U && !less(triples[i - 1U], t, order, 3U))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool readName(const JsonValue& value, std::string& name) noexcept
+{
+    if (!value.isString())
+    {
+        return false;
+    }
+    name = value.text;
+    return true;
+}
+
+bool readTripleArray(const JsonValue& array, std::vector<NameTriple>& triples) noexcept
+{
+    for (auto& item : array.item)
+    {
+        // insert_relation_triples.py skips malformed entries the same way
+        if (!item.isArray() || item.item.size() != 3U)
+        {
+            continue;
+        }
+        NameTriple triple;
+        if (readName(item.item[0], triple[0]) && readName(item.item[1], triple[1]) && readName(item.item[2], triple[2]))
+        {
+            triples.emplace_back(std::move(triple));
+        }
+    }
+    return true;
+}
+
+}
+
+bool readTriples(const JsonValue& document, std::vector<NameTriple>& triples) noexcept
+{
+    if (document.isArray())
+    {
+        return readTripleArray(document, triples);
+    }
+    if (!document.isObject())
+    {
+        logError() << "Relation triples must be an array or an object!";
+        return false;
+    }
+
+    for (std::size_t i = 0U; i < document.item.size(); ++i)
+    {
+        auto& first = document.name[i];
+        auto& value = document.item[i];
+        if (value.isArray())
+        {
+            readTripleArray(value, triples);
+            continue;
+        }
+        if (!value.isObject())
+        {
+            logError() << "Unknown relation layout under " << first << "!";
+            return false;
+        }
+        for (std::size_t j = 0U; j < value.item.size(); ++j)
+        {
+            auto& second = value.name[j];
+            const JsonValue* forward = value.item[j].find("forward");
+            const JsonValue* backward = value.item[j].find("backward");
+            if (forward == nullptr || backward == nullptr || !forward->isString() || !backward->isString())
+            {
+                logError() << "Relation between " << first << " and " << second << " lacks forward or backward!";
+                return false;
+            }
+            triples.push_back({first, forward->text, second});
+            triples.push_back({second, backward->text, first});
+        }
+    }
+    return true;
+}
+
+uint32_t TripleStore::find(std::string_view name) const noexcept
+{
+    uint32_t lower = 0U;
+    uint32_t upper = static_cast<uint32_t>(termCount());
+    while (lower < upper)
+    {
+        uint32_t middle = lower + (upper - lower) / 2U;
+        if (term(middle) < name)
+        {
+            lower = middle + 1U;
+        }
+        else
+        {
+            upper = middle;
+        }
+    }
+    return lower < termCount() && term(lower) == name ? lower : ANY;
+}
+
+Span<const Triple> TripleStore::match(uint32_t subject, uint32_t relation, uint32_t object) const noexcept
+{
+    Triple key{subject, relation, object};
+    bool s = subject != ANY;
+    bool p = relation != ANY;
+    bool o = object != ANY;
+    if (s && (p || !o))
+    {
+        return range(spo, SPO_ORDER, key, p ? (o ? 3U : 2U) : 1U);
+    }
+    if (p)
+    {
+        return range(pos, POS_ORDER, key, o ? 2U : 1U);
+    }
+    if (o)
+    {
+        return range(osp, OSP_ORDER, key, s ? 2U : 1U);
+    }
+    return spo;
+}
+
+std::vector<uint32_t> TripleStore::neighborhood(uint32_t entity, std::size_t hops, uint32_t relation, Direction direction) const noexcept
+{
+    if (entity >= termCount())
+    {
+        return {};
+    }
+
+    // reached and frontier stay sorted, so every hop is a sort of the new ids and two linear merges
+    std::vector<uint32_t> reached{entity};
+    std::vector<uint32_t> frontier{entity};
+    std::vector<uint32_t> next;
+    std::vector<uint32_t> merged;
+    for (std::size_t hop = 0U; hop < hops && !frontier.empty(); ++hop)
+    {
+        next.clear();
+        for (uint32_t vertex : frontier)
+        {
+            if (direction != Direction::Incoming)
+            {
+                for (auto& triple : match(vertex, relation, ANY))
+                {
+                    next.emplace_back(triple.object);
+                }
+            }
+            if (direction != Direction::Outgoing)
+            {
+                for (auto& triple : match(ANY, relation, vertex))
+                {
+                    next.emplace_back(triple.subject);
+                }
+            }
+        }
+        std::sort(next.begin(), next.end());
+        next.erase(std::unique(next.begin(), next.end()), next.end());
+
+        frontier.clear();
+        std::set_difference(next.begin(), next.end(), reached.begin(), reached.end(), std::back_inserter(frontier));
+        merged.clear();
+        std::merge(reached.begin(), reached.end(), frontier.begin(), frontier.end(), std::back_inserter(merged));
+        reached.swap(merged);
+    }
+
+    reached.erase(std::lower_bound(reached.begin(), reached.end(), entity));
+    return reached;
+}
+
+TripleStore TripleStore::build(const std::vector<NameTriple>& triples) noexcept
+{
+    // Intern in parallel: hash every name, let shard k own the names whose hash falls into it, and give them
+    // ids in first-seen order inside the shard. Ids are renumbered by name afterwards, so the result does
+    // not depend on the shard count.
+    std::size_t nameCount = triples.size() * 3U;
+    std::vector<uint64_t> hash(nameCount);
+    parallelBlocks(triples.size(), blockCount(triples.size(), TRIPLE_GRAIN), [&](std::size_t, std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            for (std::size_t k = 0U; k < 3U; ++k)
+            {
+                hash[i * 3U + k] = std::hash<std::string_view>{}(triples[i][k]);
+            }
+        }
+    });
+
+    std::size_t shards = blockCount(nameCount, NAME_GRAIN);
+    std::vector<uint32_t> localId(nameCount);
+    std::vector<std::vector<std::string_view>> shardNames(shards);
+    parallelInvoke(shards, [&](std::size_t shard)
+    {
+        NameTable table;
+        for (std::size_t j = 0U; j < nameCount; ++j)
+        {
+            if ((hash[j] >> 32) % shards == shard)
+            {
+                localId[j] = table.intern(triples[j / 3U][j % 3U], hash[j], shardNames[shard]);
+            }
+        }
+    });
+
+    std::vector<std::string_view> names;
+    std::vector<uint32_t> shardOffset(shards);
+    for (std::size_t shard = 0U; shard < shards; ++shard)
+    {
+        shardOffset[shard] = static_cast<uint32_t>(names.size());
+        names.insert(names.end(), shardNames[shard].begin(), shardNames[shard].end());
+    }
+
+    std::vector<uint32_t> order(names.size());
+    std::iota(order.begin(), order.end(), 0U);
+    std::sort(order.begin(), order.end(), [&names](uint32_t a, uint32_t b) { return names[a] < names[b]; });
+    std::vector<uint32_t> rank(names.size());
+    std::size_t poolSize = 0U;
+    for (uint32_t i = 0U; i < order.size(); ++i)
+    {
+        rank[order[i]] = i;
+        poolSize += names[order[i]].size();
+    }
+    if (poolSize > 0xFFFFFFFFU || names.size() >= ANY)
+    {
+        logError() << "Too many or too long names for a triple store!";
+        return {};
+    }
+
+    TripleStore store;
+    store.termOffsetStorage.reserve(names.size() + 1U);
+    store.termPoolStorage.reserve(poolSize);
+    store.termOffsetStorage.emplace_back(0U);
+    for (uint32_t id : order)
+    {
+        store.termPoolStorage.insert(store.termPoolStorage.end(), names[id].begin(), names[id].end());
+        store.termOffsetStorage.emplace_back(static_cast<uint32_t>(store.termPoolStorage.size()));
+    }
+
+    std::vector<Triple> raw(triples.size());
+    parallelBlocks(triples.size(), blockCount(triples.size(), TRIPLE_GRAIN), [&](std::size_t, std::size_t begin, std::size_t end)
+    {
+        uint32_t term[3];
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            for (std::size_t k = 0U; k < 3U; ++k)
+            {
+                std::size_t j = i * 3U + k;
+                term[k] = rank[shardOffset[(hash[j] >> 32) % shards] + localId[j]];
+            }
+            raw[i] = {term[0], term[1], term[2]};
+        }
+    });
+
+    // duplicates are adjacent once sorted, then the other two orders are sorted side by side
+    sortTriples<&Triple::subject, &Triple::relation, &Triple::object>(raw);
+    raw.erase(std::unique(raw.begin(), raw.end(), [](const Triple& a, const Triple& b)
+    {
+        return a.subject == b.subject && a.relation == b.relation && a.object == b.object;
+    }), raw.end());
+    store.posStorage = raw;
+    store.ospStorage = raw;
+    parallelInvoke(2U, [&store](std::size_t order)
+    {
+        if (order == 0U)
+        {
+            sortTriples<&Triple::relation, &Triple::object, &Triple::subject>(store.posStorage);
+        }
+        else
+        {
+            sortTriples<&Triple::object, &Triple::subject, &Triple::relation>(store.ospStorage);
+        }
+    });
+    store.spoStorage = std::move(raw);
+
+    store.termOffset = {store.termOffsetStorage.data(), store.termOffsetStorage.size()};
+    store.termPool = {store.termPoolStorage.data(), store.termPoolStorage.size()};
+    store.spo = {store.spoStorage.data(), store.spoStorage.size()};
+    store.pos = {store.posStorage.data(), store.posStorage.size()};
+    store.osp = {store.ospStorage.data(), store.ospStorage.size()};
+    return store;
+}
+
+TripleStore TripleStore::open(const std::filesystem::path& path) noexcept
+{
+    TripleStore store;
+    store.file = MappedFile::open(path);
+    if (store.file.empty())
+    {
+        return {};
+    }
+    auto container = ContainerReader::parse(store.file.data(), store.file.size());
+    if (container.empty())
+    {
+        return {};
+    }
+
+    store.termOffset = container.section<uint32_t>(SectionId::TermOffset);
+    store.termPool = container.section<char>(SectionId::TermPool);
+    store.spo = container.section<Triple>(SectionId::TripleSpo);
+    store.pos = container.section<Triple>(SectionId::TriplePos);
+    store.osp = container.section<Triple>(SectionId::TripleOsp);
+
+    // the lookups binary search every array, so check once that names and triples are really sorted
+    bool valid = !store.termOffset.empty() && store.termOffset[0] == 0U && store.termOffset.size() <= ANY
+        && store.termOffset[store.termOffset.size() - 1U] == store.termPool.size();
+    for (std::size_t i = 1U; valid && i < store.termOffset.size(); ++i)
+    {
+        valid = store.termOffset[i - 1U] <= store.termOffset[i]
+            && (i == 1U || store.term(static_cast<uint32_t>(i - 2U)) < store.term(static_cast<uint32_t>(i - 1U)));
+    }
+    valid = valid && store.pos.size() == store.spo.size() && store.osp.size() == store.spo.size()
+        && strictlySorted(store.spo, SPO_ORDER, store.termCount())
+        && strictlySorted(store.pos, POS_ORDER, store.termCount())
+        && strictlySorted(store.osp, OSP_ORDER, store.termCount());
+    if (!valid)
+    {
+        logError() << "Invalid triple store " << path << "!";
+        return {};
+    }
+    return store;
+}
+
+bool TripleStore::save(const std::filesystem::path& path) const noexcept
+{
+    ContainerWriter writer;
+    writer.addSection(SectionId::TermOffset, termOffset.data(), sizeof(uint32_t), termOffset.size());
+    writer.addSection(SectionId::TermPool, termPool.data(), sizeof(char), termPool.size());
+    writer.addSection(SectionId::TripleSpo, spo.data(), sizeof(Triple), spo.size());
+    writer.addSection(SectionId::TriplePos, pos.data(), sizeof(Triple), pos.size());
+    writer.addSection(SectionId::TripleOsp, osp.data(), sizeof(Triple), osp.size());
+    return writer.save(path);
+}
+
+}
\ No newline at end of file
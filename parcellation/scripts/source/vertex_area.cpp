@@ -0,0 +1,142 @@
+// Author: cute-giggle@outlook.com
+
+#include "vertex_area.h"
+
+#include <cmath>
+
+#include "parallel.h"
+#include "log.h"
+
+namespace fsaverage
+{
+
+namespace
+{
+constexpr std::size_t FACE_GRAIN = 1U << 15;
+constexpr std::size_t VERTEX_GRAIN = 1U << 15;
+
+// Faces gathered per structure-of-arrays chunk, small enough to stay in L1.
+constexpr std::size_t CHUNK_FACES = 256U;
+}
+
+FaceIncidence FaceIncidence::build(Span<const int> face, std::size_t vertexCount) noexcept
+{
+    FaceIncidence incidence;
+    incidence.offset.assign(vertexCount + 1U, 0U);
+    std::size_t faceCount = face.size() / 3U;
+    for (std::size_t i = 0U; i < faceCount * 3U; ++i)
+    {
+        if (static_cast<std::size_t>(face[i]) < vertexCount)
+        {
+            ++incidence.offset[face[i] + 1U];
+        }
+    }
+    for (std::size_t v = 0U; v < vertexCount; ++v)
+    {
+        incidence.offset[v + 1U] += incidence.offset[v];
+    }
+
+    std::vector<uint32_t> cursor(incidence.offset.begin(), incidence.offset.end() - 1);
+    incidence.face.resize(incidence.offset[vertexCount]);
+    for (std::size_t i = 0U; i < faceCount * 3U; ++i)
+    {
+        if (static_cast<std::size_t>(face[i]) < vertexCount)
+        {
+            incidence.face[cursor[face[i]]++] = static_cast<uint32_t>(i / 3U);
+        }
+    }
+    return incidence;
+}
+
+std::vector<float> computeFaceArea(Span<const float> point, Span<const int> face) noexcept
+{
+    std::size_t faceCount = face.size() / 3U;
+    std::size_t vertexCount = point.size() / 3U;
+    std::vector<float> area(faceCount, 0.f);
+    parallelBlocks(faceCount, blockCount(faceCount, FACE_GRAIN), [&](std::size_t, std::size_t begin, std::size_t end)
+    {
+        // edge vectors of the chunk in SoA layout, so the cross product loop vectorizes
+        float ux[CHUNK_FACES], uy[CHUNK_FACES], uz[CHUNK_FACES];
+        float vx[CHUNK_FACES], vy[CHUNK_FACES], vz[CHUNK_FACES];
+        for (std::size_t chunk = begin; chunk < end; chunk += CHUNK_FACES)
+        {
+            std::size_t count = std::min(CHUNK_FACES, end - chunk);
+            for (std::size_t i = 0U; i < count; ++i)
+            {
+                const int* f = face.data() + (chunk + i) * 3U;
+                if (static_cast<std::size_t>(f[0]) >= vertexCount || static_cast<std::size_t>(f[1]) >= vertexCount
+                    || static_cast<std::size_t>(f[2]) >= vertexCount)
+                {
+                    ux[i] = uy[i] = uz[i] = vx[i] = vy[i] = vz[i] = 0.f;
+                    continue;
+                }
+                const float* a = point.data() + f[0] * 3U;
+                const float* b = point.data() + f[1] * 3U;
+                const float* c = point.data() + f[2] * 3U;
+                ux[i] = b[0] - a[0];
+                uy[i] = b[1] - a[1];
+                uz[i] = b[2] - a[2];
+                vx[i] = c[0] - a[0];
+                vy[i] = c[1] - a[1];
+                vz[i] = c[2] - a[2];
+            }
+            float* output = area.data() + chunk;
+            for (std::size_t i = 0U; i < count; ++i)
+            {
+                float x = uy[i] * vz[i] - uz[i] * vy[i];
+                float y = uz[i] * vx[i] - ux[i] * vz[i];
+                float z = ux[i] * vy[i] - uy[i] * vx[i];
+                output[i] = 0.5f * std::sqrt(x * x + y * y + z * z);
+            }
+        }
+    });
+    return area;
+}
+
+std::vector<float> computeVertexArea(Span<const float> point, Span<const int> face, const FaceIncidence& incidence) noexcept
+{
+    std::size_t vertexCount = point.size() / 3U;
+    if (incidence.offset.size() != vertexCount + 1U)
+    {
+        logError() << "Face incidence does not match the surface!";
+        return {};
+    }
+
+    auto faceArea = computeFaceArea(point, face);
+    std::vector<float> area(vertexCount, 0.f);
+    parallelBlocks(vertexCount, blockCount(vertexCount, VERTEX_GRAIN), [&](std::size_t, std::size_t begin, std::size_t end)
+    {
+        for (std::size_t v = begin; v < end; ++v)
+        {
+            float sum = 0.f;
+            for (uint32_t i = incidence.offset[v]; i < incidence.offset[v + 1U]; ++i)
+            {
+                sum += faceArea[incidence.face[i]];
+            }
+            area[v] = sum / 3.f;
+        }
+    });
+    return area;
+}
+
+VertexArea VertexArea::load(const SurfaceView& view, const FaceIncidence* incidence) noexcept
+{
+    VertexArea result;
+    result.area = view.container.section<float>(SectionId::VertexArea);
+    if (result.area.size() == view.point.size() / 3U && !result.area.empty())
+    {
+        return result;
+    }
+
+    FaceIncidence built;
+    if (incidence == nullptr)
+    {
+        built = FaceIncidence::build(view.face, view.point.size() / 3U);
+        incidence = &built;
+    }
+    result.storage = computeVertexArea(view.point, view.face, *incidence);
+    result.area = {result.storage.data(), result.storage.size()};
+    return result;
+}
+
+}
\ No newline at end of file
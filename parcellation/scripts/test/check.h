@@ -0,0 +1,59 @@
+// Author: cute-giggle@outlook.com
+
+#ifndef CHECK_HPP
+#define CHECK_HPP
+
+#include <iostream>
+#include <string>
+#include <filesystem>
+
+#include "log.h"
+
+namespace fsaverage
+{
+// Minimal checks for the test programs run by ctest: every failed CHECK is printed, and main returns
+// checkResult(), non-zero when any check failed.
+
+inline int checkFailures = 0;
+
+inline void checkThat(bool passed, const char* condition, const char* file, int line) noexcept
+{
+    if (!passed)
+    {
+        ++checkFailures;
+        std::cerr << file << ":" << line << ": check failed: " << condition << std::endl;
+    }
+}
+
+inline int checkResult() noexcept
+{
+    if (checkFailures != 0)
+    {
+        std::cerr << checkFailures << " checks failed" << std::endl;
+    }
+    return checkFailures == 0 ? 0 : 1;
+}
+
+// A file under the temporary directory, removed when the test ends.
+struct TemporaryFile
+{
+    std::filesystem::path path;
+
+    explicit TemporaryFile(const std::string& name) noexcept
+    {
+        std::error_code error;
+        path = std::filesystem::temp_directory_path(error) / name;
+    }
+
+    ~TemporaryFile() noexcept
+    {
+        std::error_code error;
+        std::filesystem::remove(path, error);
+    }
+};
+
+}
+
+#define CHECK(condition) fsaverage::checkThat(static_cast<bool>(condition), #condition, __FILE__, __LINE__)
+
+#endif
\ No newline at end of file
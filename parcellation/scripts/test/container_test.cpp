@@ -0,0 +1,147 @@
+// Author: cute-giggle@outlook.com
+
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <functional>
+
+#include "container.h"
+#include "check.h"
+
+namespace fsaverage
+{
+// ContainerReader::parse on a valid file and on every kind of malformed header and section table.
+
+namespace
+{
+
+// Container bytes in 8-byte aligned storage, as a mapped file would be.
+struct Bytes
+{
+    std::vector<uint64_t> storage;
+    std::size_t size{};
+
+    unsigned char* data() noexcept
+    {
+        return reinterpret_cast<unsigned char*>(storage.data());
+    }
+
+    ContainerHeader& header() noexcept
+    {
+        return *reinterpret_cast<ContainerHeader*>(data());
+    }
+
+    SectionEntry& entry(std::size_t i) noexcept
+    {
+        return reinterpret_cast<SectionEntry*>(data() + sizeof(ContainerHeader))[i];
+    }
+
+    ContainerReader parse() noexcept
+    {
+        return ContainerReader::parse(data(), size);
+    }
+};
+
+const std::vector<float> point{0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f, 8.f};
+const std::vector<int> face{0, 1, 2};
+const std::vector<uint32_t> empty;
+const std::vector<uint32_t> label{7U, 8U, 9U};
+
+// Point, Face, an empty RegionVertex and LabelIndex, written by ContainerWriter.
+Bytes validContainer() noexcept
+{
+    TemporaryFile file("fsaverage_container_test.data");
+    ContainerWriter writer;
+    writer.addSection(SectionId::Point, point);
+    writer.addSection(SectionId::Face, face);
+    writer.addSection(SectionId::RegionVertex, empty);
+    writer.addSection(SectionId::LabelIndex, label);
+    CHECK(writer.save(file.path));
+
+    std::ifstream input(file.path, std::ios::binary);
+    std::vector<char> content{std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()};
+    Bytes bytes{std::vector<uint64_t>((content.size() + 7U) / 8U), content.size()};
+    std::memcpy(bytes.data(), content.data(), content.size());
+    return bytes;
+}
+
+void testValid() noexcept
+{
+    auto bytes = validContainer();
+    auto reader = bytes.parse();
+    CHECK(!reader.empty());
+    CHECK(reader.sections.size() == 4U);
+
+    auto readPoint = reader.section<float>(SectionId::Point);
+    CHECK(readPoint.size() == point.size() && std::equal(point.begin(), point.end(), readPoint.begin()));
+    auto readLabel = reader.section<uint32_t>(SectionId::LabelIndex);
+    CHECK(readLabel.size() == label.size() && std::equal(label.begin(), label.end(), readLabel.begin()));
+    CHECK(reader.has(SectionId::RegionVertex) && reader.section<uint32_t>(SectionId::RegionVertex).empty());
+
+    // missing sections and other element sizes give empty spans
+    CHECK(!reader.has(SectionId::ColorTable));
+    CHECK(reader.section<uint64_t>(SectionId::Point).empty());
+    CHECK((reinterpret_cast<const unsigned char*>(readPoint.data()) - bytes.data()) % CONTAINER_ALIGNMENT == 0U);
+}
+
+void testRejected() noexcept
+{
+    using Change = std::function<void(Bytes&)>;
+    const std::vector<std::pair<const char*, Change>> cases{
+        {"legacy file", [](Bytes& b) { b.data()[0] = 0U; }},
+        {"shorter than the header", [](Bytes& b) { b.size = sizeof(ContainerHeader) - 1U; }},
+        {"byte order", [](Bytes& b) { b.header().endianMarker = 0x04030201U; }},
+        {"version", [](Bytes& b) { b.header().version = CONTAINER_VERSION + 1U; }},
+        {"truncated", [](Bytes& b) { b.size -= CONTAINER_ALIGNMENT; }},
+        {"file size", [](Bytes& b) { b.header().fileSize += 1U; }},
+        {"section count", [](Bytes& b) { b.header().sectionCount = 1000000U; }},
+        {"element size", [](Bytes& b) { b.entry(0).elementSize = 0U; }},
+        {"alignment", [](Bytes& b) { b.entry(1).offset += 4U; }},
+        {"offset past the end", [](Bytes& b) { b.entry(1).offset = b.size + CONTAINER_ALIGNMENT; }},
+        {"count past the end", [](Bytes& b) { b.entry(3).count = 1000000U; }},
+        {"count overflow", [](Bytes& b) { b.entry(3).count = UINT64_MAX / 2U; }},
+        {"section in the header", [](Bytes& b) { b.entry(1).offset = 0U; }},
+        {"overlapping sections", [](Bytes& b) { b.entry(3).offset = b.entry(0).offset; }},
+        {"section over the next one", [](Bytes& b) { b.entry(0).count = 2U * CONTAINER_ALIGNMENT / sizeof(float); }},
+    };
+
+    for (auto& [name, change] : cases)
+    {
+        auto bytes = validContainer();
+        change(bytes);
+        bool rejected = bytes.parse().empty();
+        CHECK(rejected);
+        if (!rejected)
+        {
+            std::cerr << "    accepted: " << name << std::endl;
+        }
+    }
+
+    // empty sections take no bytes, so they may start at any aligned offset after the table
+    auto bytes = validContainer();
+    bytes.entry(2).offset = bytes.entry(0).offset;
+    CHECK(!bytes.parse().empty());
+
+    auto misaligned = validContainer();
+    std::vector<unsigned char> shifted(1U);
+    shifted.insert(shifted.end(), misaligned.data(), misaligned.data() + misaligned.size);
+    CHECK(ContainerReader::parse(shifted.data() + 1U, misaligned.size).empty());
+}
+
+}
+
+}
+
+int main()
+{
+    using namespace fsaverage;
+
+    // every rejection logs why, which is expected here
+    setLogLevel(LogLevel::Off);
+    testValid();
+    testRejected();
+    return checkResult();
+}
\ No newline at end of file
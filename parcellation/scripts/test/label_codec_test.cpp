@@ -0,0 +1,155 @@
+// Author: cute-giggle@outlook.com
+
+#include <vector>
+#include <random>
+#include <string>
+#include <algorithm>
+
+#include "label_codec.h"
+#include "container.h"
+#include "mapped_file.h"
+#include "BigEndianHelper.h"
+#include "check.h"
+
+namespace fsaverage
+{
+// Round trips of bit-packed and run-length encoded labels, random access against bulk decoding, and the
+// vectorized unpacking (AVX2 where the CPU has it) against the scalar reads of operator[].
+
+namespace
+{
+
+std::vector<uint32_t> randomLabels(std::size_t count, uint32_t regionCount, std::mt19937& random) noexcept
+{
+    std::uniform_int_distribution<uint32_t> label(0U, regionCount - 1U);
+    std::vector<uint32_t> labelIndex(count);
+    std::generate(labelIndex.begin(), labelIndex.end(), [&]() { return label(random); });
+    return labelIndex;
+}
+
+// Runs of random length, as labels follow the vertex order of a mesh.
+std::vector<uint32_t> runLabels(std::size_t count, uint32_t regionCount, std::mt19937& random) noexcept
+{
+    std::uniform_int_distribution<uint32_t> label(0U, regionCount - 1U);
+    std::uniform_int_distribution<std::size_t> length(1U, 300U);
+    std::vector<uint32_t> labelIndex;
+    while (labelIndex.size() < count)
+    {
+        labelIndex.insert(labelIndex.end(), std::min(length(random), count - labelIndex.size()), label(random));
+    }
+    return labelIndex;
+}
+
+void checkDecoding(const CompressedLabels& labels, const std::vector<uint32_t>& labelIndex, std::mt19937& random) noexcept
+{
+    CHECK(labels.size() == labelIndex.size());
+    CHECK(labels.decode() == labelIndex);
+
+    bool randomAccess = true;
+    for (std::size_t i = 0U; i < labelIndex.size(); ++i)
+    {
+        randomAccess = randomAccess && labels[i] == labelIndex[i];
+    }
+    CHECK(randomAccess);
+
+    // ranges of every length around the 8 labels of a vector step, at every alignment
+    std::uniform_int_distribution<std::size_t> start(0U, labelIndex.size() - 1U);
+    for (std::size_t trial = 0U; trial < 200U; ++trial)
+    {
+        std::size_t begin = start(random);
+        std::size_t end = std::min(labelIndex.size(), begin + trial % 40U);
+        std::vector<uint32_t> range(end - begin);
+        labels.decode(begin, end, range.data());
+        CHECK(std::equal(range.begin(), range.end(), labelIndex.begin() + begin));
+    }
+}
+
+void testPacked(std::mt19937& random) noexcept
+{
+    for (uint32_t regionCount : {1U, 2U, 3U, 37U, 401U, 70000U})
+    {
+        for (std::size_t count : {1U, 7U, 8U, 9U, 17U, 1000U, 100003U})
+        {
+            auto labelIndex = randomLabels(count, regionCount, random);
+            auto labels = CompressedLabels::pack({labelIndex.data(), labelIndex.size()}, regionCount);
+            CHECK(labels.encoding() == LabelEncoding::Packed);
+            checkDecoding(labels, labelIndex, random);
+        }
+    }
+
+    // full 32-bit labels take the widest lanes
+    std::vector<uint32_t> wide{0xFFFFFFFFU, 0U, 0x80000001U, 12345U, 0xFFFFFFFEU, 1U, 2U, 3U, 0x7FFFFFFFU, 42U, 0xFFFFFFFFU};
+    auto labels = CompressedLabels::pack({wide.data(), wide.size()}, 0U);
+    CHECK(labels.header.bitWidth == 32U);
+    checkDecoding(labels, wide, random);
+}
+
+void testRunLength(std::mt19937& random) noexcept
+{
+    for (std::size_t count : {1U, 2U, 1000U, 100003U})
+    {
+        auto labelIndex = runLabels(count, 36U, random);
+        auto labels = CompressedLabels::runLength({labelIndex.data(), labelIndex.size()});
+        CHECK(labels.encoding() == LabelEncoding::RunLength);
+        CHECK(!labels.run.empty() && labels.run[0].start == 0U);
+        checkDecoding(labels, labelIndex, random);
+    }
+}
+
+void testEncode(std::mt19937& random) noexcept
+{
+    auto runs = runLabels(100003U, 36U, random);
+    auto noise = randomLabels(100003U, 36U, random);
+    for (auto* labelIndex : {&runs, &noise})
+    {
+        Span<const uint32_t> span{labelIndex->data(), labelIndex->size()};
+        auto labels = CompressedLabels::encode(span, 36U);
+        auto packed = CompressedLabels::pack(span, 36U);
+        auto runLength = CompressedLabels::runLength(span);
+        CHECK(labels.byteSize() == std::min(packed.byteSize(), runLength.byteSize()));
+        checkDecoding(labels, *labelIndex, random);
+    }
+    CHECK(CompressedLabels::encode({runs.data(), runs.size()}, 36U).encoding() == LabelEncoding::RunLength);
+    CHECK(CompressedLabels::encode({noise.data(), noise.size()}, 36U).encoding() == LabelEncoding::Packed);
+}
+
+// Labels written to a container and read back point into the mapped file.
+void testContainer(std::mt19937& random) noexcept
+{
+    auto runs = runLabels(50001U, 36U, random);
+    auto noise = randomLabels(50001U, 401U, random);
+    for (auto* labelIndex : {&runs, &noise})
+    {
+        auto labels = CompressedLabels::encode({labelIndex->data(), labelIndex->size()}, 401U);
+        TemporaryFile file("fsaverage_label_codec_test.data");
+        ContainerWriter writer;
+        labels.addSections(writer);
+        CHECK(writer.save(file.path));
+
+        auto mapped = MappedFile::open(file.path);
+        auto container = ContainerReader::parse(mapped.data(), mapped.size());
+        CHECK(!container.empty());
+        auto loaded = CompressedLabels::load(container);
+        CHECK(loaded.encoding() == labels.encoding());
+        CHECK(loaded.wordStorage.empty() && loaded.runStorage.empty());
+        checkDecoding(loaded, *labelIndex, random);
+    }
+}
+
+}
+
+}
+
+int main()
+{
+    using namespace fsaverage;
+
+    std::cout << "Packed label kernel: "
+              << (BigEndianHelper::simdLevel() == BigEndianHelper::SimdLevel::AVX2 ? "AVX2" : "scalar") << std::endl;
+    std::mt19937 random(20240601U);
+    testPacked(random);
+    testRunLength(random);
+    testEncode(random);
+    testContainer(random);
+    return checkResult();
+}
\ No newline at end of file
@@ -0,0 +1,115 @@
+// Author: cute-giggle@outlook.com
+
+#include <vector>
+#include <random>
+#include <string>
+#include <set>
+#include <tuple>
+#include <algorithm>
+
+#include "triple_store.h"
+#include "check.h"
+
+namespace fsaverage
+{
+// TripleStore::match for every pattern of bound and free terms against a brute-force filter over the
+// distinct triples, on a store built in memory and on the same store read back from disk.
+
+namespace
+{
+
+using IdTriple = std::tuple<uint32_t, uint32_t, uint32_t>;
+
+std::vector<NameTriple> randomTriples(std::mt19937& random) noexcept
+{
+    std::uniform_int_distribution<int> entity(0, 19);
+    std::uniform_int_distribution<int> relation(0, 3);
+    std::vector<NameTriple> triples;
+    for (std::size_t i = 0U; i < 400U; ++i)
+    {
+        // duplicates are likely and stored once
+        triples.emplace_back(NameTriple{"Region " + std::to_string(entity(random)), "relation " + std::to_string(relation(random)),
+            "Region " + std::to_string(entity(random))});
+    }
+    return triples;
+}
+
+std::set<IdTriple> expectedMatch(const std::set<IdTriple>& all, uint32_t subject, uint32_t relation, uint32_t object) noexcept
+{
+    std::set<IdTriple> result;
+    for (auto& [s, p, o] : all)
+    {
+        if ((subject == TripleStore::ANY || s == subject) && (relation == TripleStore::ANY || p == relation)
+            && (object == TripleStore::ANY || o == object))
+        {
+            result.emplace(s, p, o);
+        }
+    }
+    return result;
+}
+
+void checkStore(const TripleStore& store, const std::vector<NameTriple>& triples) noexcept
+{
+    std::set<IdTriple> all;
+    bool found = true;
+    for (auto& [s, p, o] : triples)
+    {
+        uint32_t subject = store.find(s);
+        uint32_t relation = store.find(p);
+        uint32_t object = store.find(o);
+        found = found && subject != TripleStore::ANY && relation != TripleStore::ANY && object != TripleStore::ANY
+            && store.term(subject) == s && store.term(relation) == p && store.term(object) == o;
+        all.emplace(subject, relation, object);
+    }
+    CHECK(found);
+    CHECK(store.size() == all.size());
+    CHECK(store.find("Not a region") == TripleStore::ANY);
+
+    // every term in every position, so bound terms that never occur there are covered as well
+    std::vector<uint32_t> choice{TripleStore::ANY};
+    for (uint32_t id = 0U; id < store.termCount(); ++id)
+    {
+        choice.emplace_back(id);
+    }
+    std::size_t mismatched = 0U;
+    for (uint32_t subject : choice)
+    {
+        for (uint32_t relation : choice)
+        {
+            for (uint32_t object : choice)
+            {
+                auto range = store.match(subject, relation, object);
+                std::set<IdTriple> actual;
+                for (auto& triple : range)
+                {
+                    actual.emplace(triple.subject, triple.relation, triple.object);
+                }
+                bool same = actual.size() == range.size() && actual == expectedMatch(all, subject, relation, object);
+                mismatched += same ? 0U : 1U;
+            }
+        }
+    }
+    CHECK(mismatched == 0U);
+}
+
+}
+
+}
+
+int main()
+{
+    using namespace fsaverage;
+
+    std::mt19937 random(20240601U);
+    auto triples = randomTriples(random);
+    auto store = TripleStore::build(triples);
+    CHECK(!store.empty());
+    checkStore(store, triples);
+
+    TemporaryFile file("fsaverage_triple_store_test.data");
+    CHECK(store.save(file.path));
+    auto opened = TripleStore::open(file.path);
+    CHECK(!opened.empty() && opened.spoStorage.empty());
+    checkStore(opened, triples);
+    return checkResult();
+}
\ No newline at end of file